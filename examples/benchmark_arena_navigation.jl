@@ -0,0 +1,92 @@
+"""
+=== HepMC3.jl Arena Allocation Benchmark ===
+
+Times the operations of test/test_navigation.jl ("Native Flat Traversal",
+"Event Graph Queries", "Arena-allocated Events") on events whose particles
+and vertices are separate heap allocations and on the same events built in
+an arena (`build_event(...; arena=true)`, `compact_event!`), together with
+building and freeing the events.
+
+Run with `julia --project examples/benchmark_arena_navigation.jl [n_events]
+[n_particles]`. Each timing is the fastest of several passes over all events;
+the heap events are built first, so the arena events do not profit from a
+warmer allocator.
+"""
+
+using HepMC3
+
+# Beams 1 and 2 meet at vertex 1; vertex k > 1 is the decay of particle k + 1,
+# and every vertex has two outgoing particles, so the record is a binary
+# cascade of n_vertices vertices
+function cascade_columns(n_vertices)
+    n = 2 + 2 * n_vertices
+    production = [i <= 2 ? 0 : (i - 3) ÷ 2 + 1 for i in 1:n]
+    end_vertex = [i <= 2 ? 1 : (2 <= i - 1 <= n_vertices ? i - 1 : 0) for i in 1:n]
+    status = [i <= 2 ? 4 : (end_vertex[i] > 0 ? 2 : 1) for i in 1:n]
+    particles = (px = [0.1 * i for i in 1:n], py = [-0.05 * i for i in 1:n], pz = [10.0 + i for i in 1:n],
+                 e = [20.0 + 2i for i in 1:n], pdg = [i <= 2 ? 2212 : 211 for i in 1:n], status = status)
+    return particles, (production = production, end_vertex = end_vertex)
+end
+
+function best_time(f, passes)
+    f()   # compile
+    return minimum(@elapsed(f()) for _ in 1:passes)
+end
+
+function navigate(events, n)
+    total = 0
+    for event in events
+        total += length(traverse_decay_chain_flat(get_particle_at(event, 1)).ids)
+        total += length(find_particle_ancestry_flat(get_particle_at(event, n)).ids)
+        total += length(get_decay_products(get_particle_at(event, 3)))
+        total += length(get_parent_particles(get_particle_at(event, n)))
+    end
+    return total
+end
+
+function query(events, n)
+    total = 0
+    for event in events
+        q = event_graph_query(event)
+        total += length(descendants(q, 3)) + length(ancestors(q, n)) + is_ancestor(q, 1, n)
+        close(q)
+    end
+    return total
+end
+
+function run_benchmark(n_events, n_particles; passes=5)
+    particles, links = cascade_columns((n_particles - 2) ÷ 2)
+    n = length(particles.px)
+    build(arena) = [build_event(particles, (n - 2) ÷ 2; links..., arena) for _ in 1:n_events]
+
+    println("$n_events events of $n particles, fastest of $passes passes")
+    results = Dict{Symbol,Vector{Float64}}()
+    for arena in (false, true)
+        times = Float64[]
+        push!(times, best_time(() -> foreach(finalize, build(arena)), passes))
+        events = build(arena)
+        push!(times, best_time(() -> navigate(events, n), passes))
+        push!(times, best_time(() -> query(events, n), passes))
+        push!(times, @elapsed foreach(finalize, events))
+        results[arena ? :arena : :heap] = times
+    end
+
+    # Rebuilding heap events in place, as after reading a file
+    events = build(false)
+    compact = @elapsed foreach(compact_event!, events)
+    @assert navigate(events, n) == navigate(build(false), n)
+    foreach(finalize, events)
+
+    println(rpad("", 28), lpad("heap [ms]", 12), lpad("arena [ms]", 12), lpad("ratio", 8))
+    for (k, label) in enumerate(("build + free", "pointer navigation", "graph queries", "free"))
+        heap, arena = results[:heap][k], results[:arena][k]
+        println(rpad(label, 28), lpad(round(1e3 * heap; digits=3), 12), lpad(round(1e3 * arena; digits=3), 12),
+                lpad(round(heap / arena; digits=2), 8))
+    end
+    println(rpad("compact_event! (all events)", 28), lpad(round(1e3 * compact; digits=3), 12))
+    println("arena bytes now held: $(native_memory().arena_bytes)")
+end
+
+n_events = length(ARGS) >= 1 ? parse(Int, ARGS[1]) : 200
+n_particles = length(ARGS) >= 2 ? parse(Int, ARGS[2]) : 2000
+run_benchmark(n_events, n_particles)
@@ -81,6 +81,25 @@ HepMC3::Writer
 /.*std::vector.*std::pair.*std::shared_ptr.*/
 /.*std::map.*std::shared_ptr.*/
 
+// Mutators of the event record, registered by hand in HepMC3Wrap.cxx so that
+// graph queries on the event notice the change
+void HepMC3::GenParticle::set_pid(int)
+void HepMC3::GenParticle::set_pdg_id(const int &)
+void HepMC3::GenVertex::add_particle_in(HepMC3::GenParticlePtr)
+void HepMC3::GenVertex::add_particle_out(HepMC3::GenParticlePtr)
+void HepMC3::GenVertex::remove_particle_in(HepMC3::GenParticlePtr)
+void HepMC3::GenVertex::remove_particle_out(HepMC3::GenParticlePtr)
+void HepMC3::GenEvent::add_particle(HepMC3::GenParticlePtr)
+void HepMC3::GenEvent::add_vertex(HepMC3::GenVertexPtr)
+void HepMC3::GenEvent::remove_particle(HepMC3::GenParticlePtr)
+void HepMC3::GenEvent::remove_particles(std::vector<HepMC3::GenParticlePtr>)
+void HepMC3::GenEvent::remove_vertex(HepMC3::GenVertexPtr)
+void HepMC3::GenEvent::add_tree(const std::vector<HepMC3::GenParticlePtr> &)
+void HepMC3::GenEvent::clear()
+void HepMC3::GenEvent::set_beam_particles(HepMC3::GenParticlePtr, HepMC3::GenParticlePtr)
+void HepMC3::GenEvent::add_beam_particle(HepMC3::GenParticlePtr)
+void HepMC3::GenEvent::read_data(const HepMC3::GenEventData &)
+
 // Manual wrapper functions - don't let WrapIt wrap these
 void add_manual_hepmc3_methods(jlcxx::Module&)
 void* create_shared_particle(void*, int, int)
@@ -1,5 +1,6 @@
 using CxxWrap
 using HepMC3_jll
+using Zstd_jll
 using WrapIt: wrapit
 
 #---Build the wrapper library----------------------------------------------------------------------
@@ -14,6 +15,7 @@ end
 
 cxxwrap_prefix = CxxWrap.prefix_path()
 hepmc3_prefix = HepMC3_jll.artifact_dir
+zstd_prefix = Zstd_jll.artifact_dir
 julia_prefix = dirname(Sys.BINDIR)
 
 #---Generate the wrapper code----------------------------------------------------------------------
@@ -49,5 +51,6 @@ end
 cd(builddir)
 run(`cmake -DCMAKE_BUILD_TYPE=Release
            -DCMAKE_CXX_STANDARD=17
-           -DCMAKE_PREFIX_PATH=$cxxwrap_prefix\;$hepmc3_prefix  $sourcedir`)
+           -DCMAKE_PREFIX_PATH=$cxxwrap_prefix\;$hepmc3_prefix
+           -DZSTD_ROOT=$zstd_prefix  $sourcedir`)
 run(`cmake --build . --config Release --parallel 8`)
@@ -1,7 +1,31 @@
 #include "HepMC3Wrap.h"
+#include "HepMC3/Data/GenEventData.h"
 #include "jlcxx/jlcxx.hpp"
 #include "jlcxx/functions.hpp"
 
+namespace {
+
+const HepMC3::GenEvent* event_of(const HepMC3::GenEvent& event) { return &event; }
+const HepMC3::GenEvent* event_of(const HepMC3::GenParticle& particle) { return particle.parent_event(); }
+const HepMC3::GenEvent* event_of(const HepMC3::GenVertex& vertex) { return vertex.parent_event(); }
+
+// Register a member function that changes the event record, for references
+// and pointers as the generated wrappers do, and count the change on the
+// event the object belongs to.
+template <class T, class... Args>
+void add_record_mutator(jlcxx::Module& mod, const std::string& name, void (T::*f)(Args...)) {
+    mod.method(name, [f](T& a, Args... args) {
+        (a.*f)(args...);
+        note_event_modified(event_of(a));
+    });
+    mod.method(name, [f](T* a, Args... args) {
+        (a->*f)(args...);
+        note_event_modified(event_of(*a));
+    });
+}
+
+}  // namespace
+
 
 void add_manual_hepmc3_methods(jlcxx::Module& mod) {
     // Existing functions...
@@ -139,6 +163,10 @@ void add_manual_hepmc3_methods(jlcxx::Module& mod) {
     mod.method("get_run_info_tool_version", &get_run_info_tool_version);
     mod.method("get_run_info_tool_description", &get_run_info_tool_description);
 
+    // Bulk run info string export
+    mod.method("run_info_weight_names_table", &run_info_weight_names_table);
+    mod.method("run_info_tools_table", &run_info_tools_table);
+
 
     // Add vertex equality
     mod.method("vertices_equal", &vertices_equal);
@@ -152,6 +180,212 @@ void add_manual_hepmc3_methods(jlcxx::Module& mod) {
     mod.method("delete_events_vector", &delete_events_vector);
     mod.method("get_event_number_shared", &get_event_number_shared);
     mod.method("get_event_weights_shared", &get_event_weights_shared);
+    mod.method("get_event_pointer_shared", &get_event_pointer_shared);
+
+    // Native graph traversal
+    mod.method("traverse_particles", &traverse_particles);
+    mod.method("particle_traversal_size", &particle_traversal_size);
+    mod.method("copy_particle_traversal", &copy_particle_traversal);
+    mod.method("particle_traversal_at", &particle_traversal_at);
+    mod.method("delete_particle_traversal", &delete_particle_traversal);
+
+    // Per-event reachability queries
+    mod.method("create_event_query", &create_event_query);
+    mod.method("create_event_query_shared", &create_event_query_shared);
+    mod.method("delete_event_query", &delete_event_query);
+    mod.method("event_query_particles_size", &event_query_particles_size);
+    mod.method("event_query_is_ancestor", &event_query_is_ancestor);
+    mod.method("event_query_descendants", &event_query_descendants);
+    mod.method("event_query_ancestors", &event_query_ancestors);
+    mod.method("event_query_ancestors_matching", &event_query_ancestors_matching);
+    mod.method("event_query_invalidate", &event_query_invalidate);
+    mod.method("event_query_vertices_size", &event_query_vertices_size);
+    mod.method("event_query_topological_order", &event_query_topological_order);
+    mod.method("event_query_vertex_metadata", &event_query_vertex_metadata);
+    mod.method("event_query_particle_order", &event_query_particle_order);
+
+    // Record slimming
+    mod.method("slim_event", &slim_event);
+
+    // Event fingerprints
+    mod.method("event_fingerprint_words", &event_fingerprint_words);
+    mod.method("events_structurally_equal", &events_structurally_equal);
+
+    // Four-momentum conservation
+    mod.method("check_vertex_momentum_conservation", &check_vertex_momentum_conservation);
+    mod.method("check_momentum_conservation_file", &check_momentum_conservation_file);
+    mod.method("momentum_check_counts", &momentum_check_counts);
+    mod.method("momentum_check_max_residual", &momentum_check_max_residual);
+    mod.method("momentum_check_records_size", &momentum_check_records_size);
+    mod.method("copy_momentum_check_records", &copy_momentum_check_records);
+    mod.method("delete_momentum_check", &delete_momentum_check);
+
+    // Asynchronous writer
+    mod.method("create_async_writer", &create_async_writer);
+    mod.method("async_writer_write_event", &async_writer_write_event);
+    mod.method("async_writer_write_event_shared", &async_writer_write_event_shared);
+    mod.method("async_writer_flush", &async_writer_flush);
+    mod.method("async_writer_close", &async_writer_close);
+    mod.method("async_writer_failed", &async_writer_failed);
+    mod.method("async_writer_error", &async_writer_error);
+    mod.method("async_writer_counts", &async_writer_counts);
+    mod.method("delete_async_writer", &delete_async_writer);
+
+    // Parallel writer
+    mod.method("create_parallel_writer", &create_parallel_writer);
+    mod.method("parallel_writer_write_event", &parallel_writer_write_event);
+    mod.method("parallel_writer_write_event_shared", &parallel_writer_write_event_shared);
+    mod.method("parallel_writer_flush", &parallel_writer_flush);
+    mod.method("parallel_writer_close", &parallel_writer_close);
+    mod.method("parallel_writer_failed", &parallel_writer_failed);
+    mod.method("parallel_writer_error", &parallel_writer_error);
+    mod.method("parallel_writer_counts", &parallel_writer_counts);
+    mod.method("delete_parallel_writer", &delete_parallel_writer);
+
+    // Compressed writers
+    mod.method("create_writer_ascii_compressed", &create_writer_ascii_compressed);
+    mod.method("compressed_writer_error", &compressed_writer_error);
+    mod.method("zstd_compression_available", &zstd_compression_available);
+
+    // Sharded writer
+    mod.method("create_sharded_writer", &create_sharded_writer);
+    mod.method("sharded_writer_write_event", &sharded_writer_write_event);
+    mod.method("sharded_writer_write_event_shared", &sharded_writer_write_event_shared);
+    mod.method("sharded_writer_flush", &sharded_writer_flush);
+    mod.method("sharded_writer_close", &sharded_writer_close);
+    mod.method("sharded_writer_failed", &sharded_writer_failed);
+    mod.method("sharded_writer_error", &sharded_writer_error);
+    mod.method("sharded_writer_shards_size", &sharded_writer_shards_size);
+    mod.method("delete_sharded_writer", &delete_sharded_writer);
+
+    // Raw pass-through
+    mod.method("create_raw_event_reader", &create_raw_event_reader);
+    mod.method("raw_reader_next", &raw_reader_next);
+    mod.method("raw_reader_event_info", &raw_reader_event_info);
+    mod.method("copy_raw_reader_particles", &copy_raw_reader_particles);
+    mod.method("raw_reader_parse_event", &raw_reader_parse_event);
+    mod.method("raw_reader_text", &raw_reader_text);
+    mod.method("delete_raw_event_reader", &delete_raw_event_reader);
+    mod.method("create_raw_event_writer", &create_raw_event_writer);
+    mod.method("raw_writer_write_current", &raw_writer_write_current);
+    mod.method("raw_writer_failed", &raw_writer_failed);
+    mod.method("raw_writer_close", &raw_writer_close);
+    mod.method("delete_raw_event_writer", &delete_raw_event_writer);
+
+    // Event engine
+    mod.method("create_event_batch", &create_event_batch);
+    mod.method("event_batch_add", &event_batch_add);
+    mod.method("event_batch_add_shared", &event_batch_add_shared);
+    mod.method("event_batch_size", &event_batch_size);
+    mod.method("delete_event_batch", &delete_event_batch);
+    mod.method("run_event_engine", &run_event_engine);
+    mod.method("engine_result_failed", &engine_result_failed);
+    mod.method("engine_result_error", &engine_result_error);
+    mod.method("engine_result_events", &engine_result_events);
+    mod.method("engine_result_rows", &engine_result_rows);
+    mod.method("engine_result_columns_size", &engine_result_columns_size);
+    mod.method("engine_result_column_name", &engine_result_column_name);
+    mod.method("copy_engine_result_column", &copy_engine_result_column);
+    mod.method("copy_engine_result_events", &copy_engine_result_events);
+    mod.method("delete_engine_result", &delete_engine_result);
+
+    // Histograms
+    mod.method("create_histogram_set", &create_histogram_set);
+    mod.method("histogram_set_add", &histogram_set_add);
+    mod.method("histogram_set_size", &histogram_set_size);
+    mod.method("delete_histogram_set", &delete_histogram_set);
+    mod.method("engine_result_histograms", &engine_result_histograms);
+    mod.method("histogram_bins_size", &histogram_bins_size);
+    mod.method("histogram_entries", &histogram_entries);
+    mod.method("copy_histogram_bins", &copy_histogram_bins);
+
+    // Event pipeline
+    mod.method("create_event_pipeline", &create_event_pipeline);
+    mod.method("pipeline_running", &pipeline_running);
+    mod.method("pipeline_counts", &pipeline_counts);
+    mod.method("pipeline_finish", &pipeline_finish);
+    mod.method("delete_event_pipeline", &delete_event_pipeline);
+
+    // Event pool
+    mod.method("create_event_pool", &create_event_pool);
+    mod.method("event_pool_counts", &event_pool_counts);
+    mod.method("delete_event_pool", &delete_event_pool);
+    mod.method("event_pool_acquire", &event_pool_acquire);
+    mod.method("release_event_shared", &release_event_shared);
+    mod.method("read_all_events_from_file_pooled", &read_all_events_from_file_pooled);
+    mod.method("reader_read_event_pooled", &reader_read_event_pooled);
+    mod.method("move_event_to_arena", &move_event_to_arena);
+    mod.method("estimate_event_memory", &estimate_event_memory);
+    mod.method("native_memory_counts", &native_memory_counts);
+    mod.method("set_native_gc_limit", &set_native_gc_limit);
+    mod.method("native_gc_requests", &native_gc_requests);
+
+    // Attribute policies
+    mod.method("create_attribute_policy", &create_attribute_policy);
+    mod.method("attribute_policy_add_rule", &attribute_policy_add_rule);
+    mod.method("attribute_policy_counts", &attribute_policy_counts);
+    mod.method("delete_attribute_policy", &delete_attribute_policy);
+    mod.method("apply_attribute_policy", &apply_attribute_policy);
+    mod.method("event_attribute_table_size", &event_attribute_table_size);
+    mod.method("copy_event_attribute_table", &copy_event_attribute_table);
+
+    // Event store
+    mod.method("create_event_store", &create_event_store);
+    mod.method("event_store_add", &event_store_add);
+    mod.method("event_store_read_file", &event_store_read_file);
+    mod.method("event_store_counts", &event_store_counts);
+    mod.method("event_store_materialize", &event_store_materialize);
+    mod.method("event_store_find", &event_store_find);
+    mod.method("delete_event_store", &delete_event_store);
+
+    // Event cache
+    mod.method("create_event_cache", &create_event_cache);
+    mod.method("event_cache_get", &event_cache_get);
+    mod.method("event_cache_counts", &event_cache_counts);
+    mod.method("delete_event_cache", &delete_event_cache);
+
+    // Lorentz transforms
+    mod.method("boost_momentum_columns", &boost_momentum_columns);
+    mod.method("boost_events", &boost_events);
+    mod.method("beam_boost_vectors", &beam_boost_vectors);
+
+    // Momentum and position arrays
+    mod.method("copy_event_momenta", &copy_event_momenta);
+    mod.method("copy_event_positions", &copy_event_positions);
+
+    // Pair kernels
+    mod.method("select_particle_momenta", &select_particle_momenta);
+    mod.method("fill_pair_matrix", &fill_pair_matrix);
+    mod.method("find_particle_pairs", &find_particle_pairs);
+    mod.method("pair_list_size", &pair_list_size);
+    mod.method("copy_pair_list", &copy_pair_list);
+    mod.method("delete_pair_list", &delete_pair_list);
+
+    // Event construction from columns
+    mod.method("build_event_from_columns", &build_event_from_columns);
+
+    // Record mutators, vetoed in the generated wrappers (HepMC3-veto.h)
+    using HepMC3::GenEvent;
+    using HepMC3::GenParticle;
+    using HepMC3::GenParticlePtr;
+    using HepMC3::GenVertex;
+    add_record_mutator<GenParticle, int>(mod, "set_pid", &GenParticle::set_pid);
+    add_record_mutator<GenParticle, const int&>(mod, "set_pdg_id", &GenParticle::set_pdg_id);
+    add_record_mutator<GenVertex, GenParticlePtr>(mod, "add_particle_in", &GenVertex::add_particle_in);
+    add_record_mutator<GenVertex, GenParticlePtr>(mod, "add_particle_out", &GenVertex::add_particle_out);
+    add_record_mutator<GenVertex, GenParticlePtr>(mod, "remove_particle_in", &GenVertex::remove_particle_in);
+    add_record_mutator<GenVertex, GenParticlePtr>(mod, "remove_particle_out", &GenVertex::remove_particle_out);
+    add_record_mutator<GenEvent, GenParticlePtr>(mod, "add_particle", &GenEvent::add_particle);
+    add_record_mutator<GenEvent, HepMC3::GenVertexPtr>(mod, "add_vertex", &GenEvent::add_vertex);
+    add_record_mutator<GenEvent, GenParticlePtr>(mod, "remove_particle", &GenEvent::remove_particle);
+    add_record_mutator<GenEvent, std::vector<GenParticlePtr>>(mod, "remove_particles", &GenEvent::remove_particles);
+    add_record_mutator<GenEvent, HepMC3::GenVertexPtr>(mod, "remove_vertex", &GenEvent::remove_vertex);
+    add_record_mutator<GenEvent, const std::vector<GenParticlePtr>&>(mod, "add_tree", &GenEvent::add_tree);
+    add_record_mutator<GenEvent>(mod, "clear", &GenEvent::clear);
+    add_record_mutator<GenEvent, GenParticlePtr, GenParticlePtr>(mod, "set_beam_particles",
+                                                                 &GenEvent::set_beam_particles);
+    add_record_mutator<GenEvent, GenParticlePtr>(mod, "add_beam_particle", &GenEvent::add_beam_particle);
+    add_record_mutator<GenEvent, const HepMC3::GenEventData&>(mod, "read_data", &GenEvent::read_data);
 
 }
 // No JLCXX_MODULE here - that's handled by the generated code
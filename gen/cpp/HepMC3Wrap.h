@@ -13,10 +13,21 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 // Function to add manual methods to the generated module
 void add_manual_hepmc3_methods(jlcxx::Module& mod);
 
+// Count a change to the particles, vertex links or PDG ids of `event` (may be
+// null), so that graph queries on it rebuild their caches
+// (HepMC3WrapGraph.cpp). Every wrapper that makes such a change calls it.
+void note_event_modified(const HepMC3::GenEvent* event);
+
+// Move `value` into thread-local storage and return its C string, which stays
+// valid until the next call on the same thread. String getters in the
+// extern "C" block return it as void*.
+void* stable_string_result(std::string value);
+
 // Forward declarations for manual wrapper functions
 extern "C" {
     void* create_shared_particle(void* momentum, int pdg_id, int status);
@@ -146,6 +157,10 @@ extern "C" {
     void* get_run_info_tool_version(void* run_info, int index);
     void* get_run_info_tool_description(void* run_info, int index);
 
+    // Bulk run info string export (cached packed offsets + bytes, count in out[0])
+    void* run_info_weight_names_table(void* run_info, int64_t* out);
+    void* run_info_tools_table(void* run_info, int64_t* out);
+
     // Vertex equality and safe navigation functions
     bool vertices_equal(void* v1, void* v2);
     void* get_production_vertex_safe(void* particle_ptr);
@@ -160,6 +175,204 @@ extern "C" {
     void delete_events_vector(void* events_vector);
     int get_event_number_shared(void* event);
     double* get_event_weights_shared(void* event, int* n_weights);
+    void* get_event_pointer_shared(void* event);
+
+    // Native graph traversal (flat breadth-first results)
+    void* traverse_particles(void* particle, int direction, int max_depth);
+    int particle_traversal_size(void* traversal);
+    void copy_particle_traversal(void* traversal, int* ids, int* depths, int* parents);
+    void* particle_traversal_at(void* traversal, int index);
+    void delete_particle_traversal(void* traversal);
+
+    // Per-event reachability queries
+    void* create_event_query(void* event);
+    void* create_event_query_shared(void* event);
+    void delete_event_query(void* query);
+    int event_query_particles_size(void* query);
+    bool event_query_is_ancestor(void* query, int ancestor_id, int descendant_id);
+    int event_query_descendants(void* query, int particle_id, int* out);
+    int event_query_ancestors(void* query, int particle_id, int* out);
+    int event_query_ancestors_matching(void* query, int particle_id, int* pdg_ids, int n_pdg, bool use_abs, int* out);
+    void event_query_invalidate(void* query);
+    int event_query_vertices_size(void* query);
+    void event_query_topological_order(void* query, int* out);
+    void event_query_vertex_metadata(void* query, int* depths, int* flags);
+    void event_query_particle_order(void* query, int* out);
+
+    // Record slimming
+    int slim_event(void* event, unsigned char* keep_mask, int n_mask, int rules, int status_min, int status_max, int* new_ids);
+
+    // Event fingerprints
+    void event_fingerprint_words(void* event, double quantum, uint64_t* out);
+    bool events_structurally_equal(void* a, void* b, double tolerance);
+
+    // Four-momentum conservation
+    int check_vertex_momentum_conservation(void* event, double tolerance, bool relative, int* vertices, double* residuals);
+    void* check_momentum_conservation_file(const char* filename, double tolerance, bool relative, int max_events, int max_records);
+    void momentum_check_counts(void* check, int64_t* out);
+    double momentum_check_max_residual(void* check);
+    int momentum_check_records_size(void* check);
+    void copy_momentum_check_records(void* check, int* event_numbers, int* vertices, double* residuals);
+    void delete_momentum_check(void* check);
+
+    // Asynchronous writer
+    void* create_async_writer(const char* filename, int capacity);
+    bool async_writer_write_event(void* writer, void* event);
+    bool async_writer_write_event_shared(void* writer, void* event);
+    bool async_writer_flush(void* writer);
+    bool async_writer_close(void* writer);
+    bool async_writer_failed(void* writer);
+    void* async_writer_error(void* writer);
+    void async_writer_counts(void* writer, int64_t* out);
+    void delete_async_writer(void* writer);
+
+    // Parallel writer
+    void* create_parallel_writer(const char* filename, int n_threads, int capacity);
+    bool parallel_writer_write_event(void* writer, void* event);
+    bool parallel_writer_write_event_shared(void* writer, void* event);
+    bool parallel_writer_flush(void* writer);
+    bool parallel_writer_close(void* writer);
+    bool parallel_writer_failed(void* writer);
+    void* parallel_writer_error(void* writer);
+    void parallel_writer_counts(void* writer, int64_t* out);
+    void delete_parallel_writer(void* writer);
+
+    // Compressed writers
+    void* create_writer_ascii_compressed(const char* filename, int codec, int level, int n_threads);
+    void* compressed_writer_error(void* writer);
+    bool zstd_compression_available();
+
+    // Sharded writer
+    void* create_sharded_writer(const char* pattern, int mode, int64_t limit, const char* key_attribute,
+                                const char* manifest, int capacity);
+    bool sharded_writer_write_event(void* writer, void* event, const char* key);
+    bool sharded_writer_write_event_shared(void* writer, void* event, const char* key);
+    bool sharded_writer_flush(void* writer);
+    bool sharded_writer_close(void* writer);
+    bool sharded_writer_failed(void* writer);
+    void* sharded_writer_error(void* writer);
+    int sharded_writer_shards_size(void* writer);
+    void delete_sharded_writer(void* writer);
+
+    // Raw pass-through
+    void* create_raw_event_reader(const char* filename);
+    bool raw_reader_next(void* reader);
+    void raw_reader_event_info(void* reader, int* out);
+    void copy_raw_reader_particles(void* reader, int* pid, int* status, int* parent, double* momenta,
+                                   double* mass);
+    bool raw_reader_parse_event(void* reader, void* event);
+    void* raw_reader_text(void* reader);
+    void delete_raw_event_reader(void* reader);
+    void* create_raw_event_writer(const char* filename, void* reader);
+    bool raw_writer_write_current(void* writer);
+    bool raw_writer_failed(void* writer);
+    bool raw_writer_close(void* writer);
+    void delete_raw_event_writer(void* writer);
+
+    // Event engine
+    void* create_event_batch();
+    void event_batch_add(void* batch, void* event);
+    void event_batch_add_shared(void* batch, void* event);
+    int64_t event_batch_size(void* batch);
+    void delete_event_batch(void* batch);
+    void* run_event_engine(const char* filename, void* batch, const char* kernel, int status, int* abs_pdg,
+                           int n_pdg, double pt_min, double abs_eta_max, void* histograms, int n_threads,
+                           int chunk_size, int64_t max_events);
+    bool engine_result_failed(void* result);
+    void* engine_result_error(void* result);
+    int64_t engine_result_events(void* result);
+    int64_t engine_result_rows(void* result);
+    int engine_result_columns_size(void* result);
+    void* engine_result_column_name(void* result, int i);
+    void copy_engine_result_column(void* result, int i, double* out);
+    void copy_engine_result_events(void* result, int64_t* out);
+    void delete_engine_result(void* result);
+
+    // Histograms
+    void* create_histogram_set(int weight_index);
+    void histogram_set_add(void* set, int quantity_x, double* edges_x, int n_x, int quantity_y, double* edges_y,
+                           int n_y);
+    int histogram_set_size(void* set);
+    void delete_histogram_set(void* set);
+    void* engine_result_histograms(void* result);
+    int histogram_bins_size(void* set, int i);
+    int64_t histogram_entries(void* set, int i);
+    void copy_histogram_bins(void* set, int i, double* sumw, double* sumw2);
+
+    // Event pipeline
+    void* create_event_pipeline(void* reader, const char* filename, void* writer, const char* kernel, int status,
+                                int* abs_pdg, int n_pdg, double pt_min, double abs_eta_max, int min_selected,
+                                int max_selected, int filter_threads, int extract_threads, int capacity,
+                                int64_t max_events);
+    bool pipeline_running(void* pipeline);
+    void pipeline_counts(void* pipeline, int64_t* out);
+    void* pipeline_finish(void* pipeline);
+    void delete_event_pipeline(void* pipeline);
+
+    // Event pool
+    void* create_event_pool(int max_idle);
+    void event_pool_counts(void* pool, int64_t* out);
+    void delete_event_pool(void* pool);
+    void* event_pool_acquire(void* pool);
+    void release_event_shared(void* event);
+    void* read_all_events_from_file_pooled(const char* filename, int max_events, void* pool, void* policy);
+    void* reader_read_event_pooled(void* reader, void* pool, void* policy);
+    void move_event_to_arena(void* event);
+    int64_t estimate_event_memory(void* event);
+    void native_memory_counts(int64_t* out);
+    int64_t set_native_gc_limit(int64_t limit);
+    int64_t native_gc_requests();
+
+    // Attribute policies
+    void* create_attribute_policy();
+    void attribute_policy_add_rule(void* policy, const char* pattern, int action);
+    void attribute_policy_counts(void* policy, int64_t* out);
+    void delete_attribute_policy(void* policy);
+    void apply_attribute_policy(void* policy, void* event);
+    void event_attribute_table_size(void* event, int64_t* out);
+    void copy_event_attribute_table(void* event, int* ids, char* buffer, int* offsets);
+
+    // Event store
+    void* create_event_store(bool single_precision);
+    void event_store_add(void* store, void* event);
+    int64_t event_store_read_file(void* store, const char* filename, int64_t max_events, void* policy);
+    void event_store_counts(void* store, int64_t* out);
+    void* event_store_materialize(void* store, int64_t index, bool in_arena);
+    int64_t event_store_find(void* store, int event_number);
+    void delete_event_store(void* store);
+
+    // Event cache
+    void* create_event_cache(const char* filename, void* store, int64_t budget_bytes, const char* scratch);
+    void* event_cache_get(void* cache, int64_t index, bool copy);
+    void event_cache_counts(void* cache, int64_t* out);
+    void delete_event_cache(void* cache);
+
+    // Lorentz transforms
+    void boost_momentum_columns(double* px, double* py, double* pz, double* e, int64_t* offsets, int64_t n_events,
+                                double* beta, int n_threads);
+    void boost_events(void** events, int64_t n_events, double* beta, int n_threads);
+    void beam_boost_vectors(void** events, int64_t n_events, bool partonic, double* beta);
+
+    // Momentum and position arrays
+    void copy_event_momenta(void* event, double* out);
+    void copy_event_positions(void* event, double* out);
+
+    // Pair kernels
+    int select_particle_momenta(void* event, int status, int* abs_pdg, int n_pdg, double pt_min,
+                                double abs_eta_max, int* ids, double* out);
+    void fill_pair_matrix(int quantity, int64_t n, double* px, double* py, double* pz, double* e, int64_t stride,
+                          double* out, int n_threads);
+    void* find_particle_pairs(int quantity, int64_t n, double* px, double* py, double* pz, double* e,
+                              int64_t stride, double low, double high, int n_threads);
+    int64_t pair_list_size(void* list);
+    void copy_pair_list(void* list, int64_t* first, int64_t* second, double* values);
+    void delete_pair_list(void* list);
+
+    // Event construction from columns
+    void build_event_from_columns(void* event, int n_particles, double* px, double* py, double* pz,
+                                  double* e, int* pdg, int* status, double* mass,
+                                  int n_vertices, double* x, double* y, double* z, double* t,
+                                  int* vertex_status, int* production, int* end, bool in_arena);
 
 
 
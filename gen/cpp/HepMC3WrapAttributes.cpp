@@ -0,0 +1,198 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapAttributes.h"
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenCrossSection.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenHeavyIon.h"
+#include "HepMC3/GenPdfInfo.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Attribute policies
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Glob match with `*` (any run of characters) and `?` (one character)
+bool glob_match(const std::string& pattern, const std::string& name) {
+    size_t p = 0, n = 0, star = std::string::npos, resume = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            ++p;
+            ++n;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = n;
+        } else if (star != std::string::npos) {
+            p = star + 1;
+            n = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') ++p;
+    return p == pattern.size();
+}
+
+// Replace the attribute by a T parsed from `text`. The new attribute is added
+// first because some types need their event while parsing (e.g. the number
+// of weights for GenCrossSection); the original is restored on failure.
+template <class T>
+bool convert(GenEvent& event, const std::string& name, int id, const std::string& text,
+             const std::shared_ptr<Attribute>& original) {
+    auto typed = std::make_shared<T>();
+    event.add_attribute(name, typed, id);
+    if (typed->from_string(text)) return true;
+    event.add_attribute(name, original, id);
+    return false;
+}
+
+// Whether `text` is a whole number within the range of long, stored in `value`
+bool is_integer(const std::string& text, long& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtol(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0';
+}
+
+bool is_number(const std::string& text) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+// Typed replacement for an attribute still held as text. The standard event
+// attributes get their own types, other values become IntAttribute (or
+// LongAttribute beyond the range of int) or DoubleAttribute when they are
+// numbers and stay strings otherwise.
+bool parse_attribute(GenEvent& event, const std::string& name, int id, const std::shared_ptr<Attribute>& attribute) {
+    std::string text;
+    if (!attribute->is_parsed()) {
+        text = attribute->unparsed_string();
+    } else if (std::dynamic_pointer_cast<StringAttribute>(attribute)) {
+        attribute->to_string(text);
+    } else {
+        return false;   // already typed
+    }
+
+    if (name == "GenCrossSection") return convert<GenCrossSection>(event, name, id, text, attribute);
+    if (name == "GenPdfInfo") return convert<GenPdfInfo>(event, name, id, text, attribute);
+    if (name == "GenHeavyIon") return convert<GenHeavyIon>(event, name, id, text, attribute);
+    long value = 0;
+    if (is_integer(text, value)) {
+        if (value < INT_MIN || value > INT_MAX) return convert<LongAttribute>(event, name, id, text, attribute);
+        return convert<IntAttribute>(event, name, id, text, attribute);
+    }
+    if (is_number(text)) return convert<DoubleAttribute>(event, name, id, text, attribute);
+    return false;
+}
+
+}  // namespace
+
+void AttributePolicy::add_rule(const std::string& pattern, int action) {
+    if (action < ATTRIBUTE_KEEP || action > ATTRIBUTE_PARSE) throw std::invalid_argument("unknown attribute action");
+    m_rules.emplace_back(pattern, action);
+}
+
+int AttributePolicy::action(const std::string& name) const {
+    for (const auto& rule : m_rules) {
+        if (glob_match(rule.first, name)) return rule.second;
+    }
+    return ATTRIBUTE_KEEP;
+}
+
+void AttributePolicy::apply(GenEvent& event) const {
+    // attributes() returns a copy, so entries can be removed and replaced
+    for (const auto& named : event.attributes()) {
+        const int action = this->action(named.first);
+        for (const auto& entry : named.second) {
+            if (action == ATTRIBUTE_DROP) {
+                event.remove_attribute(named.first, entry.first);
+                ++m_dropped;
+            } else if (action == ATTRIBUTE_PARSE && parse_attribute(event, named.first, entry.first, entry.second)) {
+                ++m_parsed;
+            } else {
+                ++m_kept;
+            }
+        }
+    }
+}
+
+void AttributePolicy::stats(int64_t* out) const {
+    out[0] = m_kept;
+    out[1] = m_dropped;
+    out[2] = m_parsed;
+}
+
+void* create_attribute_policy() {
+    return new AttributePolicy();
+}
+
+// Add a rule; action is one of AttributeAction.
+void attribute_policy_add_rule(void* policy, const char* pattern, int action) {
+    static_cast<AttributePolicy*>(policy)->add_rule(pattern, action);
+}
+
+// kept, dropped, parsed
+void attribute_policy_counts(void* policy, int64_t* out) {
+    static_cast<AttributePolicy*>(policy)->stats(out);
+}
+
+void delete_attribute_policy(void* policy) {
+    delete static_cast<AttributePolicy*>(policy);
+}
+
+void apply_attribute_policy(void* policy, void* event) {
+    static_cast<AttributePolicy*>(policy)->apply(*static_cast<GenEvent*>(event));
+}
+
+// Attribute strings of `event`, for copy_event_attribute_table: out[0] gets
+// the number of entries and out[1] the bytes of all names and values.
+void event_attribute_table_size(void* event, int64_t* out) {
+    int64_t entries = 0, bytes = 0;
+    std::string value;
+    for (const auto& named : static_cast<GenEvent*>(event)->attributes()) {
+        for (const auto& entry : named.second) {
+            value.clear();
+            entry.second->to_string(value);
+            ++entries;
+            bytes += named.first.size() + value.size();
+        }
+    }
+    out[0] = entries;
+    out[1] = bytes;
+}
+
+// Copy every attribute entry as (id, name, value): ids[i] is the particle
+// (> 0), vertex (< 0) or event (0) id, and the strings of entry i are name
+// 2i and value 2i + 1 of a packed buffer with 2 * entries + 1 offsets.
+// Entries are ordered by name, then id.
+void copy_event_attribute_table(void* event, int* ids, char* buffer, int* offsets) {
+    size_t i = 0, s = 0, position = 0;
+    std::string value;
+    auto add_string = [&](const std::string& text) {
+        offsets[s++] = position;
+        text.copy(buffer + position, text.size());
+        position += text.size();
+    };
+    for (const auto& named : static_cast<GenEvent*>(event)->attributes()) {
+        for (const auto& entry : named.second) {
+            value.clear();
+            entry.second->to_string(value);
+            ids[i++] = entry.first;
+            add_string(named.first);
+            add_string(value);
+        }
+    }
+    offsets[s] = position;
+}
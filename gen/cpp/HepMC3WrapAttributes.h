@@ -0,0 +1,40 @@
+#ifndef HEPMC3_WRAP_ATTRIBUTES_H
+#define HEPMC3_WRAP_ATTRIBUTES_H
+
+// Per-name handling of attributes after reading (HepMC3WrapAttributes.cpp).
+
+#include "HepMC3/GenEvent.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum AttributeAction {
+    ATTRIBUTE_KEEP = 0,    // leave as read, parsed on first typed access
+    ATTRIBUTE_DROP = 1,    // remove from the event
+    ATTRIBUTE_PARSE = 2,   // convert to a typed attribute right away
+};
+
+// Rules mapping attribute names to actions. Patterns are globs with `*` and
+// `?`; the first matching rule wins and names no rule matches are kept.
+// apply() may be called from several threads at once.
+class AttributePolicy {
+public:
+    void add_rule(const std::string& pattern, int action);
+
+    int action(const std::string& name) const;
+
+    void apply(HepMC3::GenEvent& event) const;
+
+    // kept, dropped, parsed (attribute entries, over all events)
+    void stats(int64_t* out) const;
+
+private:
+    std::vector<std::pair<std::string, int>> m_rules;
+    mutable std::atomic<int64_t> m_kept{0};
+    mutable std::atomic<int64_t> m_dropped{0};
+    mutable std::atomic<int64_t> m_parsed{0};
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapMemory.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/Data/GenEventData.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Event construction from columns
+// ---------------------------------------------------------------------------
+
+// Replace the content of `event` with `n_particles` particles and `n_vertices`
+// vertices given as columns. The event keeps its number, units and weights.
+//
+// `production` and `end` hold, per particle, the 1-based vertex index that
+// produces or absorbs it, or 0 for none. `mass` may be null; NaN entries
+// leave the generated mass unset. The vertex columns `x`, `y`, `z`, `t` and
+// `vertex_status` may be null for vertices at the origin with status 0.
+//
+// Everything is assembled in one GenEventData and handed to read_data, which
+// reserves and links the whole record at once. With `in_arena`, the record is
+// allocated from one EventArena instead (see read_data_in_arena).
+void build_event_from_columns(void* event, int n_particles, double* px, double* py, double* pz,
+                              double* e, int* pdg, int* status, double* mass,
+                              int n_vertices, double* x, double* y, double* z, double* t,
+                              int* vertex_status, int* production, int* end, bool in_arena) {
+    auto evt = static_cast<GenEvent*>(event);
+    if (n_particles < 0 || n_vertices < 0) throw std::invalid_argument("negative particle or vertex count");
+    for (int i = 0; i < n_particles; ++i) {
+        if (production[i] < 0 || production[i] > n_vertices || end[i] < 0 || end[i] > n_vertices) {
+            throw std::out_of_range("vertex index out of range for particle " + std::to_string(i + 1));
+        }
+    }
+
+    GenEventData data;
+    data.event_number = evt->event_number();
+    data.momentum_unit = evt->momentum_unit();
+    data.length_unit = evt->length_unit();
+    data.weights = evt->weights();
+    data.event_pos = FourVector(0.0, 0.0, 0.0, 0.0);
+
+    data.particles.resize(n_particles);
+    for (int i = 0; i < n_particles; ++i) {
+        GenParticleData& p = data.particles[i];
+        p.pid = pdg[i];
+        p.status = status[i];
+        p.momentum = FourVector(px[i], py[i], pz[i], e[i]);
+        p.is_mass_set = mass && !std::isnan(mass[i]);
+        p.mass = p.is_mass_set ? mass[i] : 0.0;
+    }
+
+    data.vertices.resize(n_vertices);
+    for (int v = 0; v < n_vertices; ++v) {
+        GenVertexData& vd = data.vertices[v];
+        vd.status = vertex_status ? vertex_status[v] : 0;
+        vd.position = x ? FourVector(x[v], y[v], z[v], t[v]) : FourVector(0.0, 0.0, 0.0, 0.0);
+    }
+
+    // Links are (particle id, -vertex id) for incoming and (-vertex id,
+    // particle id) for outgoing particles, in particle order.
+    data.links1.reserve(2 * n_particles);
+    data.links2.reserve(2 * n_particles);
+    for (int i = 0; i < n_particles; ++i) {
+        if (end[i] > 0) {
+            data.links1.push_back(i + 1);
+            data.links2.push_back(-end[i]);
+        }
+        if (production[i] > 0) {
+            data.links1.push_back(-production[i]);
+            data.links2.push_back(i + 1);
+        }
+    }
+
+    if (in_arena) {
+        read_data_in_arena(*evt, data);
+    } else {
+        evt->read_data(data);
+    }
+    note_event_modified(evt);
+    account_native_memory(*evt);
+}
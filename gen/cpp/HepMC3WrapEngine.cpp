@@ -0,0 +1,465 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapEngine.h"
+#include "HepMC3WrapRaw.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/ReaderAscii.h"
+#include "HepMC3/Data/GenEventData.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+bool ParticleSelection::accepts(const GenParticle& particle) const {
+    if (status != 0 && particle.status() != status) return false;
+    if (!abs_pdg.empty() &&
+        std::find(abs_pdg.begin(), abs_pdg.end(), std::abs(particle.pid())) == abs_pdg.end()) {
+        return false;
+    }
+    const FourVector& p = particle.momentum();
+    if (p.perp() < pt_min) return false;
+    if (std::isfinite(abs_eta_max) && (p.perp() == 0.0 || std::abs(p.eta()) > abs_eta_max)) return false;
+    return true;
+}
+
+namespace {
+
+// One row per selected particle.
+class ParticlesKernel : public EventKernel {
+public:
+    explicit ParticlesKernel(const KernelConfig& config) : m_selection(config.selection) {}
+
+    std::vector<std::string> columns() const override {
+        return {"pt", "eta", "phi", "e", "mass", "pdg", "status"};
+    }
+
+    void process(const GenEvent& event, KernelOutput& out) override {
+        for (const auto& particle : event.particles()) {
+            if (!m_selection.accepts(*particle)) continue;
+            const FourVector& p = particle->momentum();
+            const double eta = p.perp() == 0.0 ? 0.0 : p.eta();
+            out.add_row({p.perp(), eta, p.phi(), p.e(), p.m(), double(particle->pid()), double(particle->status())});
+        }
+    }
+
+private:
+    ParticleSelection m_selection;
+};
+
+// One row per event summarising its selected particles.
+class EventsKernel : public EventKernel {
+public:
+    explicit EventsKernel(const KernelConfig& config) : m_selection(config.selection) {}
+
+    std::vector<std::string> columns() const override {
+        return {"event_number", "weight", "n_selected", "ht", "leading_pt"};
+    }
+
+    void process(const GenEvent& event, KernelOutput& out) override {
+        int n = 0;
+        double ht = 0.0, leading = 0.0;
+        for (const auto& particle : event.particles()) {
+            if (!m_selection.accepts(*particle)) continue;
+            const double pt = particle->momentum().perp();
+            ++n;
+            ht += pt;
+            leading = std::max(leading, pt);
+        }
+        const double weight = event.weights().empty() ? 1.0 : event.weights()[0];
+        out.add_row({double(event.event_number()), weight, double(n), ht, leading});
+    }
+
+private:
+    ParticleSelection m_selection;
+};
+
+std::mutex& kernel_registry_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, KernelFactory>& kernel_registry() {
+    static std::map<std::string, KernelFactory> registry{
+        {"particles", [](const KernelConfig& c) { return std::unique_ptr<EventKernel>(new ParticlesKernel(c)); }},
+        {"events", [](const KernelConfig& c) { return std::unique_ptr<EventKernel>(new EventsKernel(c)); }},
+        {"histograms", make_histogram_kernel},
+    };
+    return registry;
+}
+
+}  // namespace
+
+void register_event_kernel(const std::string& name, KernelFactory factory) {
+    std::lock_guard<std::mutex> lock(kernel_registry_mutex());
+    kernel_registry()[name] = std::move(factory);
+}
+
+std::unique_ptr<EventKernel> make_event_kernel(const std::string& name, const KernelConfig& config) {
+    KernelFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(kernel_registry_mutex());
+        auto it = kernel_registry().find(name);
+        if (it == kernel_registry().end()) throw std::invalid_argument("unknown kernel '" + name + "'");
+        factory = it->second;
+    }
+    return factory(config);
+}
+
+// ---------------------------------------------------------------------------
+// Work-stealing thread pool
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Each worker owns a task deque. Workers take their newest task first and,
+// when idle, steal the oldest task of another worker. submit() deals tasks
+// round-robin, so stealing only matters when tasks differ in cost, as
+// events of different multiplicity do.
+class WorkStealingPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+    explicit WorkStealingPool(int n_threads) {
+        for (int i = 0; i < n_threads; ++i) m_queues.emplace_back(new Queue);
+        for (int i = 0; i < n_threads; ++i) m_threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work.notify_all();
+        for (auto& thread : m_threads) thread.join();
+    }
+
+    int size() const { return static_cast<int>(m_queues.size()); }
+
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_queued;
+            ++m_pending;
+        }
+        Queue& queue = *m_queues[m_next++ % m_queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        m_work.notify_one();
+    }
+
+    // Block until fewer than `limit` submitted tasks are unfinished.
+    void wait_below(size_t limit) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&] { return m_pending < limit; });
+    }
+
+    void wait() { wait_below(1); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool try_pop(int worker, Task& task) {
+        const size_t n = m_queues.size();
+        for (size_t k = 0; k < n; ++k) {
+            Queue& queue = *m_queues[(worker + k) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            if (k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            std::lock_guard<std::mutex> count_lock(m_mutex);
+            --m_queued;
+            return true;
+        }
+        return false;
+    }
+
+    void run(int worker) {
+        for (;;) {
+            Task task;
+            if (try_pop(worker, task)) {
+                task(worker);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    --m_pending;
+                }
+                m_done.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work.wait(lock, [&] { return m_stop || m_queued > 0; });
+            if (m_stop && m_queued == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::condition_variable m_done;
+    size_t m_queued = 0;
+    size_t m_pending = 0;
+    size_t m_next = 0;
+    bool m_stop = false;
+};
+
+// ---------------------------------------------------------------------------
+// Event engine
+// ---------------------------------------------------------------------------
+
+struct EventBatch {
+    std::vector<std::shared_ptr<const GenEvent>> events;
+};
+
+// Runs a kernel over the events of a file or batch in chunks of
+// `chunk_size` events. Chunks are processed on the pool in any order and
+// their rows are concatenated in event order. Files are split into raw event
+// text by one thread and parsed by the workers, so parsing scales too.
+class EventEngine {
+public:
+    EventEngine(const std::string& kernel, const KernelConfig& config, int n_threads, int chunk_size)
+        : m_chunk_size(std::max(1, chunk_size)),
+          m_pool(n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency())) {
+        for (int i = 0; i < m_pool.size(); ++i) m_kernels.push_back(make_event_kernel(kernel, config));
+        m_columns = m_kernels[0]->columns().size();
+    }
+
+    void run_file(const std::string& filename, int64_t max_events, EngineResult& result) {
+        RawEventReader reader(filename, false);
+        if (!reader.ok()) throw std::invalid_argument("cannot open " + filename);
+        // Each chunk is parsed after the header and the run info blocks that
+        // precede its first event; blocks inside the chunk stay in place
+        std::string text, header;
+        size_t copied = 0;
+        int64_t first = 0, n = 0;
+        while ((max_events < 0 || n < max_events) && reader.next()) {
+            const size_t before = reader.run_info_before();
+            if (n == first) {
+                header = reader.header() + reader.run_info().substr(0, before);
+            } else {
+                text.append(reader.run_info(), copied, before - copied);
+            }
+            copied = before;
+            text += reader.text();
+            if (++n - first == m_chunk_size) {
+                submit_text(header, std::move(text), first, n - first);
+                text.clear();
+                first = n;
+            }
+            if (m_failed) break;
+        }
+        if (n > first) submit_text(header, std::move(text), first, n - first);
+        finish(n, result);
+    }
+
+    void run_batch(const EventBatch& batch, EngineResult& result) {
+        const int64_t n = batch.events.size();
+        for (int64_t first = 0; first < n && !m_failed; first += m_chunk_size) {
+            const int64_t last = std::min(n, first + m_chunk_size);
+            submit([this, &batch, first, last](int worker, KernelOutput& out) {
+                for (int64_t i = first; i < last; ++i) {
+                    out.current_event = i;
+                    m_kernels[worker]->process(*batch.events[i], out);
+                }
+            });
+        }
+        finish(n, result);
+    }
+
+private:
+    void submit_text(const std::string& header, std::string text, int64_t first, int64_t count) {
+        auto stream = std::make_shared<std::istringstream>(header + text + "HepMC::Asciiv3-END_EVENT_LISTING\n");
+        submit([this, stream, first, count](int worker, KernelOutput& out) {
+            ReaderAscii reader(stream);
+            GenEvent event;
+            out.current_event = first;
+            while (!reader.failed()) {
+                reader.read_event(event);
+                if (reader.failed()) break;
+                m_kernels[worker]->process(event, out);
+                ++out.current_event;
+            }
+            if (out.current_event != first + count) {
+                throw std::runtime_error("cannot parse event " + std::to_string(out.current_event + 1));
+            }
+        });
+    }
+
+    void submit(std::function<void(int, KernelOutput&)> work) {
+        // Bound the chunks in flight so a fast reader does not hold the whole
+        // file in memory.
+        m_pool.wait_below(4 * static_cast<size_t>(m_pool.size()));
+        m_chunks.emplace_back(m_columns);
+        KernelOutput& out = m_chunks.back();
+        m_pool.submit([this, work, &out](int worker) {
+            if (m_failed) return;
+            try {
+                work(worker, out);
+            } catch (const std::exception& e) {
+                fail(e.what());
+            } catch (...) {
+                fail("unknown error in kernel");
+            }
+        });
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        if (!m_failed) m_error = message;
+        m_failed = true;
+    }
+
+    void finish(int64_t n_events, EngineResult& result) {
+        m_pool.wait();
+        if (m_failed) throw std::runtime_error(m_error);
+        for (const auto& chunk : m_chunks) result.output.append(chunk);
+        for (size_t i = 1; i < m_kernels.size(); ++i) m_kernels[0]->merge(*m_kernels[i]);
+        result.names = m_kernels[0]->columns();
+        result.kernel = std::move(m_kernels[0]);
+        result.events = n_events;
+    }
+
+    std::vector<std::unique_ptr<EventKernel>> m_kernels;
+    std::deque<KernelOutput> m_chunks;   // references stay valid as chunks are added
+    size_t m_columns = 0;
+    int64_t m_chunk_size;
+    std::mutex m_error_mutex;
+    std::string m_error;
+    std::atomic<bool> m_failed{false};
+    // Destroyed first, so workers are joined before the state they use goes
+    WorkStealingPool m_pool;
+};
+
+}  // namespace
+
+// Event batches
+
+void* create_event_batch() {
+    return new EventBatch;
+}
+
+// Add a snapshot of `event`; later changes to the event do not affect the batch.
+void event_batch_add(void* batch, void* event) {
+    auto e = static_cast<const GenEvent*>(event);
+    GenEventData data;
+    e->write_data(data);
+    auto copy = std::make_shared<GenEvent>();
+    copy->read_data(data);
+    copy->set_run_info(e->run_info());
+    static_cast<EventBatch*>(batch)->events.push_back(copy);
+}
+
+// Add an event from read_hepmc_file by sharing it, without a copy.
+void event_batch_add_shared(void* batch, void* event) {
+    static_cast<EventBatch*>(batch)->events.push_back(*static_cast<std::shared_ptr<GenEvent>*>(event));
+}
+
+int64_t event_batch_size(void* batch) {
+    return static_cast<EventBatch*>(batch)->events.size();
+}
+
+void delete_event_batch(void* batch) {
+    delete static_cast<EventBatch*>(batch);
+}
+
+// Engine runs
+
+// Run `kernel` over the events of `filename`, or of `batch` when `filename`
+// is empty, on `n_threads` workers (all cores when 0). The selection and
+// `histograms` (a histogram set, may be null) are passed to the kernel:
+// `status` 0 and an empty `abs_pdg` accept all particles. Always returns a
+// result; check engine_result_failed.
+void* run_event_engine(const char* filename, void* batch, const char* kernel, int status, int* abs_pdg,
+                       int n_pdg, double pt_min, double abs_eta_max, void* histograms, int n_threads,
+                       int chunk_size, int64_t max_events) {
+    auto result = new EngineResult;
+    try {
+        KernelConfig config;
+        config.selection.status = status;
+        config.selection.abs_pdg.assign(abs_pdg, abs_pdg + n_pdg);
+        config.selection.pt_min = pt_min;
+        config.selection.abs_eta_max = abs_eta_max;
+        config.histograms = static_cast<const HistogramSet*>(histograms);
+        EventEngine engine(kernel, config, n_threads, chunk_size);
+        if (filename[0] != '\0') {
+            engine.run_file(filename, max_events, *result);
+        } else {
+            engine.run_batch(*static_cast<EventBatch*>(batch), *result);
+        }
+    } catch (const std::exception& e) {
+        result->error = e.what();
+    }
+    return result;
+}
+
+bool engine_result_failed(void* result) {
+    return !static_cast<EngineResult*>(result)->error.empty();
+}
+
+void* engine_result_error(void* result) {
+    return stable_string_result(static_cast<EngineResult*>(result)->error);
+}
+
+int64_t engine_result_events(void* result) {
+    return static_cast<EngineResult*>(result)->events;
+}
+
+int64_t engine_result_rows(void* result) {
+    return static_cast<EngineResult*>(result)->output.rows();
+}
+
+int engine_result_columns_size(void* result) {
+    return static_cast<EngineResult*>(result)->names.size();
+}
+
+// Name of column `i` (0-based).
+void* engine_result_column_name(void* result, int i) {
+    auto r = static_cast<EngineResult*>(result);
+    if (i < 0 || i >= static_cast<int>(r->names.size())) throw std::out_of_range("column index out of range");
+    return stable_string_result(r->names[i]);
+}
+
+void copy_engine_result_column(void* result, int i, double* out) {
+    auto r = static_cast<EngineResult*>(result);
+    if (i < 0 || i >= static_cast<int>(r->names.size())) throw std::out_of_range("column index out of range");
+    std::copy(r->output.columns[i].begin(), r->output.columns[i].end(), out);
+}
+
+// 0-based index of the event behind each row.
+void copy_engine_result_events(void* result, int64_t* out) {
+    auto r = static_cast<EngineResult*>(result);
+    std::copy(r->output.event.begin(), r->output.event.end(), out);
+}
+
+const EventKernel* engine_result_kernel(void* result) {
+    return static_cast<EngineResult*>(result)->kernel.get();
+}
+
+void delete_engine_result(void* result) {
+    delete static_cast<EngineResult*>(result);
+}
@@ -0,0 +1,101 @@
+#ifndef HEPMC3_WRAP_ENGINE_H
+#define HEPMC3_WRAP_ENGINE_H
+
+// Kernel interface of the parallel event engine (HepMC3WrapEngine.cpp).
+// Compiled kernels implement EventKernel and register a factory under a name
+// with register_event_kernel; the engine creates one instance per worker
+// thread, so kernels need no locking.
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Particle cuts shared by the built-in kernels. A status or pdg list of 0 or
+// empty accepts every value.
+struct ParticleSelection {
+    int status = 0;
+    std::vector<int> abs_pdg;
+    double pt_min = 0.0;
+    double abs_eta_max = std::numeric_limits<double>::infinity();
+
+    bool accepts(const HepMC3::GenParticle& particle) const;
+};
+
+class HistogramSet;
+
+struct KernelConfig {
+    ParticleSelection selection;
+    const HistogramSet* histograms = nullptr;   // for the histograms kernel
+};
+
+// Rows produced by a kernel, stored by column. Every row records the
+// 0-based index of the event that produced it.
+class KernelOutput {
+public:
+    explicit KernelOutput(size_t n_columns = 0) : columns(n_columns) {}
+
+    void add_row(std::initializer_list<double> values) {
+        size_t i = 0;
+        for (double value : values) columns[i++].push_back(value);
+        event.push_back(current_event);
+    }
+
+    void append(const KernelOutput& other) {
+        for (size_t i = 0; i < columns.size(); ++i) {
+            columns[i].insert(columns[i].end(), other.columns[i].begin(), other.columns[i].end());
+        }
+        event.insert(event.end(), other.event.begin(), other.event.end());
+    }
+
+    size_t rows() const { return event.size(); }
+
+    std::vector<std::vector<double>> columns;
+    std::vector<int64_t> event;
+    int64_t current_event = 0;
+};
+
+class EventKernel {
+public:
+    virtual ~EventKernel() = default;
+
+    // Names of the columns added by process(); may be empty.
+    virtual std::vector<std::string> columns() const = 0;
+
+    virtual void process(const HepMC3::GenEvent& event, KernelOutput& out) = 0;
+
+    // Fold the state of another worker's instance into this one. Called once
+    // per extra worker after all events are processed.
+    virtual void merge(EventKernel&) {}
+};
+
+// Output of an engine run or pipeline, read back with the engine_result_*
+// functions.
+struct EngineResult {
+    std::vector<std::string> names;
+    KernelOutput output;
+    std::unique_ptr<EventKernel> kernel;   // merged state of all workers
+    int64_t events = 0;
+    std::string error;
+};
+
+using KernelFactory = std::function<std::unique_ptr<EventKernel>(const KernelConfig&)>;
+
+// Register a kernel under `name`, replacing any kernel of that name.
+void register_event_kernel(const std::string& name, KernelFactory factory);
+
+// Create the kernel registered under `name`; throws std::invalid_argument
+// for unknown names.
+std::unique_ptr<EventKernel> make_event_kernel(const std::string& name, const KernelConfig& config);
+
+// Kernel filling the histograms of config.histograms (HepMC3WrapHistograms.cpp).
+std::unique_ptr<EventKernel> make_histogram_kernel(const KernelConfig& config);
+
+// Merged kernel of an engine result handle.
+const EventKernel* engine_result_kernel(void* result);
+
+#endif
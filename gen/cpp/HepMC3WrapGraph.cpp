@@ -0,0 +1,1074 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+
+using namespace HepMC3;
+
+namespace {
+
+// Visited set for graph walks. Objects that belong to `event` are tracked in
+// a flat bitset indexed by their HepMC3 id (particles are 1..N, vertices are
+// -1..-M); anything outside the event falls back to a pointer set, so the
+// walk still terminates on cycles and shared vertices of detached graphs.
+class VisitedSet {
+public:
+    VisitedSet(const GenEvent* event, size_t n_particles, size_t n_vertices)
+        : m_event(event), m_particles(n_particles + 1, false), m_vertices(n_vertices + 1, false) {}
+
+    bool insert(const GenParticle* p) {
+        if (p->parent_event() == m_event && m_event && p->id() > 0 && p->id() < static_cast<int>(m_particles.size())) {
+            if (m_particles[p->id()]) return false;
+            m_particles[p->id()] = true;
+            return true;
+        }
+        return m_other.insert(p).second;
+    }
+
+    bool insert(const GenVertex* v) {
+        if (v->parent_event() == m_event && m_event && v->id() < 0 && -v->id() < static_cast<int>(m_vertices.size())) {
+            if (m_vertices[-v->id()]) return false;
+            m_vertices[-v->id()] = true;
+            return true;
+        }
+        return m_other.insert(v).second;
+    }
+
+private:
+    const GenEvent* m_event;
+    std::vector<bool> m_particles;
+    std::vector<bool> m_vertices;
+    std::unordered_set<const void*> m_other;
+};
+
+VisitedSet make_visited_set(const GenParticlePtr& root) {
+    const GenEvent* event = root->parent_event();
+    if (!event) {
+        return VisitedSet(nullptr, 0, 0);
+    }
+    return VisitedSet(event, event->particles().size(), event->vertices().size());
+}
+
+}  // namespace
+
+// Result of a breadth-first walk from one particle. Entry i was reached at
+// `depths[i]` steps from the start particle through entry `parents[i]`
+// (-1 when reached directly from the start particle).
+struct ParticleTraversal {
+    std::vector<GenParticlePtr> particles;
+    std::vector<int> depths;
+    std::vector<int> parents;
+};
+
+// Iterative breadth-first walk over descendants (direction > 0) or ancestors
+// (direction < 0). Each particle and vertex is expanded at most once, so
+// shared vertices and cycles in the record do not blow up the walk, and every
+// particle is reported at its shortest distance from the start. A negative
+// max_depth means no depth limit.
+void* traverse_particles(void* particle, int direction, int max_depth) {
+    auto root = *static_cast<std::shared_ptr<HepMC3::GenParticle>*>(particle);
+    if (direction == 0) {
+        throw std::invalid_argument("traversal direction must be positive (descendants) or negative (ancestors)");
+    }
+    const bool forward = direction > 0;
+
+    auto* traversal = new ParticleTraversal();
+    VisitedSet visited = make_visited_set(root);
+    visited.insert(root.get());
+
+    // The output arrays double as the BFS queue; -1 stands for the root.
+    for (int cursor = -1; cursor < static_cast<int>(traversal->particles.size()); ++cursor) {
+        GenParticle* current = cursor < 0 ? root.get() : traversal->particles[cursor].get();
+        const int depth = cursor < 0 ? 0 : traversal->depths[cursor];
+        if (max_depth >= 0 && depth >= max_depth) {
+            continue;
+        }
+
+        GenVertexPtr vertex = forward ? current->end_vertex() : current->production_vertex();
+        if (!vertex || !visited.insert(vertex.get())) {
+            continue;
+        }
+
+        const auto& next = forward ? vertex->particles_out() : vertex->particles_in();
+        for (const auto& p : next) {
+            if (visited.insert(p.get())) {
+                traversal->particles.push_back(p);
+                traversal->depths.push_back(depth + 1);
+                traversal->parents.push_back(cursor);
+            }
+        }
+    }
+    return traversal;
+}
+
+int particle_traversal_size(void* traversal) {
+    auto t = static_cast<ParticleTraversal*>(traversal);
+    return t->particles.size();
+}
+
+// Copy the walk into caller-provided arrays of particle_traversal_size()
+// entries. Particles that are not part of an event report id 0.
+void copy_particle_traversal(void* traversal, int* ids, int* depths, int* parents) {
+    auto t = static_cast<ParticleTraversal*>(traversal);
+    for (size_t i = 0; i < t->particles.size(); ++i) {
+        ids[i] = t->particles[i]->id();
+        depths[i] = t->depths[i];
+        parents[i] = t->parents[i];
+    }
+}
+
+void* particle_traversal_at(void* traversal, int index) {
+    auto t = static_cast<ParticleTraversal*>(traversal);
+    if (index < 0 || index >= static_cast<int>(t->particles.size())) {
+        throw std::out_of_range("particle traversal index out of range");
+    }
+    return new std::shared_ptr<HepMC3::GenParticle>(t->particles[index]);
+}
+
+void delete_particle_traversal(void* traversal) {
+    delete static_cast<ParticleTraversal*>(traversal);
+}
+
+// ---------------------------------------------------------------------------
+// Event graph index and reachability queries
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Compact index of one event's particle/vertex graph. Particles and vertices
+// are addressed by dense indices derived from their HepMC3 ids (particle id
+// i -> i - 1, vertex id -j -> j - 1). Vertices are grouped into strongly
+// connected components so that records with cycles still have a well-defined
+// topological order; in an acyclic record every component is one vertex.
+struct EventGraph {
+    int n_particles = 0;
+    int n_vertices = 0;
+    std::vector<int> production;      // per particle: vertex index or -1
+    std::vector<int> end;             // per particle: vertex index or -1
+    std::vector<int> pdg;             // per particle
+    std::vector<int> in_offsets, in_particles;    // CSR of incoming particles per vertex
+    std::vector<int> out_offsets, out_particles;  // CSR of outgoing particles per vertex
+    std::vector<int> child_offsets, children;     // CSR of vertex -> vertex edges
+
+    std::vector<int> component;                   // per vertex
+    std::vector<char> cyclic;                     // per component: has an internal cycle
+    std::vector<int> component_order;             // components in topological order
+    std::vector<int> member_offsets, members;     // CSR of vertices per component
+};
+
+int vertex_index(const GenEvent* event, const ConstGenVertexPtr& v) {
+    // The event's hidden root vertex (id 0) and foreign vertices are not indexed
+    if (!v || v->parent_event() != event || v->id() >= 0) {
+        return -1;
+    }
+    return -v->id() - 1;
+}
+
+// Tarjan's algorithm, iterative. Components are emitted sinks first, so the
+// reverse of the emission order is a topological order of the condensation.
+void find_components(EventGraph& g) {
+    const int n = g.n_vertices;
+    std::vector<int> index(n, -1), low(n, 0), stack, frames, edge_pos;
+    std::vector<char> on_stack(n, 0);
+    g.component.assign(n, -1);
+    int next_index = 0;
+    int n_components = 0;
+    std::vector<int> emitted;
+
+    for (int start = 0; start < n; ++start) {
+        if (index[start] >= 0) continue;
+        frames.push_back(start);
+        edge_pos.push_back(g.child_offsets[start]);
+        index[start] = low[start] = next_index++;
+        stack.push_back(start);
+        on_stack[start] = 1;
+
+        while (!frames.empty()) {
+            const int v = frames.back();
+            int& pos = edge_pos.back();
+            if (pos < g.child_offsets[v + 1]) {
+                const int w = g.children[pos++];
+                if (index[w] < 0) {
+                    index[w] = low[w] = next_index++;
+                    stack.push_back(w);
+                    on_stack[w] = 1;
+                    frames.push_back(w);
+                    edge_pos.push_back(g.child_offsets[w]);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = 0;
+                    g.component[w] = n_components;
+                } while (w != v);
+                emitted.push_back(n_components++);
+            }
+            frames.pop_back();
+            edge_pos.pop_back();
+            if (!frames.empty()) {
+                const int parent = frames.back();
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+
+    g.component_order.assign(emitted.rbegin(), emitted.rend());
+    g.member_offsets.assign(n_components + 1, 0);
+    for (int v = 0; v < n; ++v) g.member_offsets[g.component[v] + 1]++;
+    for (int c = 0; c < n_components; ++c) g.member_offsets[c + 1] += g.member_offsets[c];
+    g.members.resize(n);
+    std::vector<int> fill(g.member_offsets.begin(), g.member_offsets.end() - 1);
+    for (int v = 0; v < n; ++v) g.members[fill[g.component[v]]++] = v;
+
+    g.cyclic.assign(n_components, 0);
+    for (int v = 0; v < n; ++v) {
+        for (int k = g.child_offsets[v]; k < g.child_offsets[v + 1]; ++k) {
+            if (g.component[g.children[k]] == g.component[v]) g.cyclic[g.component[v]] = 1;
+        }
+    }
+}
+
+void build_event_graph(const GenEvent* event, EventGraph& g) {
+    const auto& particles = event->particles();
+    const auto& vertices = event->vertices();
+    g.n_particles = particles.size();
+    g.n_vertices = vertices.size();
+    g.production.assign(g.n_particles, -1);
+    g.end.assign(g.n_particles, -1);
+    g.pdg.resize(g.n_particles);
+    for (int i = 0; i < g.n_particles; ++i) {
+        const auto& p = particles[i];
+        g.production[i] = vertex_index(event, p->production_vertex());
+        g.end[i] = vertex_index(event, p->end_vertex());
+        g.pdg[i] = p->pid();
+    }
+
+    g.in_offsets.assign(g.n_vertices + 1, 0);
+    g.out_offsets.assign(g.n_vertices + 1, 0);
+    g.in_particles.clear();
+    g.out_particles.clear();
+    for (int v = 0; v < g.n_vertices; ++v) {
+        for (const auto& p : vertices[v]->particles_in()) g.in_particles.push_back(p->id() - 1);
+        for (const auto& p : vertices[v]->particles_out()) g.out_particles.push_back(p->id() - 1);
+        g.in_offsets[v + 1] = g.in_particles.size();
+        g.out_offsets[v + 1] = g.out_particles.size();
+    }
+
+    g.child_offsets.assign(g.n_vertices + 1, 0);
+    g.children.clear();
+    for (int v = 0; v < g.n_vertices; ++v) {
+        for (int k = g.out_offsets[v]; k < g.out_offsets[v + 1]; ++k) {
+            const int child = g.end[g.out_particles[k]];
+            if (child >= 0) g.children.push_back(child);
+        }
+        g.child_offsets[v + 1] = g.children.size();
+    }
+
+    find_components(g);
+}
+
+// Reachability between components as one bitset row per component.
+class ComponentClosure {
+public:
+    void build(const EventGraph& g, bool descendants) {
+        const int n = g.cyclic.size();
+        m_words = (n + 63) / 64;
+        m_bits.assign(static_cast<size_t>(n) * m_words, 0);
+
+        // Direct component edges, in the requested direction
+        std::vector<std::vector<int>> next(n);
+        for (int v = 0; v < g.n_vertices; ++v) {
+            for (int k = g.child_offsets[v]; k < g.child_offsets[v + 1]; ++k) {
+                const int a = g.component[v];
+                const int b = g.component[g.children[k]];
+                if (a == b) continue;
+                if (descendants) next[a].push_back(b); else next[b].push_back(a);
+            }
+        }
+
+        // Visit components so that every successor row is complete first
+        for (int i = 0; i < n; ++i) {
+            const int c = descendants ? g.component_order[n - 1 - i] : g.component_order[i];
+            uint64_t* row = &m_bits[static_cast<size_t>(c) * m_words];
+            if (g.cyclic[c]) set(row, c);
+            for (int d : next[c]) {
+                const uint64_t* other = &m_bits[static_cast<size_t>(d) * m_words];
+                for (int w = 0; w < m_words; ++w) row[w] |= other[w];
+                set(row, d);
+            }
+        }
+    }
+
+    bool test(int from, int to) const {
+        return (m_bits[static_cast<size_t>(from) * m_words + to / 64] >> (to % 64)) & 1u;
+    }
+
+    template <class F>
+    void for_each(int from, F&& f) const {
+        const uint64_t* row = &m_bits[static_cast<size_t>(from) * m_words];
+        for (int w = 0; w < m_words; ++w) {
+            uint64_t bits = row[w];
+            while (bits) {
+                const int bit = __builtin_ctzll(bits);
+                f(w * 64 + bit);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    static void set(uint64_t* row, int c) { row[c / 64] |= uint64_t(1) << (c % 64); }
+
+    int m_words = 0;
+    std::vector<uint64_t> m_bits;
+};
+
+}  // namespace
+
+namespace {
+
+// Modification counters of the events that have a live EventGraphQuery,
+// bumped by note_event_modified. An entry lives as long as a query holds its
+// event, so an address never maps to a different event while it is watched.
+struct WatchedEvent {
+    int queries = 0;
+    std::shared_ptr<std::atomic<uint64_t>> version;
+};
+
+struct EventVersions {
+    std::mutex mutex;
+    std::unordered_map<const GenEvent*, WatchedEvent> events;
+    std::atomic<int> size{0};
+};
+
+EventVersions& event_versions() {
+    static EventVersions versions;
+    return versions;
+}
+
+std::shared_ptr<std::atomic<uint64_t>> watch_event(const GenEvent* event) {
+    EventVersions& versions = event_versions();
+    std::lock_guard<std::mutex> lock(versions.mutex);
+    WatchedEvent& watched = versions.events[event];
+    if (watched.queries++ == 0) {
+        watched.version = std::make_shared<std::atomic<uint64_t>>(0);
+        versions.size.fetch_add(1, std::memory_order_release);
+    }
+    return watched.version;
+}
+
+void unwatch_event(const GenEvent* event) {
+    EventVersions& versions = event_versions();
+    std::lock_guard<std::mutex> lock(versions.mutex);
+    auto it = versions.events.find(event);
+    if (it == versions.events.end() || --it->second.queries > 0) return;
+    versions.events.erase(it);
+    versions.size.fetch_sub(1, std::memory_order_release);
+}
+
+// Graph-level metadata derived from the topological order.
+struct EventTopology {
+    std::vector<int> vertex_order;     // vertex indices, parents before children
+    std::vector<int> vertex_depth;     // per vertex: longest vertex path from a root vertex
+    std::vector<char> vertex_flags;    // per vertex: TOPOLOGY_* bits
+    std::vector<int> particle_order;   // particle indices, ordered by production vertex
+};
+
+enum TopologyFlags { TOPOLOGY_ROOT = 1, TOPOLOGY_LEAF = 2, TOPOLOGY_CYCLIC = 4 };
+
+void build_event_topology(const EventGraph& g, EventTopology& t) {
+    const int n_components = g.cyclic.size();
+    t.vertex_order.clear();
+    t.vertex_order.reserve(g.n_vertices);
+    for (int c : g.component_order) {
+        for (int k = g.member_offsets[c]; k < g.member_offsets[c + 1]; ++k) t.vertex_order.push_back(g.members[k]);
+    }
+
+    // Generation depth on the condensation: every component sits one level
+    // below its deepest parent component.
+    std::vector<int> component_depth(n_components, 0);
+    t.vertex_flags.assign(g.n_vertices, TOPOLOGY_ROOT | TOPOLOGY_LEAF);
+    for (int v : t.vertex_order) {
+        const int c = g.component[v];
+        if (g.cyclic[c]) t.vertex_flags[v] |= TOPOLOGY_CYCLIC;
+        for (int k = g.child_offsets[v]; k < g.child_offsets[v + 1]; ++k) {
+            const int w = g.children[k];
+            t.vertex_flags[v] &= ~TOPOLOGY_LEAF;
+            t.vertex_flags[w] &= ~TOPOLOGY_ROOT;
+            const int d = g.component[w];
+            if (d != c) component_depth[d] = std::max(component_depth[d], component_depth[c] + 1);
+        }
+    }
+    t.vertex_depth.resize(g.n_vertices);
+    for (int v = 0; v < g.n_vertices; ++v) t.vertex_depth[v] = component_depth[g.component[v]];
+
+    t.particle_order.clear();
+    t.particle_order.reserve(g.n_particles);
+    for (int i = 0; i < g.n_particles; ++i) {
+        if (g.production[i] < 0) t.particle_order.push_back(i);
+    }
+    for (int v : t.vertex_order) {
+        for (int k = g.out_offsets[v]; k < g.out_offsets[v + 1]; ++k) t.particle_order.push_back(g.out_particles[k]);
+    }
+}
+
+}  // namespace
+
+// Per-event query object. The graph index is built on the first query and the
+// closures and topology only when a query needs them. Everything is dropped
+// and rebuilt lazily once the event's modification counter has moved on.
+// `event` keeps an event read into a shared handle alive; for an event owned
+// by Julia it does not own the event, and the Julia object holds on to it.
+struct EventGraphQuery {
+    std::shared_ptr<const GenEvent> event;
+    std::shared_ptr<std::atomic<uint64_t>> version;
+    uint64_t built_version = 0;
+    bool built = false;
+    EventGraph graph;
+    ComponentClosure descendants;
+    ComponentClosure ancestors;
+    bool has_descendants = false;
+    bool has_ancestors = false;
+    std::unordered_map<int, std::vector<int>> by_pdg;
+    bool has_pdg_index = false;
+    EventTopology topology;
+    bool has_topology = false;
+};
+
+namespace {
+
+EventGraph& query_graph(EventGraphQuery* q) {
+    const uint64_t version = q->version->load(std::memory_order_acquire);
+    if (!q->built || version != q->built_version) {
+        build_event_graph(q->event.get(), q->graph);
+        q->built_version = version;
+        q->built = true;
+        q->has_descendants = false;
+        q->has_ancestors = false;
+        q->by_pdg.clear();
+        q->has_pdg_index = false;
+        q->has_topology = false;
+    }
+    return q->graph;
+}
+
+const EventTopology& query_topology(EventGraphQuery* q) {
+    const EventGraph& g = query_graph(q);
+    if (!q->has_topology) {
+        build_event_topology(g, q->topology);
+        q->has_topology = true;
+    }
+    return q->topology;
+}
+
+const ComponentClosure& query_closure(EventGraphQuery* q, bool descendants) {
+    const EventGraph& g = query_graph(q);
+    if (descendants && !q->has_descendants) {
+        q->descendants.build(g, true);
+        q->has_descendants = true;
+    }
+    if (!descendants && !q->has_ancestors) {
+        q->ancestors.build(g, false);
+        q->has_ancestors = true;
+    }
+    return descendants ? q->descendants : q->ancestors;
+}
+
+int checked_particle_index(const EventGraph& g, int particle_id) {
+    if (particle_id < 1 || particle_id > g.n_particles) {
+        throw std::out_of_range("particle id out of range for this event");
+    }
+    return particle_id - 1;
+}
+
+// Whether vertex `to` is reachable from vertex `from` (a vertex reaches itself).
+bool vertex_reaches(EventGraphQuery* q, int from, int to) {
+    if (from == to) return true;
+    const EventGraph& g = q->graph;
+    const int a = g.component[from];
+    const int b = g.component[to];
+    if (a == b) return g.cyclic[a];
+    return query_closure(q, true).test(a, b);
+}
+
+// Call f(v) for every vertex reachable from `start` in the requested
+// direction, including `start` itself.
+template <class F>
+void for_each_reachable_vertex(EventGraphQuery* q, int start, bool descendants, F&& f) {
+    const EventGraph& g = q->graph;
+    const ComponentClosure& closure = query_closure(q, descendants);
+    const int c = g.component[start];
+    auto visit_component = [&](int comp) {
+        for (int k = g.member_offsets[comp]; k < g.member_offsets[comp + 1]; ++k) f(g.members[k]);
+    };
+    if (g.cyclic[c]) {
+        visit_component(c);
+    } else {
+        f(start);
+    }
+    closure.for_each(c, [&](int comp) {
+        if (comp != c) visit_component(comp);
+    });
+}
+
+}  // namespace
+
+void note_event_modified(const GenEvent* event) {
+    EventVersions& versions = event_versions();
+    if (!event || versions.size.load(std::memory_order_acquire) == 0) return;
+    std::lock_guard<std::mutex> lock(versions.mutex);
+    auto it = versions.events.find(event);
+    if (it != versions.events.end()) it->second.version->fetch_add(1, std::memory_order_release);
+}
+
+namespace {
+
+EventGraphQuery* make_event_query(std::shared_ptr<const GenEvent> event) {
+    auto* q = new EventGraphQuery();
+    q->version = watch_event(event.get());
+    q->event = std::move(event);
+    return q;
+}
+
+}  // namespace
+
+// Query on a GenEvent*, for events owned by Julia; the caller keeps the
+// event alive.
+void* create_event_query(void* event) {
+    // Aliasing constructor with an empty owner: a non-owning shared_ptr
+    return make_event_query(std::shared_ptr<const GenEvent>(std::shared_ptr<const GenEvent>(),
+                                                            static_cast<const GenEvent*>(event)));
+}
+
+// Query on an event handle (std::shared_ptr<GenEvent>*); the query shares
+// ownership of the event.
+void* create_event_query_shared(void* event) {
+    return make_event_query(*static_cast<std::shared_ptr<GenEvent>*>(event));
+}
+
+void delete_event_query(void* query) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    unwatch_event(q->event.get());
+    delete q;
+}
+
+// Number of particles in the indexed event; builds the index if needed.
+int event_query_particles_size(void* query) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    return query_graph(q).n_particles;
+}
+
+// True when `ancestor_id` lies upstream of `descendant_id`, i.e. the end
+// vertex of the first particle reaches the production vertex of the second.
+bool event_query_is_ancestor(void* query, int ancestor_id, int descendant_id) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventGraph& g = query_graph(q);
+    const int a = checked_particle_index(g, ancestor_id);
+    const int b = checked_particle_index(g, descendant_id);
+    if (g.end[a] < 0 || g.production[b] < 0) return false;
+    return vertex_reaches(q, g.end[a], g.production[b]);
+}
+
+// Write the ids of all descendants of `particle_id` into `out` (capacity:
+// number of particles in the event) and return how many were written.
+int event_query_descendants(void* query, int particle_id, int* out) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventGraph& g = query_graph(q);
+    const int p = checked_particle_index(g, particle_id);
+    if (g.end[p] < 0) return 0;
+    int n = 0;
+    for_each_reachable_vertex(q, g.end[p], true, [&](int v) {
+        for (int k = g.out_offsets[v]; k < g.out_offsets[v + 1]; ++k) out[n++] = g.out_particles[k] + 1;
+    });
+    return n;
+}
+
+// Write the ids of all ancestors of `particle_id` into `out`; see
+// event_query_descendants.
+int event_query_ancestors(void* query, int particle_id, int* out) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventGraph& g = query_graph(q);
+    const int p = checked_particle_index(g, particle_id);
+    if (g.production[p] < 0) return 0;
+    int n = 0;
+    for_each_reachable_vertex(q, g.production[p], false, [&](int v) {
+        for (int k = g.in_offsets[v]; k < g.in_offsets[v + 1]; ++k) out[n++] = g.in_particles[k] + 1;
+    });
+    return n;
+}
+
+// Write the ids of ancestors of `particle_id` whose PDG id is in `pdg_ids`
+// (compared by absolute value when use_abs is set). Candidates are looked up
+// through a per-event PDG index, so the cost scales with the number of
+// particles carrying those PDG ids rather than with the size of the ancestry.
+int event_query_ancestors_matching(void* query, int particle_id, int* pdg_ids, int n_pdg, bool use_abs, int* out) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventGraph& g = query_graph(q);
+    const int p = checked_particle_index(g, particle_id);
+    if (g.production[p] < 0) return 0;
+    if (!q->has_pdg_index) {
+        for (int i = 0; i < g.n_particles; ++i) {
+            if (g.end[i] >= 0) q->by_pdg[std::abs(g.pdg[i])].push_back(i);
+        }
+        q->has_pdg_index = true;
+    }
+
+    std::unordered_set<int> wanted, keys;
+    for (int i = 0; i < n_pdg; ++i) {
+        wanted.insert(use_abs ? std::abs(pdg_ids[i]) : pdg_ids[i]);
+        keys.insert(std::abs(pdg_ids[i]));
+    }
+
+    int n = 0;
+    for (int key : keys) {
+        auto it = q->by_pdg.find(key);
+        if (it == q->by_pdg.end()) continue;
+        for (int a : it->second) {
+            if (!use_abs && !wanted.count(g.pdg[a])) continue;
+            if (vertex_reaches(q, g.end[a], g.production[p])) out[n++] = a + 1;
+        }
+    }
+    std::sort(out, out + n);
+    return n;
+}
+
+// Drop all cached data; the next query rebuilds it from the event.
+void event_query_invalidate(void* query) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    q->built = false;
+}
+
+int event_query_vertices_size(void* query) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    return query_graph(q).n_vertices;
+}
+
+// Vertex positions (1-based, as used by get_vertex_at) in topological order:
+// every vertex comes after all vertices that produce its incoming particles.
+// Vertices on a cycle are emitted together at the position of their cycle.
+void event_query_topological_order(void* query, int* out) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventTopology& t = query_topology(q);
+    for (size_t i = 0; i < t.vertex_order.size(); ++i) out[i] = t.vertex_order[i] + 1;
+}
+
+// Per vertex position: generation depth from the beams (root vertices have
+// depth 0) and TOPOLOGY_* classification bits.
+void event_query_vertex_metadata(void* query, int* depths, int* flags) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventTopology& t = query_topology(q);
+    for (size_t v = 0; v < t.vertex_depth.size(); ++v) {
+        depths[v] = t.vertex_depth[v];
+        flags[v] = t.vertex_flags[v];
+    }
+}
+
+// Particle ids with particles that have no production vertex (beams) first,
+// followed by the outgoing particles of each vertex in topological order.
+void event_query_particle_order(void* query, int* out) {
+    auto q = static_cast<EventGraphQuery*>(query);
+    const EventTopology& t = query_topology(q);
+    for (size_t i = 0; i < t.particle_order.size(); ++i) out[i] = t.particle_order[i] + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Record slimming
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum SlimRules {
+    SLIM_KEEP_FINAL_STATE = 1,    // keep particles with status 1
+    SLIM_KEEP_STATUS_RANGE = 2,   // keep particles with status_min <= status <= status_max
+    SLIM_KEEP_ANCESTORS = 4,      // also keep every ancestor of a kept particle
+    SLIM_KEEP_BEAMS = 8,          // keep particles without a production vertex
+    SLIM_COLLAPSE_VERTICES = 16,  // contract removed particles, merging their end points
+};
+
+int find_root(std::vector<int>& parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+}  // namespace
+
+// Remove every particle that is not selected by `keep_mask` (one byte per
+// particle id, may be shorter than the event) or by `rules`, and rebuild the
+// event once from the survivors. Kept particles retain their data, attributes
+// and relative order. Vertices without kept particles disappear.
+//
+// Without SLIM_COLLAPSE_VERTICES a kept particle keeps only the links to its
+// own production and end vertices. With it, each removed particle is
+// contracted: its production and end vertices are merged, so kept particles
+// stay connected to their nearest kept ancestors through one vertex. A merged
+// vertex takes the position and status of its first original vertex.
+//
+// `new_ids` receives one entry per original particle: its id after slimming,
+// or 0 if it was removed. Returns the number of kept particles.
+int slim_event(void* event, unsigned char* keep_mask, int n_mask, int rules, int status_min, int status_max, int* new_ids) {
+    auto e = static_cast<HepMC3::GenEvent*>(event);
+    const GenEvent* ce = e;
+    EventGraph g;
+    build_event_graph(ce, g);
+    const auto& particles = ce->particles();
+    const auto& vertices = ce->vertices();
+
+    // Selection
+    std::vector<char> keep(g.n_particles, 0);
+    std::vector<int> stack;
+    for (int i = 0; i < g.n_particles; ++i) {
+        const int status = particles[i]->status();
+        bool k = i < n_mask && keep_mask[i];
+        k = k || ((rules & SLIM_KEEP_FINAL_STATE) && status == 1);
+        k = k || ((rules & SLIM_KEEP_STATUS_RANGE) && status >= status_min && status <= status_max);
+        k = k || ((rules & SLIM_KEEP_BEAMS) && g.production[i] < 0);
+        keep[i] = k;
+        if (k) stack.push_back(i);
+    }
+    if (rules & SLIM_KEEP_ANCESTORS) {
+        std::vector<char> expanded(g.n_vertices, 0);
+        while (!stack.empty()) {
+            const int v = g.production[stack.back()];
+            stack.pop_back();
+            if (v < 0 || expanded[v]) continue;
+            expanded[v] = 1;
+            for (int k = g.in_offsets[v]; k < g.in_offsets[v + 1]; ++k) {
+                const int p = g.in_particles[k];
+                if (!keep[p]) {
+                    keep[p] = 1;
+                    stack.push_back(p);
+                }
+            }
+        }
+    }
+
+    // Vertex groups: identity, or connected through removed particles
+    std::vector<int> group(g.n_vertices);
+    for (int v = 0; v < g.n_vertices; ++v) group[v] = v;
+    if (rules & SLIM_COLLAPSE_VERTICES) {
+        for (int i = 0; i < g.n_particles; ++i) {
+            if (keep[i] || g.production[i] < 0 || g.end[i] < 0) continue;
+            int a = find_root(group, g.production[i]);
+            int b = find_root(group, g.end[i]);
+            if (a != b) group[std::max(a, b)] = std::min(a, b);
+        }
+        for (int v = 0; v < g.n_vertices; ++v) group[v] = find_root(group, v);
+    }
+
+    // New ids. Groups are numbered in order of their first original vertex,
+    // which is also the group representative after the union-find above.
+    int n_kept = 0;
+    for (int i = 0; i < g.n_particles; ++i) new_ids[i] = keep[i] ? ++n_kept : 0;
+    std::vector<int> production(g.n_particles, -1), end(g.n_particles, -1);
+    std::vector<char> used(g.n_vertices, 0);
+    for (int i = 0; i < g.n_particles; ++i) {
+        if (!keep[i]) continue;
+        if (g.production[i] >= 0) production[i] = group[g.production[i]];
+        if (g.end[i] >= 0) end[i] = group[g.end[i]];
+        // A particle produced and absorbed inside one merged vertex would loop
+        if (production[i] >= 0 && production[i] == end[i]) end[i] = -1;
+        if (production[i] >= 0) used[production[i]] = 1;
+        if (end[i] >= 0) used[end[i]] = 1;
+    }
+    std::vector<int> new_vertex(g.n_vertices, 0);
+    int n_new_vertices = 0;
+    for (int v = 0; v < g.n_vertices; ++v) {
+        if (used[v]) new_vertex[v] = -(++n_new_vertices);
+    }
+
+    GenEventData data;
+    data.event_number = ce->event_number();
+    data.momentum_unit = ce->momentum_unit();
+    data.length_unit = ce->length_unit();
+    data.weights = ce->weights();
+    data.event_pos = ce->event_pos();
+    data.particles.reserve(n_kept);
+    data.vertices.reserve(n_new_vertices);
+    for (int i = 0; i < g.n_particles; ++i) {
+        if (keep[i]) data.particles.push_back(particles[i]->data());
+    }
+    for (int v = 0; v < g.n_vertices; ++v) {
+        if (used[v]) data.vertices.push_back(vertices[v]->data());
+    }
+    for (int i = 0; i < g.n_particles; ++i) {
+        if (!keep[i]) continue;
+        if (end[i] >= 0) {
+            data.links1.push_back(new_ids[i]);
+            data.links2.push_back(new_vertex[end[i]]);
+        }
+        if (production[i] >= 0) {
+            data.links1.push_back(new_vertex[production[i]]);
+            data.links2.push_back(new_ids[i]);
+        }
+    }
+
+    // Attributes are carried over as objects rather than re-parsed strings
+    auto attributes = ce->attributes();
+    e->read_data(data);
+    note_event_modified(e);
+    for (const auto& named : attributes) {
+        for (const auto& entry : named.second) {
+            int id = entry.first;
+            if (id > 0) {
+                id = id <= g.n_particles ? new_ids[id - 1] : 0;
+                if (id == 0) continue;
+            } else if (id < 0) {
+                // Attributes of merged vertices follow their group
+                const int v = -id - 1;
+                if (v >= g.n_vertices || !used[group[v]]) continue;
+                id = new_vertex[group[v]];
+            }
+            e->add_attribute(named.first, entry.second, id);
+        }
+    }
+    return n_kept;
+}
+
+// ---------------------------------------------------------------------------
+// Event fingerprints
+// ---------------------------------------------------------------------------
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Two independent 64-bit lanes; each combine step is order dependent.
+struct Hash128 {
+    uint64_t lo = 0x6a09e667f3bcc908ULL;
+    uint64_t hi = 0xbb67ae8584caa73bULL;
+
+    Hash128& add(uint64_t v) {
+        lo = mix64(lo ^ (v + 0x9e3779b97f4a7c15ULL));
+        hi = mix64(hi + (v ^ 0xc2b2ae3d27d4eb4fULL)) ^ (lo >> 17);
+        return *this;
+    }
+    Hash128& add(const Hash128& h) { return add(h.lo).add(h.hi); }
+
+    bool operator==(const Hash128& o) const { return lo == o.lo && hi == o.hi; }
+    bool operator<(const Hash128& o) const { return lo != o.lo ? lo < o.lo : hi < o.hi; }
+};
+
+// Order independent combination of a multiset of hashes.
+struct MultisetHash {
+    uint64_t sum_lo = 0, sum_hi = 0, xor_lo = 0, xor_hi = 0, count = 0;
+
+    void add(const Hash128& h) {
+        const uint64_t a = mix64(h.lo ^ 0x3c6ef372fe94f82bULL);
+        const uint64_t b = mix64(h.hi ^ 0xa54ff53a5f1d36f1ULL);
+        sum_lo += a;
+        sum_hi += b;
+        xor_lo ^= mix64(a);
+        xor_hi ^= mix64(b);
+        ++count;
+    }
+    Hash128 value() const { return Hash128().add(count).add(sum_lo).add(sum_hi).add(xor_lo).add(xor_hi); }
+};
+
+// `x` in multiples of `quantum`. Rounded values stay within +-limit, so NaN
+// and values beyond it get sentinels of their own before any integer cast.
+uint64_t quantise(double x, double quantum) {
+    const double r = std::nearbyint(x / quantum);
+    const double limit = 9.0e18;
+    if (std::isnan(r)) return static_cast<uint64_t>(INT64_MAX);
+    if (r > limit) return static_cast<uint64_t>(INT64_MAX - 1);
+    if (r < -limit) return static_cast<uint64_t>(INT64_MIN);
+    return static_cast<uint64_t>(static_cast<int64_t>(r));
+}
+
+// Rounds used to propagate labels around a cycle; cycles are rare and short
+// in generator records.
+const int MAX_CYCLE_ROUNDS = 16;
+
+// Canonical hashes of every particle and vertex. A particle hash covers its
+// own label (PDG id, status and, if `quantum > 0`, its momentum rounded to
+// multiples of `quantum`), everything upstream of it and everything
+// downstream of it. Labels are propagated along the condensation of the
+// vertex graph, so the result depends on the graph but not on the order in
+// which particles and vertices were added. Strongly connected components are
+// refined with a bounded number of synchronous rounds.
+struct EventFingerprint {
+    std::vector<Hash128> particles;
+    std::vector<Hash128> vertices;
+    Hash128 event;
+};
+
+void propagate_labels(const EventGraph& g, const std::vector<Hash128>& particle_label,
+                      const std::vector<Hash128>& vertex_label, bool downstream,
+                      std::vector<Hash128>& particle_out, std::vector<Hash128>& vertex_out) {
+    // Downstream walks take input from incoming particles and pass the result
+    // to outgoing ones; upstream walks do the opposite.
+    const std::vector<int>& from_offsets = downstream ? g.in_offsets : g.out_offsets;
+    const std::vector<int>& from = downstream ? g.in_particles : g.out_particles;
+    const std::vector<int>& to_offsets = downstream ? g.out_offsets : g.in_offsets;
+    const std::vector<int>& to = downstream ? g.out_particles : g.in_particles;
+    const std::vector<int>& source = downstream ? g.production : g.end;
+    const uint64_t boundary = downstream ? 1 : 2;
+
+    particle_out.resize(g.n_particles);
+    vertex_out.resize(g.n_vertices);
+    for (int i = 0; i < g.n_particles; ++i) {
+        particle_out[i] = Hash128(particle_label[i]).add(boundary);
+    }
+
+    auto visit_vertex = [&](int v) {
+        MultisetHash inputs;
+        for (int k = from_offsets[v]; k < from_offsets[v + 1]; ++k) inputs.add(particle_out[from[k]]);
+        vertex_out[v] = Hash128(vertex_label[v]).add(inputs.value());
+    };
+    auto emit_vertex = [&](int v) {
+        for (int k = to_offsets[v]; k < to_offsets[v + 1]; ++k) {
+            const int p = to[k];
+            if (source[p] == v) particle_out[p] = Hash128(particle_label[p]).add(vertex_out[v]);
+        }
+    };
+
+    const int n_components = g.component_order.size();
+    for (int n = 0; n < n_components; ++n) {
+        const int c = g.component_order[downstream ? n : n_components - 1 - n];
+        const int* first = g.members.data() + g.member_offsets[c];
+        const int* last = g.members.data() + g.member_offsets[c + 1];
+        if (!g.cyclic[c]) {
+            visit_vertex(*first);
+            emit_vertex(*first);
+            continue;
+        }
+        const int rounds = std::min<int>(last - first, MAX_CYCLE_ROUNDS);
+        for (int r = 0; r < rounds; ++r) {
+            for (const int* v = first; v != last; ++v) visit_vertex(*v);
+            for (const int* v = first; v != last; ++v) emit_vertex(*v);
+        }
+    }
+}
+
+void compute_fingerprint(const GenEvent* event, double quantum, EventFingerprint& f) {
+    EventGraph g;
+    build_event_graph(event, g);
+    const auto& particles = event->particles();
+    const auto& vertices = event->vertices();
+
+    std::vector<Hash128> particle_label(g.n_particles), vertex_label(g.n_vertices);
+    for (int i = 0; i < g.n_particles; ++i) {
+        const auto& p = particles[i];
+        Hash128& h = particle_label[i];
+        h.add(static_cast<uint64_t>(static_cast<int64_t>(p->pid()))).add(static_cast<uint64_t>(static_cast<int64_t>(p->status())));
+        if (quantum > 0) {
+            const FourVector& m = p->momentum();
+            h.add(quantise(m.px(), quantum)).add(quantise(m.py(), quantum)).add(quantise(m.pz(), quantum)).add(quantise(m.e(), quantum));
+        }
+    }
+    for (int v = 0; v < g.n_vertices; ++v) {
+        vertex_label[v].add(static_cast<uint64_t>(static_cast<int64_t>(vertices[v]->status())));
+    }
+
+    std::vector<Hash128> particle_down, vertex_down, particle_up, vertex_up;
+    propagate_labels(g, particle_label, vertex_label, true, particle_down, vertex_down);
+    propagate_labels(g, particle_label, vertex_label, false, particle_up, vertex_up);
+
+    MultisetHash all_particles, all_vertices;
+    f.particles.resize(g.n_particles);
+    f.vertices.resize(g.n_vertices);
+    for (int i = 0; i < g.n_particles; ++i) {
+        f.particles[i] = Hash128(particle_down[i]).add(particle_up[i]);
+        all_particles.add(f.particles[i]);
+    }
+    for (int v = 0; v < g.n_vertices; ++v) {
+        f.vertices[v] = Hash128(vertex_down[v]).add(vertex_up[v]);
+        all_vertices.add(f.vertices[v]);
+    }
+    f.event = Hash128().add(all_particles.value()).add(all_vertices.value());
+}
+
+bool momenta_close(double x, double y, double tolerance) {
+    return std::fabs(x - y) <= tolerance * std::max({std::fabs(x), std::fabs(y), 1.0});
+}
+
+}  // namespace
+
+// 128-bit hash of an event's graph, PDG ids, statuses and vertex statuses,
+// independent of the order in which particles and vertices were added.
+// With `quantum > 0` momenta are rounded to multiples of `quantum` and
+// included; with `quantum <= 0` only the structure is hashed. Event number,
+// weights, positions and attributes are not part of the fingerprint.
+// `out` receives the low and high 64-bit words.
+void event_fingerprint_words(void* event, double quantum, uint64_t* out) {
+    EventFingerprint f;
+    compute_fingerprint(static_cast<const GenEvent*>(event), quantum, f);
+    out[0] = f.event.lo;
+    out[1] = f.event.hi;
+}
+
+// Structural comparison of two events: equal sizes and structural
+// fingerprints, then particle momenta matched through their canonical hashes
+// and compared component-wise with relative `tolerance` (absolute below 1).
+// Particles with identical canonical hashes are paired in order of energy.
+bool events_structurally_equal(void* a, void* b, double tolerance) {
+    const GenEvent* ea = static_cast<const GenEvent*>(a);
+    const GenEvent* eb = static_cast<const GenEvent*>(b);
+    if (ea->particles().size() != eb->particles().size() || ea->vertices().size() != eb->vertices().size()) {
+        return false;
+    }
+
+    EventFingerprint fa, fb;
+    compute_fingerprint(ea, 0.0, fa);
+    compute_fingerprint(eb, 0.0, fb);
+    if (!(fa.event == fb.event)) return false;
+
+    auto canonical_order = [](const GenEvent* e, const EventFingerprint& f) {
+        const auto& particles = e->particles();
+        std::vector<int> order(particles.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int i, int j) {
+            if (!(f.particles[i] == f.particles[j])) return f.particles[i] < f.particles[j];
+            const FourVector& mi = particles[i]->momentum();
+            const FourVector& mj = particles[j]->momentum();
+            if (mi.e() != mj.e()) return mi.e() < mj.e();
+            if (mi.pz() != mj.pz()) return mi.pz() < mj.pz();
+            if (mi.px() != mj.px()) return mi.px() < mj.px();
+            return mi.py() < mj.py();
+        });
+        return order;
+    };
+    const std::vector<int> order_a = canonical_order(ea, fa);
+    const std::vector<int> order_b = canonical_order(eb, fb);
+
+    for (size_t k = 0; k < order_a.size(); ++k) {
+        const int i = order_a[k];
+        const int j = order_b[k];
+        if (!(fa.particles[i] == fb.particles[j])) return false;
+        const FourVector& ma = ea->particles()[i]->momentum();
+        const FourVector& mb = eb->particles()[j]->momentum();
+        if (!momenta_close(ma.px(), mb.px(), tolerance) || !momenta_close(ma.py(), mb.py(), tolerance) ||
+            !momenta_close(ma.pz(), mb.pz(), tolerance) || !momenta_close(ma.e(), mb.e(), tolerance)) {
+            return false;
+        }
+    }
+    return true;
+}
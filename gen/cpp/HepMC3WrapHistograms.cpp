@@ -0,0 +1,294 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapEngine.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Histograms
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Quantities a histogram axis can be filled with. Particle quantities are
+// filled once per selected particle, event quantities once per event.
+enum Quantity {
+    QUANTITY_PT = 1,
+    QUANTITY_ETA = 2,
+    QUANTITY_PHI = 3,
+    QUANTITY_ENERGY = 4,
+    QUANTITY_MASS = 5,
+    QUANTITY_RAPIDITY = 6,
+    QUANTITY_N_SELECTED = 11,
+    QUANTITY_HT = 12,
+    QUANTITY_LEADING_PT = 13,
+};
+
+bool is_particle_quantity(int quantity) {
+    return quantity >= QUANTITY_PT && quantity <= QUANTITY_RAPIDITY;
+}
+
+bool is_event_quantity(int quantity) {
+    return quantity >= QUANTITY_N_SELECTED && quantity <= QUANTITY_LEADING_PT;
+}
+
+double particle_quantity(int quantity, const FourVector& p) {
+    switch (quantity) {
+        case QUANTITY_PT: return p.perp();
+        case QUANTITY_ETA: return p.perp() == 0.0 ? std::copysign(HUGE_VAL, p.pz()) : p.eta();
+        case QUANTITY_PHI: return p.phi();
+        case QUANTITY_ENERGY: return p.e();
+        case QUANTITY_MASS: return p.m();
+        default: return p.rap();
+    }
+}
+
+}  // namespace
+
+class Axis {
+public:
+    Axis(int quantity, const double* edges, int n_edges) : quantity(quantity), edges(edges, edges + n_edges) {
+        if (n_edges < 2) throw std::invalid_argument("a histogram axis needs at least two edges");
+        for (int i = 1; i < n_edges; ++i) {
+            if (!(edges[i] > edges[i - 1])) throw std::invalid_argument("histogram edges must increase");
+        }
+        // Equally spaced edges get a direct bin lookup instead of a search
+        const double lo = edges[0], width = (edges[n_edges - 1] - lo) / (n_edges - 1);
+        m_uniform = true;
+        for (int i = 1; i < n_edges && m_uniform; ++i) {
+            m_uniform = std::abs(edges[i] - (lo + i * width)) <= 1e-9 * std::abs(edges[n_edges - 1] - lo);
+        }
+        m_inverse_width = 1.0 / width;
+    }
+
+    int bins() const { return static_cast<int>(edges.size()) - 1; }
+
+    // 0 for underflow, 1..bins() for the bins, bins() + 1 for overflow and
+    // -1 for NaN. Bins include their lower edge.
+    int index(double x) const {
+        if (std::isnan(x)) return -1;
+        if (x < edges.front()) return 0;
+        if (x >= edges.back()) return bins() + 1;
+        if (!m_uniform) return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+        int i = std::min(static_cast<int>((x - edges.front()) * m_inverse_width), bins() - 1);
+        // Rounding can put x next to the bin it belongs to
+        if (x < edges[i]) --i;
+        else if (x >= edges[i + 1]) ++i;
+        return i + 1;
+    }
+
+    int quantity;
+    std::vector<double> edges;
+
+private:
+    bool m_uniform = false;
+    double m_inverse_width = 0.0;
+};
+
+// A 1D histogram, or 2D when it has a y axis. Bins are stored with under-
+// and overflow, x fastest: index ix + (bins_x + 2) * iy.
+class Histogram {
+public:
+    explicit Histogram(Axis x) : x(std::move(x)) { reset(); }
+    Histogram(Axis x, Axis y) : x(std::move(x)), y(new Axis(std::move(y))) { reset(); }
+
+    Histogram(const Histogram& other)
+        : x(other.x), y(other.y ? new Axis(*other.y) : nullptr), sumw(other.sumw), sumw2(other.sumw2),
+          entries(other.entries) {}
+
+    void reset() {
+        const size_t n = (x.bins() + 2) * (y ? y->bins() + 2 : 1);
+        sumw.assign(n, 0.0);
+        sumw2.assign(n, 0.0);
+        entries = 0;
+    }
+
+    void fill(double vx, double w) {
+        const int i = x.index(vx);
+        if (i < 0) return;
+        add(i, w);
+    }
+
+    void fill(double vx, double vy, double w) {
+        const int i = x.index(vx), j = y->index(vy);
+        if (i < 0 || j < 0) return;
+        add(i + (x.bins() + 2) * j, w);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < sumw.size(); ++i) {
+            sumw[i] += other.sumw[i];
+            sumw2[i] += other.sumw2[i];
+        }
+        entries += other.entries;
+    }
+
+    Axis x;
+    std::unique_ptr<Axis> y;
+    std::vector<double> sumw;
+    std::vector<double> sumw2;
+    int64_t entries = 0;
+
+private:
+    void add(size_t bin, double w) {
+        sumw[bin] += w;
+        sumw2[bin] += w * w;
+        ++entries;
+    }
+};
+
+// The histograms filled by one engine run, and the event weight they use
+// (-1 for unit weights).
+class HistogramSet {
+public:
+    explicit HistogramSet(int weight_index) : weight_index(weight_index) {}
+
+    int weight_index;
+    std::vector<Histogram> histograms;
+};
+
+namespace {
+
+// Fills a private copy of the configured histograms; the engine merges the
+// copies of all workers at the end.
+class HistogramKernel : public EventKernel {
+public:
+    explicit HistogramKernel(const KernelConfig& config) : m_selection(config.selection) {
+        if (!config.histograms) throw std::invalid_argument("the histograms kernel needs a histogram set");
+        m_set.reset(new HistogramSet(*config.histograms));
+        for (auto& histogram : m_set->histograms) {
+            histogram.reset();
+            (is_particle_quantity(histogram.x.quantity) ? m_particle : m_event).push_back(&histogram);
+        }
+    }
+
+    std::vector<std::string> columns() const override { return {}; }
+
+    void process(const GenEvent& event, KernelOutput&) override {
+        double w = 1.0;
+        if (m_set->weight_index >= 0) {
+            if (m_set->weight_index >= static_cast<int>(event.weights().size())) {
+                throw std::out_of_range("event " + std::to_string(event.event_number()) + " has no weight " +
+                                        std::to_string(m_set->weight_index + 1));
+            }
+            w = event.weights()[m_set->weight_index];
+        }
+
+        int n = 0;
+        double ht = 0.0, leading = 0.0;
+        for (const auto& particle : event.particles()) {
+            if (!m_selection.accepts(*particle)) continue;
+            const FourVector& p = particle->momentum();
+            ++n;
+            ht += p.perp();
+            leading = std::max(leading, p.perp());
+            for (Histogram* h : m_particle) {
+                const double vx = particle_quantity(h->x.quantity, p);
+                if (h->y) {
+                    h->fill(vx, particle_quantity(h->y->quantity, p), w);
+                } else {
+                    h->fill(vx, w);
+                }
+            }
+        }
+
+        if (m_event.empty()) return;
+        auto value = [&](int quantity) {
+            return quantity == QUANTITY_N_SELECTED ? double(n) : quantity == QUANTITY_HT ? ht : leading;
+        };
+        for (Histogram* h : m_event) {
+            if (h->y) {
+                h->fill(value(h->x.quantity), value(h->y->quantity), w);
+            } else {
+                h->fill(value(h->x.quantity), w);
+            }
+        }
+    }
+
+    void merge(EventKernel& other) override {
+        auto& histograms = static_cast<HistogramKernel&>(other).m_set->histograms;
+        for (size_t i = 0; i < histograms.size(); ++i) m_set->histograms[i].merge(histograms[i]);
+    }
+
+    const HistogramSet& histograms() const { return *m_set; }
+
+private:
+    ParticleSelection m_selection;
+    std::unique_ptr<HistogramSet> m_set;
+    std::vector<Histogram*> m_particle;
+    std::vector<Histogram*> m_event;
+};
+
+const Histogram& histogram_at(void* set, int i) {
+    auto s = static_cast<HistogramSet*>(set);
+    if (i < 0 || i >= static_cast<int>(s->histograms.size())) throw std::out_of_range("histogram index out of range");
+    return s->histograms[i];
+}
+
+}  // namespace
+
+std::unique_ptr<EventKernel> make_histogram_kernel(const KernelConfig& config) {
+    return std::unique_ptr<EventKernel>(new HistogramKernel(config));
+}
+
+// Histogram sets
+
+void* create_histogram_set(int weight_index) {
+    return new HistogramSet(weight_index);
+}
+
+// Add a histogram of `quantity_x` with `n_x + 1` edges, or a 2D histogram
+// when `quantity_y` is not 0. Both axes must be particle quantities or both
+// event quantities.
+void histogram_set_add(void* set, int quantity_x, double* edges_x, int n_x, int quantity_y, double* edges_y, int n_y) {
+    auto s = static_cast<HistogramSet*>(set);
+    const bool particle = is_particle_quantity(quantity_x);
+    if (!particle && !is_event_quantity(quantity_x)) throw std::invalid_argument("unknown histogram quantity");
+    if (quantity_y == 0) {
+        s->histograms.emplace_back(Axis(quantity_x, edges_x, n_x + 1));
+        return;
+    }
+    if (particle ? !is_particle_quantity(quantity_y) : !is_event_quantity(quantity_y)) {
+        throw std::invalid_argument("2D histograms need two particle or two event quantities");
+    }
+    s->histograms.emplace_back(Axis(quantity_x, edges_x, n_x + 1), Axis(quantity_y, edges_y, n_y + 1));
+}
+
+int histogram_set_size(void* set) {
+    return static_cast<HistogramSet*>(set)->histograms.size();
+}
+
+void delete_histogram_set(void* set) {
+    delete static_cast<HistogramSet*>(set);
+}
+
+// The merged histograms of an engine run with the histograms kernel, owned
+// by the result; nullptr for other kernels.
+void* engine_result_histograms(void* result) {
+    auto kernel = dynamic_cast<const HistogramKernel*>(engine_result_kernel(result));
+    return kernel ? const_cast<HistogramSet*>(&kernel->histograms()) : nullptr;
+}
+
+// Number of bins including under- and overflow: (bins_x + 2) * (bins_y + 2).
+int histogram_bins_size(void* set, int i) {
+    return histogram_at(set, i).sumw.size();
+}
+
+int64_t histogram_entries(void* set, int i) {
+    return histogram_at(set, i).entries;
+}
+
+// Copy the bin contents, with under- and overflow, x fastest.
+void copy_histogram_bins(void* set, int i, double* sumw, double* sumw2) {
+    const Histogram& h = histogram_at(set, i);
+    std::copy(h.sumw.begin(), h.sumw.end(), sumw);
+    std::copy(h.sumw2.begin(), h.sumw2.end(), sumw2);
+}
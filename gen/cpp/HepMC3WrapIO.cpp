@@ -0,0 +1,1184 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapMemory.h"
+#include "HepMC3WrapRaw.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenRunInfo.h"
+#include "HepMC3/ReaderAscii.h"
+#include "HepMC3/WriterAscii.h"
+#include "HepMC3/Data/GenEventData.h"
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <zlib.h>
+#ifdef HEPMC3_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Asynchronous writer
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// One queued event: either a GenEventData snapshot taken on the producer's
+// thread, or a shared reference to an event the producer no longer modifies.
+struct QueuedEvent {
+    std::shared_ptr<const GenEvent> event;
+    GenEventData data;
+    std::shared_ptr<GenRunInfo> run_info;
+};
+
+// Stream buffer that forwards to another buffer and counts the bytes.
+class CountingBuffer : public std::streambuf {
+public:
+    explicit CountingBuffer(std::streambuf* target) : m_target(target) {}
+
+    int64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+        if (traits_type::eq_int_type(m_target->sputc(traits_type::to_char_type(c)), traits_type::eof())) {
+            return traits_type::eof();
+        }
+        m_bytes.fetch_add(1, std::memory_order_relaxed);
+        return c;
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        const std::streamsize written = m_target->sputn(data, size);
+        m_bytes.fetch_add(written, std::memory_order_relaxed);
+        return written;
+    }
+
+    int sync() override { return m_target->pubsync(); }
+
+private:
+    std::streambuf* m_target;
+    std::atomic<int64_t> m_bytes{0};
+};
+
+// WriterAscii driven by a dedicated thread. Producers push into a bounded
+// queue and block only while it is full; the worker owns the writer and is
+// the only thread that formats or touches the output stream. The first
+// failure (stream error or exception) is kept and reported to every later
+// call, and the queue stops accepting events.
+class AsyncWriter {
+public:
+    AsyncWriter(const std::string& filename, int capacity)
+        : m_file(filename), m_counter(m_file.rdbuf()), m_stream(&m_counter), m_writer(m_stream),
+          m_capacity(capacity > 0 ? capacity : 1) {
+        if (!m_file.is_open() || m_writer.failed()) {
+            m_error = "cannot open " + filename + " for writing";
+            m_closed = true;
+            return;
+        }
+        m_thread = std::thread(&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter() { close(); }
+
+    bool push(QueuedEvent&& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [&] { return m_queue.size() < m_capacity || !m_error.empty() || m_closed; });
+        if (!m_error.empty() || m_closed) return false;
+        m_queue.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    // Wait until every event queued so far has been written and the worker
+    // has flushed the stream, so the text has reached the file.
+    bool flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const int64_t request = ++m_flush_requests;
+        m_not_empty.notify_one();
+        m_idle.wait(lock, [&] { return m_flushed >= request || m_stopped || !m_error.empty(); });
+        return m_error.empty();
+    }
+
+    // Let the worker stop once the queue is drained, without waiting for it.
+    void begin_close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+        m_not_empty.notify_one();
+    }
+
+    // Drain the queue, stop the worker and close the file. Safe to call twice.
+    bool close() {
+        begin_close();
+        if (m_thread.joinable()) {
+            m_thread.join();
+            m_writer.close();
+            m_file.close();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_full.notify_all();
+        return m_error.empty();
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_error.empty();
+    }
+
+    std::string error() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    void counts(int64_t* out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out[0] = m_written;
+        out[1] = m_queue.size();
+    }
+
+    // Bytes of event text written to the file so far, including the header.
+    int64_t bytes() const { return m_counter.bytes(); }
+
+private:
+    void run() {
+        GenEvent scratch;
+        while (true) {
+            QueuedEvent item;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_not_empty.wait(lock, [&] { return !m_queue.empty() || m_closing || m_flushed < m_flush_requests; });
+                if (!m_error.empty()) break;
+                if (m_queue.empty() && m_flushed < m_flush_requests) {
+                    // Caught up with a flush request: push the text out of
+                    // the stream buffers before answering it
+                    const int64_t request = m_flush_requests;
+                    lock.unlock();
+                    m_stream.flush();
+                    lock.lock();
+                    if (!m_stream) {
+                        m_error = "write failed (disk full or stream closed)";
+                        m_not_full.notify_all();
+                        break;
+                    }
+                    m_flushed = request;
+                    m_idle.notify_all();
+                    continue;
+                }
+                if (m_queue.empty()) break;
+                item = std::move(m_queue.front());
+                m_queue.pop_front();
+                m_not_full.notify_one();
+            }
+
+            std::string error;
+            try {
+                if (item.event) {
+                    m_writer.write_event(*item.event);
+                } else {
+                    scratch.read_data(item.data);
+                    scratch.set_run_info(item.run_info);
+                    m_writer.write_event(scratch);
+                }
+                if (m_writer.failed()) error = "write failed (disk full or stream closed)";
+            } catch (const std::exception& ex) {
+                error = ex.what();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error.empty()) {
+                m_written++;
+            } else {
+                m_error = error;
+                m_queue.clear();
+                m_not_full.notify_all();
+                m_idle.notify_all();
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_idle.notify_all();
+    }
+
+    std::ofstream m_file;
+    CountingBuffer m_counter;
+    std::ostream m_stream;
+    WriterAscii m_writer;
+    const size_t m_capacity;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full, m_not_empty, m_idle;
+    std::deque<QueuedEvent> m_queue;
+    std::string m_error;
+    bool m_closing = false;
+    bool m_closed = false;
+    bool m_stopped = false;   // the worker has exited
+    int64_t m_written = 0;
+    int64_t m_flush_requests = 0;
+    int64_t m_flushed = 0;    // flush requests answered
+};
+
+}  // namespace
+
+// Open `filename` and start the writer thread. The queue holds at most
+// `capacity` events. Check async_writer_failed for open errors.
+void* create_async_writer(const char* filename, int capacity) {
+    return new AsyncWriter(std::string(filename), capacity);
+}
+
+// Snapshot `event` into a GenEventData and queue it; the caller may modify or
+// reuse the event as soon as this returns. Blocks while the queue is full.
+// Returns false if the writer has failed or was closed.
+bool async_writer_write_event(void* writer, void* event) {
+    auto e = static_cast<const GenEvent*>(event);
+    QueuedEvent item;
+    e->write_data(item.data);
+    item.run_info = e->run_info();
+    return static_cast<AsyncWriter*>(writer)->push(std::move(item));
+}
+
+// Queue an event owned by a shared_ptr (as returned by read_hepmc_file)
+// without copying it. The event must not be modified until it is written.
+bool async_writer_write_event_shared(void* writer, void* event) {
+    QueuedEvent item;
+    item.event = *static_cast<std::shared_ptr<GenEvent>*>(event);
+    return static_cast<AsyncWriter*>(writer)->push(std::move(item));
+}
+
+bool async_writer_flush(void* writer) {
+    return static_cast<AsyncWriter*>(writer)->flush();
+}
+
+bool async_writer_close(void* writer) {
+    return static_cast<AsyncWriter*>(writer)->close();
+}
+
+bool async_writer_failed(void* writer) {
+    return static_cast<AsyncWriter*>(writer)->failed();
+}
+
+void* async_writer_error(void* writer) {
+    return stable_string_result(static_cast<AsyncWriter*>(writer)->error());
+}
+
+// Events written so far, events waiting in the queue.
+void async_writer_counts(void* writer, int64_t* out) {
+    static_cast<AsyncWriter*>(writer)->counts(out);
+}
+
+void delete_async_writer(void* writer) {
+    delete static_cast<AsyncWriter*>(writer);
+}
+
+// ---------------------------------------------------------------------------
+// Parallel writer
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Formats events on a pool of threads and commits the text in submission
+// order, producing the same bytes as one WriterAscii.
+//
+// Each worker owns a WriterAscii on a string stream. The only writer state
+// that changes the text of an event is its run info (the run info block is
+// written before the first event only), so submission records the
+// run info a serial writer would hold before each event, and the worker sets
+// it on its writer before formatting. WriterAscii flushes its buffer at the
+// end of write_event, so the stream then holds exactly that event's text.
+// Header and footer are written by a WriterAscii on the output file.
+class ParallelWriter {
+public:
+    ParallelWriter(const std::string& filename, int n_threads, int capacity)
+        : m_file(filename), m_file_writer(m_file), m_capacity(capacity > 0 ? capacity : 1) {
+        if (!m_file || m_file_writer.failed()) {
+            m_error = "cannot open " + filename + " for writing";
+            m_closed = true;
+            return;
+        }
+        if (n_threads <= 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < n_threads; ++i) m_workers.emplace_back(&ParallelWriter::format, this);
+        m_committer = std::thread(&ParallelWriter::commit, this);
+    }
+
+    ~ParallelWriter() { close(); }
+
+    bool push(QueuedEvent&& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [&] { return m_submitted - m_committed < m_capacity || !m_error.empty() || m_closed; });
+        if (!m_error.empty() || m_closed) return false;
+        Task task;
+        task.sequence = m_submitted++;
+        task.writer_run_info = m_run_info;
+        if (!m_run_info) {
+            m_run_info = item.event ? item.event->run_info() : item.run_info;
+            // WriterAscii::write_run_info gives a first event without run info
+            // an empty one, so no later event writes a run info block either
+            if (!m_run_info) m_run_info = std::make_shared<GenRunInfo>();
+        }
+        task.item = std::move(item);
+        m_tasks.push_back(std::move(task));
+        m_work.notify_one();
+        return true;
+    }
+
+    bool flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_committed_cv.wait(lock, [&] { return m_committed == m_submitted || !m_error.empty(); });
+        return m_error.empty();
+    }
+
+    bool close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closing = true;
+            m_work.notify_all();
+            m_ready.notify_all();
+        }
+        for (auto& worker : m_workers) worker.join();
+        m_workers.clear();
+        if (m_committer.joinable()) {
+            m_committer.join();
+            m_file_writer.close();
+            m_file.close();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_full.notify_all();
+        return m_error.empty();
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_error.empty();
+    }
+
+    std::string error() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    // Events committed, events in flight, bytes committed.
+    void counts(int64_t* out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out[0] = m_committed;
+        out[1] = m_submitted - m_committed;
+        out[2] = m_bytes;
+    }
+
+private:
+    struct Task {
+        uint64_t sequence = 0;
+        QueuedEvent item;
+        std::shared_ptr<GenRunInfo> writer_run_info;
+    };
+
+    void fail(const std::string& error) {
+        if (m_error.empty()) m_error = error;
+        m_tasks.clear();
+        m_not_full.notify_all();
+        m_committed_cv.notify_all();
+        m_ready.notify_all();
+    }
+
+    void format() {
+        std::ostringstream stream;
+        WriterAscii writer(stream);
+        GenEvent scratch;
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work.wait(lock, [&] { return !m_tasks.empty() || m_closing || !m_error.empty(); });
+                if (m_tasks.empty() || !m_error.empty()) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+
+            std::string error;
+            try {
+                stream.str(std::string());
+                writer.set_run_info(task.writer_run_info);
+                if (task.item.event) {
+                    writer.write_event(*task.item.event);
+                } else {
+                    scratch.read_data(task.item.data);
+                    scratch.set_run_info(task.item.run_info);
+                    writer.write_event(scratch);
+                }
+                if (writer.failed()) error = "formatting failed";
+            } catch (const std::exception& ex) {
+                error = ex.what();
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!error.empty()) {
+                fail(error);
+                return;
+            }
+            m_results.emplace(task.sequence, stream.str());
+            m_ready.notify_all();
+        }
+    }
+
+    void commit() {
+        while (true) {
+            std::string text;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.wait(lock, [&] {
+                    return m_results.count(m_committed) || !m_error.empty() || (m_closing && m_committed == m_submitted);
+                });
+                auto it = m_results.find(m_committed);
+                if (it == m_results.end() || !m_error.empty()) return;
+                text = std::move(it->second);
+                m_results.erase(it);
+            }
+
+            m_file.write(text.data(), text.size());
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_committed++;
+            // Caught up: push the text to the file before releasing flush()
+            if (m_committed == m_submitted) m_file.flush();
+            if (!m_file) {
+                fail("write failed (disk full or stream closed)");
+                return;
+            }
+            m_bytes += text.size();
+            m_not_full.notify_one();
+            m_committed_cv.notify_all();
+        }
+    }
+
+    std::ofstream m_file;
+    WriterAscii m_file_writer;
+    const uint64_t m_capacity;
+    std::vector<std::thread> m_workers;
+    std::thread m_committer;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full, m_work, m_ready, m_committed_cv;
+    std::deque<Task> m_tasks;
+    std::map<uint64_t, std::string> m_results;
+    std::shared_ptr<GenRunInfo> m_run_info;
+    std::string m_error;
+    uint64_t m_submitted = 0;
+    uint64_t m_committed = 0;
+    int64_t m_bytes = 0;
+    bool m_closing = false;
+    bool m_closed = false;
+};
+
+}  // namespace
+
+// Open `filename` and start `n_threads` formatting threads (all cores if
+// n_threads <= 0). At most `capacity` events are in flight at once.
+void* create_parallel_writer(const char* filename, int n_threads, int capacity) {
+    return new ParallelWriter(std::string(filename), n_threads, capacity);
+}
+
+// Snapshot `event` and queue it; see async_writer_write_event.
+bool parallel_writer_write_event(void* writer, void* event) {
+    auto e = static_cast<const GenEvent*>(event);
+    QueuedEvent item;
+    e->write_data(item.data);
+    item.run_info = e->run_info();
+    return static_cast<ParallelWriter*>(writer)->push(std::move(item));
+}
+
+// Queue a shared event without copying; see async_writer_write_event_shared.
+bool parallel_writer_write_event_shared(void* writer, void* event) {
+    QueuedEvent item;
+    item.event = *static_cast<std::shared_ptr<GenEvent>*>(event);
+    return static_cast<ParallelWriter*>(writer)->push(std::move(item));
+}
+
+bool parallel_writer_flush(void* writer) {
+    return static_cast<ParallelWriter*>(writer)->flush();
+}
+
+bool parallel_writer_close(void* writer) {
+    return static_cast<ParallelWriter*>(writer)->close();
+}
+
+bool parallel_writer_failed(void* writer) {
+    return static_cast<ParallelWriter*>(writer)->failed();
+}
+
+void* parallel_writer_error(void* writer) {
+    return stable_string_result(static_cast<ParallelWriter*>(writer)->error());
+}
+
+void parallel_writer_counts(void* writer, int64_t* out) {
+    static_cast<ParallelWriter*>(writer)->counts(out);
+}
+
+void delete_parallel_writer(void* writer) {
+    delete static_cast<ParallelWriter*>(writer);
+}
+
+// ---------------------------------------------------------------------------
+// Compressed writers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum CompressionCodec { CODEC_GZIP = 1, CODEC_ZSTD = 2 };
+
+// Output stream buffer that compresses everything written to it into `file`.
+// sync() only hands pending bytes to the compressor (WriterAscii ends some
+// lines with std::endl), the stream is terminated by finish().
+class CompressingBuffer : public std::streambuf {
+public:
+    explicit CompressingBuffer(std::FILE* file) : m_file(file), m_in(1 << 18), m_out(1 << 18) {
+        setp(m_in.data(), m_in.data() + m_in.size());
+    }
+    ~CompressingBuffer() override = default;
+
+    // Compress and write the remaining input and the stream trailer.
+    bool finish() {
+        if (m_finished) return !m_failed;
+        m_finished = true;
+        if (!m_failed) compress(pbase(), pptr() - pbase(), true);
+        setp(m_in.data(), m_in.data() + m_in.size());
+        return !m_failed;
+    }
+
+    bool failed() const { return m_failed; }
+    const std::string& error() const { return m_error; }
+
+protected:
+    int_type overflow(int_type c) override {
+        if (sync() != 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override {
+        if (m_failed || m_finished) return -1;
+        compress(pbase(), pptr() - pbase(), false);
+        setp(m_in.data(), m_in.data() + m_in.size());
+        return m_failed ? -1 : 0;
+    }
+
+    // Feed `size` bytes to the codec, ending the stream if `last`.
+    virtual void compress(const char* data, size_t size, bool last) = 0;
+
+    void write_output(size_t size) {
+        if (size > 0 && std::fwrite(m_out.data(), 1, size, m_file) != size) fail("write failed (disk full?)");
+    }
+
+    void fail(const std::string& error) {
+        if (!m_failed) m_error = error;
+        m_failed = true;
+    }
+
+    std::FILE* m_file;
+    std::vector<char> m_in;
+    std::vector<char> m_out;
+    bool m_failed = false;
+    bool m_finished = false;
+    std::string m_error;
+};
+
+class GzipBuffer : public CompressingBuffer {
+public:
+    GzipBuffer(std::FILE* file, int level) : CompressingBuffer(file) {
+        // windowBits 15 + 16 selects the gzip container
+        if (deflateInit2(&m_z, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            fail("invalid gzip compression level " + std::to_string(level));
+        } else {
+            m_initialised = true;
+        }
+    }
+    ~GzipBuffer() override {
+        if (m_initialised) deflateEnd(&m_z);
+    }
+
+protected:
+    void compress(const char* data, size_t size, bool last) override {
+        m_z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_z.avail_in = size;
+        const int flush = last ? Z_FINISH : Z_NO_FLUSH;
+        int status;
+        do {
+            m_z.next_out = reinterpret_cast<Bytef*>(m_out.data());
+            m_z.avail_out = m_out.size();
+            status = deflate(&m_z, flush);
+            if (status == Z_STREAM_ERROR) return fail("gzip compression failed");
+            write_output(m_out.size() - m_z.avail_out);
+        } while (!m_failed && (m_z.avail_out == 0 || (last && status != Z_STREAM_END)));
+    }
+
+private:
+    z_stream m_z{};
+    bool m_initialised = false;
+};
+
+#ifdef HEPMC3_WITH_ZSTD
+class ZstdBuffer : public CompressingBuffer {
+public:
+    ZstdBuffer(std::FILE* file, int level, int n_threads) : CompressingBuffer(file), m_ctx(ZSTD_createCCtx()) {
+        if (!m_ctx) {
+            fail("cannot create zstd context");
+        } else if (ZSTD_isError(ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_compressionLevel, level))) {
+            fail("invalid zstd compression level " + std::to_string(level));
+        } else if (n_threads > 1) {
+            // Fails if libzstd was built without multithreading; compression
+            // then stays single-threaded
+            ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_nbWorkers, n_threads);
+        }
+    }
+    ~ZstdBuffer() override { ZSTD_freeCCtx(m_ctx); }
+
+protected:
+    void compress(const char* data, size_t size, bool last) override {
+        ZSTD_inBuffer in = {data, size, 0};
+        const ZSTD_EndDirective mode = last ? ZSTD_e_end : ZSTD_e_continue;
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out = {m_out.data(), m_out.size(), 0};
+            remaining = ZSTD_compressStream2(m_ctx, &out, &in, mode);
+            if (ZSTD_isError(remaining)) return fail(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+            write_output(out.pos);
+        } while (!m_failed && (last ? remaining != 0 : in.pos < in.size));
+    }
+
+private:
+    ZSTD_CCtx* m_ctx;
+};
+#endif
+
+// Owns the file, compressor and stream, so they are constructed before and
+// destroyed after the WriterAscii base that writes into them.
+struct CompressedStream {
+    CompressedStream(const std::string& filename, int codec, int level, int n_threads)
+        : file(std::fopen(filename.c_str(), "wb")), stream(nullptr) {
+        if (!file) {
+            error = "cannot open " + filename + " for writing";
+            return;
+        }
+        if (codec == CODEC_GZIP) {
+            buffer.reset(new GzipBuffer(file, level));
+        } else if (codec == CODEC_ZSTD) {
+#ifdef HEPMC3_WITH_ZSTD
+            buffer.reset(new ZstdBuffer(file, level, n_threads));
+#else
+            (void)n_threads;
+            error = "zstd support was not compiled in";
+#endif
+        } else {
+            error = "unknown compression codec " + std::to_string(codec);
+        }
+        if (buffer) {
+            if (buffer->failed()) error = buffer->error();
+            stream.rdbuf(buffer.get());
+        }
+        if (!error.empty()) stream.setstate(std::ios::badbit);
+    }
+
+    std::FILE* file;
+    std::unique_ptr<CompressingBuffer> buffer;
+    std::ostream stream;
+    std::string error;
+};
+
+// WriterAscii writing through a compressor. Handles are plain WriterAscii
+// pointers, so writer_write_event, writer_failed, writer_close and
+// delete_writer_ascii work on them unchanged.
+class CompressedWriterAscii : private CompressedStream, public WriterAscii {
+public:
+    CompressedWriterAscii(const std::string& filename, int codec, int level, int n_threads)
+        : CompressedStream(filename, codec, level, n_threads), WriterAscii(stream) {}
+
+    ~CompressedWriterAscii() override { close(); }
+
+    std::string error_message() const {
+        if (!error.empty()) return error;
+        return buffer ? buffer->error() : std::string();
+    }
+
+    bool failed() override {
+        return !error.empty() || (buffer && buffer->failed()) || WriterAscii::failed();
+    }
+
+    void close() override {
+        if (m_closed) return;
+        m_closed = true;
+        WriterAscii::close();
+        stream.flush();
+        if (buffer) buffer->finish();
+        if (file) std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    bool m_closed = false;
+};
+
+}  // namespace
+
+// Open a WriterAscii that compresses its output: codec 1 is gzip (levels
+// 0-9), codec 2 is zstd (levels 1-22, `n_threads` > 1 enables multi-threaded
+// compression). Use the result with writer_write_event, writer_failed,
+// writer_close and delete_writer_ascii.
+void* create_writer_ascii_compressed(const char* filename, int codec, int level, int n_threads) {
+    WriterAscii* writer = new CompressedWriterAscii(std::string(filename), codec, level, n_threads);
+    return writer;
+}
+
+// Message for a compressed writer that failed, empty otherwise.
+void* compressed_writer_error(void* writer) {
+    auto w = dynamic_cast<CompressedWriterAscii*>(static_cast<WriterAscii*>(writer));
+    if (!w) return stable_string_result(std::string());
+    return stable_string_result(w->error_message());
+}
+
+bool zstd_compression_available() {
+#ifdef HEPMC3_WITH_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Sharded writer
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum ShardMode {
+    SHARD_BY_COUNT = 1,   // rotate after `limit` events
+    SHARD_BY_BYTES = 2,   // rotate once a shard has written `limit` bytes
+    SHARD_BY_KEY = 3,     // one shard per key
+};
+
+struct Shard {
+    std::string file;
+    std::string key;
+    int64_t first = 0;          // index of the first event in submission order
+    int64_t events = 0;
+    int first_event_number = 0;
+    int last_event_number = 0;
+    int64_t bytes = 0;
+    int pushing = 0;            // pushes in progress outside the writer's lock
+    bool retiring = false;      // rotated out; stop the worker once `pushing` is 0
+    std::unique_ptr<AsyncWriter> writer;
+};
+
+// Keys end up in file names; keep them to portable characters.
+std::string sanitise_key(const std::string& key) {
+    std::string out = key.empty() ? std::string("none") : key;
+    for (char& c : out) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.') c = '_';
+    }
+    return out;
+}
+
+// Distributes events over AsyncWriters, one writer thread per open shard.
+// With rotation, a shard is asked to finish when the next one opens and is
+// closed for good one rotation later, so at most three rotating shards are
+// open at a time. Byte rotation checks what the shard has written so far, so
+// a shard can exceed `limit` by the events still in its queue.
+//
+// A push waits for room in its shard's queue without holding the writer's
+// lock, so a full shard only holds up the threads writing to it. Threads
+// writing to the same shard at once may queue their events in either order.
+class ShardedWriter {
+public:
+    ShardedWriter(const std::string& pattern, int mode, int64_t limit, const std::string& key_attribute,
+                  const std::string& manifest, int capacity)
+        : m_pattern(pattern), m_mode(mode), m_limit(limit), m_key_attribute(key_attribute),
+          m_manifest(manifest), m_capacity(capacity) {
+        if (mode != SHARD_BY_COUNT && mode != SHARD_BY_BYTES && mode != SHARD_BY_KEY) {
+            m_error = "unknown shard mode " + std::to_string(mode);
+        } else if (mode != SHARD_BY_KEY && limit <= 0) {
+            m_error = "shard limit must be positive";
+        } else if (pattern.find("{}") == std::string::npos) {
+            m_error = "file pattern must contain {}";
+        }
+    }
+
+    ~ShardedWriter() { close(); }
+
+    bool push(QueuedEvent&& item, int event_number, const std::string& key) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_error.empty() || m_closed) return false;
+        Shard* shard = select_shard(key, lock);
+        // Rotation may have let close() in, which finishes every shard
+        if (!shard || m_closed || !shard->writer) return false;
+        if (shard->events == 0) {
+            shard->first = m_submitted;
+            shard->first_event_number = event_number;
+        }
+        shard->events++;
+        shard->last_event_number = event_number;
+        m_submitted++;
+
+        // The shard stays open while `pushing` is set; see finish_shard.
+        // Deque elements keep their address as shards are added.
+        shard->pushing++;
+        AsyncWriter* writer = shard->writer.get();
+        lock.unlock();
+        const bool ok = writer->push(std::move(item));
+        lock.lock();
+        if (--shard->pushing == 0) {
+            if (shard->retiring) writer->begin_close();
+            m_pushed.notify_all();
+        }
+        if (!ok) {
+            record_failure(*shard);
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& key_attribute() const { return m_key_attribute; }
+    bool by_key() const { return m_mode == SHARD_BY_KEY; }
+
+    bool flush() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& shard : m_shards) {
+            if (shard.writer && !shard.writer->flush()) record_failure(shard);
+        }
+        return m_error.empty();
+    }
+
+    // Close every shard and write the manifest. Safe to call twice.
+    bool close() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_closed) return m_error.empty();
+        m_closed = true;
+        for (auto& shard : m_shards) finish_shard(shard, lock);
+        if (!m_manifest.empty() && !write_manifest()) {
+            if (m_error.empty()) m_error = "cannot write manifest " + m_manifest;
+        }
+        return m_error.empty();
+    }
+
+    bool failed() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return !m_error.empty();
+    }
+
+    std::string error() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    int shards_size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_shards.size();
+    }
+
+private:
+    Shard* select_shard(const std::string& key, std::unique_lock<std::mutex>& lock) {
+        if (m_mode == SHARD_BY_KEY) {
+            auto it = m_by_key.find(key);
+            if (it != m_by_key.end()) return &m_shards[it->second];
+            Shard* shard = open_shard(unique_label(sanitise_key(key)), key);
+            if (shard) m_by_key.emplace(key, m_shards.size() - 1);
+            return shard;
+        }
+
+        if (m_shards.empty()) return open_shard(shard_index(0), std::string());
+        Shard& current = m_shards.back();
+        const bool full = m_mode == SHARD_BY_COUNT ? current.events >= m_limit
+                                                    : current.writer->bytes() >= m_limit;
+        if (!full) return &current;
+        // Pushes still on their way into the full shard must land before its
+        // worker may stop; the last of them calls begin_close.
+        current.retiring = true;
+        if (current.pushing == 0) current.writer->begin_close();
+        const size_t retired = m_shards.size() - 1;
+        Shard* shard = open_shard(shard_index(m_shards.size()), std::string());
+        // Open the next shard first: finish_shard may let other threads in,
+        // and they must find a shard with room
+        if (shard && retired >= 1) finish_shard(m_shards[retired - 1], lock);
+        return shard ? &m_shards.back() : nullptr;
+    }
+
+    static std::string shard_index(size_t index) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "%04zu", index);
+        return label;
+    }
+
+    // Different keys can sanitise to the same label ("a/b" and "a_b", "" and
+    // "none"); later ones get a numeric suffix so no two shards share a file.
+    std::string unique_label(const std::string& label) {
+        std::string unique = label;
+        for (int n = 2; m_labels.count(unique); ++n) unique = label + "-" + std::to_string(n);
+        return unique;
+    }
+
+    Shard* open_shard(const std::string& label, const std::string& key) {
+        Shard shard;
+        shard.file = m_pattern;
+        shard.file.replace(shard.file.find("{}"), 2, label);
+        shard.key = key;
+        shard.writer.reset(new AsyncWriter(shard.file, m_capacity));
+        if (shard.writer->failed()) {
+            m_error = shard.writer->error();
+            return nullptr;
+        }
+        m_labels.insert(label);
+        m_shards.push_back(std::move(shard));
+        return &m_shards.back();
+    }
+
+    // Wait for pushes into the shard to land, then close it. The wait
+    // releases the lock.
+    void finish_shard(Shard& shard, std::unique_lock<std::mutex>& lock) {
+        m_pushed.wait(lock, [&] { return shard.pushing == 0; });
+        if (!shard.writer) return;
+        if (!shard.writer->close()) record_failure(shard);
+        shard.bytes = shard.writer->bytes();
+        shard.writer.reset();
+    }
+
+    void record_failure(Shard& shard) {
+        if (m_error.empty()) m_error = shard.file + ": " + shard.writer->error();
+    }
+
+    // Tab-separated: file, key, first event index, event count, first and
+    // last event number, bytes.
+    bool write_manifest() {
+        std::ofstream out(m_manifest);
+        if (!out) return false;
+        out << "file\tkey\tfirst\tevents\tfirst_event_number\tlast_event_number\tbytes\n";
+        for (const auto& shard : m_shards) {
+            out << shard.file << '\t' << shard.key << '\t' << shard.first << '\t' << shard.events << '\t'
+                << shard.first_event_number << '\t' << shard.last_event_number << '\t' << shard.bytes << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    const std::string m_pattern;
+    const int m_mode;
+    const int64_t m_limit;
+    const std::string m_key_attribute;
+    const std::string m_manifest;
+    const int m_capacity;
+    std::mutex m_mutex;
+    std::condition_variable m_pushed;   // a shard's `pushing` dropped to 0
+    std::deque<Shard> m_shards;
+    std::map<std::string, size_t> m_by_key;
+    std::set<std::string> m_labels;     // labels of the files opened so far
+    std::string m_error;
+    int64_t m_submitted = 0;
+    bool m_closed = false;
+};
+
+// Key of an event: the given key, or in key mode without one, the value of
+// the writer's key attribute.
+std::string shard_key(ShardedWriter* w, const GenEvent* e, const char* key) {
+    std::string k(key);
+    if (k.empty() && w->by_key() && !w->key_attribute().empty()) k = e->attribute_as_string(w->key_attribute());
+    return k;
+}
+
+}  // namespace
+
+// Open a sharded writer. `pattern` names the shard files and must contain
+// "{}", which is replaced by a four-digit shard index or, in key mode, by the
+// key. `limit` is the events (mode 1) or bytes (mode 2) per shard. In key
+// mode (3), events without an explicit key are routed by the value of the
+// event attribute `key_attribute`. When `manifest` is not empty, a
+// tab-separated shard list is written there on close.
+void* create_sharded_writer(const char* pattern, int mode, int64_t limit, const char* key_attribute,
+                            const char* manifest, int capacity) {
+    return new ShardedWriter(pattern, mode, limit, key_attribute, manifest, capacity);
+}
+
+// Snapshot `event` and queue it on its shard; `key` is used in key mode.
+bool sharded_writer_write_event(void* writer, void* event, const char* key) {
+    auto w = static_cast<ShardedWriter*>(writer);
+    auto e = static_cast<const GenEvent*>(event);
+    QueuedEvent item;
+    e->write_data(item.data);
+    item.run_info = e->run_info();
+    return w->push(std::move(item), e->event_number(), shard_key(w, e, key));
+}
+
+// Queue a shared event without copying; see async_writer_write_event_shared.
+bool sharded_writer_write_event_shared(void* writer, void* event, const char* key) {
+    auto w = static_cast<ShardedWriter*>(writer);
+    QueuedEvent item;
+    item.event = *static_cast<std::shared_ptr<GenEvent>*>(event);
+    const GenEvent* e = item.event.get();
+    return w->push(std::move(item), e->event_number(), shard_key(w, e, key));
+}
+
+bool sharded_writer_flush(void* writer) {
+    return static_cast<ShardedWriter*>(writer)->flush();
+}
+
+bool sharded_writer_close(void* writer) {
+    return static_cast<ShardedWriter*>(writer)->close();
+}
+
+bool sharded_writer_failed(void* writer) {
+    return static_cast<ShardedWriter*>(writer)->failed();
+}
+
+void* sharded_writer_error(void* writer) {
+    return stable_string_result(static_cast<ShardedWriter*>(writer)->error());
+}
+
+int sharded_writer_shards_size(void* writer) {
+    return static_cast<ShardedWriter*>(writer)->shards_size();
+}
+
+void delete_sharded_writer(void* writer) {
+    delete static_cast<ShardedWriter*>(writer);
+}
+
+// ---------------------------------------------------------------------------
+// Raw pass-through
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Writes the reader's header, copied event spans, and the footer on close.
+// Run info blocks read between events are copied in their place before the
+// next event written, or before the footer, even when the events around them
+// are not written.
+class RawEventWriter {
+public:
+    RawEventWriter(const std::string& filename, const RawEventReader& reader)
+        : m_out(filename, std::ios::binary), m_reader(reader) {
+        m_out << reader.header();
+    }
+
+    ~RawEventWriter() { close(); }
+
+    bool write_current() {
+        if (m_closed) return false;
+        write_run_info(m_reader.run_info_before());
+        m_out << m_reader.text();
+        return static_cast<bool>(m_out);
+    }
+
+    bool close() {
+        if (m_closed) return static_cast<bool>(m_out);
+        m_closed = true;
+        write_run_info(m_reader.run_info().size());
+        // Inputs cut off before their footer still produce a complete listing
+        m_out << (m_reader.footer().empty() ? std::string("HepMC::Asciiv3-END_EVENT_LISTING\n\n") : m_reader.footer());
+        m_out.close();
+        return !m_out.fail();
+    }
+
+    bool failed() const { return !m_out; }
+
+private:
+    void write_run_info(size_t end) {
+        if (end <= m_run_info_written) return;
+        m_out.write(m_reader.run_info().data() + m_run_info_written, end - m_run_info_written);
+        m_run_info_written = end;
+    }
+
+    std::ofstream m_out;
+    const RawEventReader& m_reader;
+    size_t m_run_info_written = 0;
+    bool m_closed = false;
+};
+
+}  // namespace
+
+// Open an ASCII file for raw reading; nullptr if it cannot be opened.
+void* create_raw_event_reader(const char* filename) {
+    auto reader = new RawEventReader(filename);
+    if (!reader->ok()) {
+        delete reader;
+        return nullptr;
+    }
+    return reader;
+}
+
+// Advance to the next event; false at the end of the file.
+bool raw_reader_next(void* reader) {
+    return static_cast<RawEventReader*>(reader)->next();
+}
+
+// Event number, vertex count and particle count of the current event.
+void raw_reader_event_info(void* reader, int* out) {
+    auto r = static_cast<RawEventReader*>(reader);
+    out[0] = r->event_number;
+    out[1] = r->n_vertices;
+    out[2] = r->pid.size();
+}
+
+// Copy the particle view of the current event; `momenta` holds four doubles
+// (px, py, pz, e) per particle.
+void copy_raw_reader_particles(void* reader, int* pid, int* status, int* parent, double* momenta, double* mass) {
+    auto r = static_cast<RawEventReader*>(reader);
+    std::copy(r->pid.begin(), r->pid.end(), pid);
+    std::copy(r->status.begin(), r->status.end(), status);
+    std::copy(r->parent.begin(), r->parent.end(), parent);
+    std::copy(r->momenta.begin(), r->momenta.end(), momenta);
+    std::copy(r->mass.begin(), r->mass.end(), mass);
+}
+
+// Fully parse the current event into `event` with ReaderAscii, for decisions
+// that need more than the light view.
+bool raw_reader_parse_event(void* reader, void* event) {
+    auto r = static_cast<RawEventReader*>(reader);
+    auto stream = std::make_shared<std::istringstream>(r->header() + r->run_info().substr(0, r->run_info_before()) + r->text() +
+                                                       "HepMC::Asciiv3-END_EVENT_LISTING\n");
+    ReaderAscii ascii(stream);
+    ascii.read_event(*static_cast<GenEvent*>(event));
+    note_event_modified(static_cast<GenEvent*>(event));
+    if (ascii.failed()) return false;
+    account_native_memory(*static_cast<GenEvent*>(event));
+    return true;
+}
+
+void* raw_reader_text(void* reader) {
+    return stable_string_result(static_cast<RawEventReader*>(reader)->text());
+}
+
+void delete_raw_event_reader(void* reader) {
+    delete static_cast<RawEventReader*>(reader);
+}
+
+// Open `filename` and write the header of `reader`'s input to it. The writer
+// refers to the reader, which must outlive it.
+void* create_raw_event_writer(const char* filename, void* reader) {
+    return new RawEventWriter(filename, *static_cast<RawEventReader*>(reader));
+}
+
+// Copy the reader's current event text unchanged.
+bool raw_writer_write_current(void* writer) {
+    return static_cast<RawEventWriter*>(writer)->write_current();
+}
+
+bool raw_writer_failed(void* writer) {
+    return static_cast<RawEventWriter*>(writer)->failed();
+}
+
+bool raw_writer_close(void* writer) {
+    return static_cast<RawEventWriter*>(writer)->close();
+}
+
+void delete_raw_event_writer(void* writer) {
+    delete static_cast<RawEventWriter*>(writer);
+}
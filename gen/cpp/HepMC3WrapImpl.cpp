@@ -1,4 +1,5 @@
 #include "HepMC3Wrap.h"
+#include "HepMC3WrapMemory.h"
 #include "HepMC3/GenEvent.h"
 #include "HepMC3/GenParticle.h"
 #include "HepMC3/GenVertex.h"
@@ -13,10 +14,15 @@
 #include <memory>
 #include <stdexcept>
 #include <utility>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 using namespace HepMC3;
 
-static void* stable_string_result(std::string value) {
+void* stable_string_result(std::string value) {
     static thread_local std::string storage;
     storage = std::move(value);
     return const_cast<char*>(storage.c_str());
@@ -38,18 +44,21 @@ void add_shared_particle_in(void* vertex, void* particle) {
     auto v = static_cast<std::shared_ptr<GenVertex>*>(vertex);
     auto p = static_cast<std::shared_ptr<GenParticle>*>(particle);
     (*v)->add_particle_in(*p);
+    note_event_modified((*v)->parent_event());
 }
 
 void add_shared_particle_out(void* vertex, void* particle) {
     auto v = static_cast<std::shared_ptr<GenVertex>*>(vertex);
     auto p = static_cast<std::shared_ptr<GenParticle>*>(particle);
     (*v)->add_particle_out(*p);
+    note_event_modified((*v)->parent_event());
 }
 
 void add_shared_vertex_to_event(void* event, void* vertex) {
     auto e = static_cast<GenEvent*>(event);
     auto v = static_cast<std::shared_ptr<GenVertex>*>(vertex);
     e->add_vertex(*v);
+    note_event_modified(e);
 }
 
 // Vector operations
@@ -84,7 +93,12 @@ bool reader_read_event(void* reader, void* event) {
     }
 
     r->read_event(*e);
-    return !r->failed();
+    note_event_modified(e);
+    if (r->failed()) {
+        return false;
+    }
+    account_native_memory(*e);
+    return true;
 }
 
 bool reader_failed(void* reader) {
@@ -251,6 +265,7 @@ void remove_particle_from_event(void* event, void* particle) {
     auto e = static_cast<HepMC3::GenEvent*>(event);
     auto p = static_cast<std::shared_ptr<HepMC3::GenParticle>*>(particle);
     e->remove_particle(*p);
+    note_event_modified(e);
 }
 
 
@@ -529,6 +544,49 @@ void* get_vertex_at_raw(void* event, int index) {
 
 
 // Run info support
+
+// Packed run info string tables are cached per GenRunInfo. The map is keyed by the owning
+// control block rather than the object address, so a run info allocated where
+// a destroyed one used to live never sees the old entry. Each entry also keeps
+// the strings it was packed from and is repacked when the run info has been
+// edited in place, e.g. by a reader that meets a new weight-name header.
+struct RunInfoTables {
+    bool has_weight_names = false;
+    bool has_tools = false;
+    std::vector<std::string> weight_names;
+    std::vector<HepMC3::GenRunInfo::ToolInfo> tools;
+    std::vector<unsigned char> packed_weight_names;
+    std::vector<unsigned char> packed_tools;
+};
+
+using RunInfoOwner = std::weak_ptr<HepMC3::GenRunInfo>;
+
+static std::mutex run_info_tables_mutex;
+static std::map<RunInfoOwner, RunInfoTables, std::owner_less<>> run_info_tables;
+static size_t run_info_tables_sweep_at = 64;
+
+static RunInfoTables& run_info_tables_for(const std::shared_ptr<HepMC3::GenRunInfo>& ri) {
+    auto it = run_info_tables.find(ri);
+    if (it != run_info_tables.end()) {
+        return it->second;
+    }
+    if (run_info_tables.size() >= run_info_tables_sweep_at) {
+        for (auto entry = run_info_tables.begin(); entry != run_info_tables.end();) {
+            entry = entry->first.expired() ? run_info_tables.erase(entry) : std::next(entry);
+        }
+        run_info_tables_sweep_at = std::max<size_t>(64, 2 * run_info_tables.size());
+    }
+    return run_info_tables.emplace(RunInfoOwner(ri), RunInfoTables{}).first->second;
+}
+
+static void forget_run_info_tables(const std::shared_ptr<HepMC3::GenRunInfo>& ri) {
+    std::lock_guard<std::mutex> lock(run_info_tables_mutex);
+    auto it = run_info_tables.find(ri);
+    if (it != run_info_tables.end()) {
+        run_info_tables.erase(it);
+    }
+}
+
 void* create_gen_run_info() {
     return new std::shared_ptr<HepMC3::GenRunInfo>(std::make_shared<HepMC3::GenRunInfo>());
 }
@@ -560,6 +618,7 @@ void* get_event_run_info_shared(void* event) {
 void clear_run_info_weight_names(void* run_info) {
     auto ri = static_cast<std::shared_ptr<HepMC3::GenRunInfo>*>(run_info);
     (*ri)->set_weight_names({});
+    forget_run_info_tables(*ri);
 }
 
 void add_run_info_weight_name(void* run_info, const char* name) {
@@ -567,6 +626,7 @@ void add_run_info_weight_name(void* run_info, const char* name) {
     std::vector<std::string> weight_names = (*ri)->weight_names();
     weight_names.push_back(std::string(name));
     (*ri)->set_weight_names(weight_names);
+    forget_run_info_tables(*ri);
 }
 
 int get_run_info_weight_names_size(void* run_info) {
@@ -596,6 +656,7 @@ int run_info_weight_index(void* run_info, const char* name) {
 void add_run_info_tool(void* run_info, const char* name, const char* version, const char* description) {
     auto ri = static_cast<std::shared_ptr<HepMC3::GenRunInfo>*>(run_info);
     (*ri)->tools().push_back({std::string(name), std::string(version), std::string(description)});
+    forget_run_info_tables(*ri);
 }
 
 int get_run_info_tools_size(void* run_info) {
@@ -630,6 +691,84 @@ void* get_run_info_tool_description(void* run_info, int index) {
     return stable_string_result(tools[index].description);
 }
 
+// Bulk run info string export. Strings are packed back to back into `buffer`
+// and string i spans [offsets[i], offsets[i + 1]).
+static void pack_strings(const std::vector<const std::string*>& strings, unsigned char* buffer, int* offsets) {
+    int offset = 0;
+    offsets[0] = 0;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        const std::string& s = *strings[i];
+        std::memcpy(buffer + offset, s.data(), s.size());
+        offset += static_cast<int>(s.size());
+        offsets[i + 1] = offset;
+    }
+}
+
+// A table is laid out as n + 1 int offsets followed by the string bytes.
+static void pack_table(const std::vector<const std::string*>& strings, std::vector<unsigned char>& table) {
+    size_t header = (strings.size() + 1) * sizeof(int);
+    size_t n_bytes = 0;
+    for (const std::string* s : strings) {
+        n_bytes += s->size();
+    }
+    table.assign(header + n_bytes, 0);
+    pack_strings(strings, table.data() + header, reinterpret_cast<int*>(table.data()));
+}
+
+static bool same_tools(const std::vector<HepMC3::GenRunInfo::ToolInfo>& a,
+                       const std::vector<HepMC3::GenRunInfo::ToolInfo>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].version != b[i].version || a[i].description != b[i].description) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* run_info_weight_names_table(void* run_info, int64_t* out) {
+    auto ri = static_cast<std::shared_ptr<HepMC3::GenRunInfo>*>(run_info);
+    const auto& names = (*ri)->weight_names();
+    std::lock_guard<std::mutex> lock(run_info_tables_mutex);
+    RunInfoTables& tables = run_info_tables_for(*ri);
+    if (!tables.has_weight_names || tables.weight_names != names) {
+        tables.weight_names = names;
+        std::vector<const std::string*> strings;
+        strings.reserve(names.size());
+        for (const auto& name : names) {
+            strings.push_back(&name);
+        }
+        pack_table(strings, tables.packed_weight_names);
+        tables.has_weight_names = true;
+    }
+    out[0] = static_cast<int64_t>(names.size());
+    return tables.packed_weight_names.data();
+}
+
+// Tools are exported as (name, version, description) triples, 3 strings per tool.
+void* run_info_tools_table(void* run_info, int64_t* out) {
+    auto ri = static_cast<std::shared_ptr<HepMC3::GenRunInfo>*>(run_info);
+    const auto& tools = static_cast<const HepMC3::GenRunInfo&>(**ri).tools();
+    std::lock_guard<std::mutex> lock(run_info_tables_mutex);
+    RunInfoTables& tables = run_info_tables_for(*ri);
+    if (!tables.has_tools || !same_tools(tables.tools, tools)) {
+        tables.tools = tools;
+        std::vector<const std::string*> strings;
+        strings.reserve(3 * tools.size());
+        for (const auto& tool : tools) {
+            strings.push_back(&tool.name);
+            strings.push_back(&tool.version);
+            strings.push_back(&tool.description);
+        }
+        pack_table(strings, tables.packed_tools);
+        tables.has_tools = true;
+    }
+    out[0] = static_cast<int64_t>(tools.size());
+    return tables.packed_tools.data();
+}
+
 
 
 
@@ -678,6 +817,7 @@ void* read_all_events_from_file(const char* filename, int max_events) {
             break;
         }
 
+        account_native_memory(*event);
         events->push_back(event);
         event_count++;
     }
@@ -709,6 +849,13 @@ int get_event_number_shared(void* event) {
     return (*e)->event_number();
 }
 
+// Underlying GenEvent* of an event pointer returned by read_hepmc_file, for
+// functions that take raw events.
+void* get_event_pointer_shared(void* event) {
+    auto e = static_cast<std::shared_ptr<HepMC3::GenEvent>*>(event);
+    return e->get();
+}
+
 double* get_event_weights_shared(void* event, int* n_weights) {
     auto e = static_cast<std::shared_ptr<HepMC3::GenEvent>*>(event);
     auto& weights = (*e)->weights();
@@ -0,0 +1,391 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapEngine.h"
+#include "HepMC3/FourVector.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenPdfInfo.h"
+#include "HepMC3/GenVertex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Lorentz transforms
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Run body(begin, end) over [0, n) split into contiguous ranges, one per
+// thread (all cores when n_threads is 0). The first exception is rethrown.
+template <class Body>
+void parallel_ranges(int64_t n, int n_threads, const Body& body) {
+    int64_t workers = n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = std::max<int64_t>(1, std::min(workers, n));
+    if (workers == 1) {
+        body(int64_t(0), n);
+        return;
+    }
+    std::vector<std::exception_ptr> errors(workers);
+    std::vector<std::thread> threads;
+    for (int64_t w = 0; w < workers; ++w) {
+        threads.emplace_back([&, w] {
+            try {
+                body(n * w / workers, n * (w + 1) / workers);
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+void check_beta(double bx, double by, double bz, int64_t event) {
+    if (!(bx * bx + by * by + bz * bz < 1.0)) {
+        throw std::invalid_argument("boost of event " + std::to_string(event + 1) + " is not slower than light");
+    }
+}
+
+// Boost n momenta by the velocity (bx, by, bz), as GenEvent::boost does. The
+// loop has no branches or aliasing, so it compiles to packed SIMD arithmetic.
+void boost_range(double* __restrict px, double* __restrict py, double* __restrict pz, double* __restrict e,
+                 size_t n, double bx, double by, double bz) {
+    const double b2 = bx * bx + by * by + bz * bz;
+    if (b2 == 0.0) return;
+    const double gamma = 1.0 / std::sqrt(1.0 - b2);
+    const double factor = (gamma - 1.0) / b2;
+    for (size_t i = 0; i < n; ++i) {
+        const double bp = bx * px[i] + by * py[i] + bz * pz[i];
+        const double shift = factor * bp + gamma * e[i];
+        px[i] += shift * bx;
+        py[i] += shift * by;
+        pz[i] += shift * bz;
+        e[i] = gamma * (e[i] + bp);
+    }
+}
+
+// Beam particles: status 4, in event order
+std::vector<ConstGenParticlePtr> beam_particles(const GenEvent& event) {
+    std::vector<ConstGenParticlePtr> beams;
+    for (const auto& particle : event.particles()) {
+        if (particle->status() == 4) beams.push_back(particle);
+    }
+    return beams;
+}
+
+}  // namespace
+
+// Boost momentum columns event by event: the particles of event k are
+// [offsets[k], offsets[k + 1]) and are boosted by the velocity
+// (beta[3k], beta[3k + 1], beta[3k + 2]). Events are shared out over
+// `n_threads` threads (all cores when 0).
+void boost_momentum_columns(double* px, double* py, double* pz, double* e, int64_t* offsets, int64_t n_events,
+                            double* beta, int n_threads) {
+    for (int64_t k = 0; k < n_events; ++k) {
+        if (offsets[k + 1] < offsets[k]) throw std::invalid_argument("event offsets must not decrease");
+        check_beta(beta[3 * k], beta[3 * k + 1], beta[3 * k + 2], k);
+    }
+    parallel_ranges(n_events, n_threads, [&](int64_t first, int64_t last) {
+        for (int64_t k = first; k < last; ++k) {
+            const int64_t begin = offsets[k];
+            boost_range(px + begin, py + begin, pz + begin, e + begin, offsets[k + 1] - begin,
+                        beta[3 * k], beta[3 * k + 1], beta[3 * k + 2]);
+        }
+    });
+}
+
+// Boost the particle momenta of each of `events` (raw GenEvent pointers) by
+// its own velocity, like GenEvent::boost. Momenta are gathered into columns
+// per event so the transform itself runs in boost_range.
+void boost_events(void** events, int64_t n_events, double* beta, int n_threads) {
+    for (int64_t k = 0; k < n_events; ++k) check_beta(beta[3 * k], beta[3 * k + 1], beta[3 * k + 2], k);
+    parallel_ranges(n_events, n_threads, [&](int64_t first, int64_t last) {
+        std::vector<double> px, py, pz, e;
+        for (int64_t k = first; k < last; ++k) {
+            auto evt = static_cast<GenEvent*>(events[k]);
+            const auto& particles = evt->particles();
+            const size_t n = particles.size();
+            px.resize(n);
+            py.resize(n);
+            pz.resize(n);
+            e.resize(n);
+            for (size_t i = 0; i < n; ++i) {
+                const FourVector& p = particles[i]->momentum();
+                px[i] = p.px();
+                py[i] = p.py();
+                pz[i] = p.pz();
+                e[i] = p.e();
+            }
+            boost_range(px.data(), py.data(), pz.data(), e.data(), n, beta[3 * k], beta[3 * k + 1], beta[3 * k + 2]);
+            for (size_t i = 0; i < n; ++i) particles[i]->set_momentum(FourVector(px[i], py[i], pz[i], e[i]));
+        }
+    });
+}
+
+// Per event, the velocity that boosts it to the rest frame of its beam
+// particles (status 4), written to beta[3k .. 3k + 2]. With `partonic`, the
+// two beams are scaled by the momentum fractions x of the event's GenPdfInfo,
+// giving the rest frame of the incoming partons.
+void beam_boost_vectors(void** events, int64_t n_events, bool partonic, double* beta) {
+    for (int64_t k = 0; k < n_events; ++k) {
+        const auto evt = static_cast<const GenEvent*>(events[k]);
+        const auto beams = beam_particles(*evt);
+        double fraction[2] = {1.0, 1.0};
+        if (partonic) {
+            const auto pdf = evt->attribute<GenPdfInfo>("GenPdfInfo");
+            if (!pdf) throw std::runtime_error("event " + std::to_string(evt->event_number()) + " has no GenPdfInfo");
+            if (beams.size() != 2) {
+                throw std::runtime_error("event " + std::to_string(evt->event_number()) + " does not have two beams");
+            }
+            fraction[0] = pdf->x[0];
+            fraction[1] = pdf->x[1];
+        } else if (beams.empty()) {
+            throw std::runtime_error("event " + std::to_string(evt->event_number()) + " has no beam particles");
+        }
+
+        double px = 0.0, py = 0.0, pz = 0.0, e = 0.0;
+        for (size_t i = 0; i < beams.size(); ++i) {
+            const FourVector& p = beams[i]->momentum();
+            const double f = i < 2 ? fraction[i] : 1.0;
+            px += f * p.px();
+            py += f * p.py();
+            pz += f * p.pz();
+            e += f * p.e();
+        }
+        if (!(e > 0.0)) throw std::runtime_error("event " + std::to_string(evt->event_number()) + " has no beam energy");
+        beta[3 * k] = -px / e;
+        beta[3 * k + 1] = -py / e;
+        beta[3 * k + 2] = -pz / e;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Momentum and position arrays
+// ---------------------------------------------------------------------------
+
+// Copy (px, py, pz, e) of every particle of `event`, in particle order, to
+// `out` (4 doubles per particle). The layout matches an array of Julia
+// LorentzVectors.
+void copy_event_momenta(void* event, double* out) {
+    for (const auto& particle : static_cast<GenEvent*>(event)->particles()) {
+        const FourVector& p = particle->momentum();
+        *out++ = p.px();
+        *out++ = p.py();
+        *out++ = p.pz();
+        *out++ = p.e();
+    }
+}
+
+// Copy (x, y, z, t) of every vertex of `event`, in vertex order, to `out`
+void copy_event_positions(void* event, double* out) {
+    for (const auto& vertex : static_cast<GenEvent*>(event)->vertices()) {
+        const FourVector position = vertex->position();
+        *out++ = position.x();
+        *out++ = position.y();
+        *out++ = position.z();
+        *out++ = position.t();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Pair kernels
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum PairQuantity { PAIR_DELTA_R = 0, PAIR_DELTA_R_RAP = 1, PAIR_MASS = 2 };
+
+// Pairs (i, j), i < j, are numbered row by row: (0, 1), (0, 2), ..., (1, 2), ...
+int64_t pair_row_offset(int64_t n, int64_t i) {
+    return i * (2 * n - i - 1) / 2;
+}
+
+// Per-particle inputs of one pair quantity, as contiguous columns: η or y and
+// φ for the ΔR kinds, the momenta for the mass. η and y follow FourVector.
+class PairColumns {
+public:
+    PairColumns(int quantity, int64_t n, const double* px, const double* py, const double* pz, const double* e,
+                int64_t stride)
+        : m_quantity(quantity), m_n(n) {
+        if (quantity < PAIR_DELTA_R || quantity > PAIR_MASS) throw std::invalid_argument("unknown pair quantity");
+        if (n < 0 || stride < 1) throw std::invalid_argument("bad particle count or stride");
+        if (quantity == PAIR_MASS) {
+            m_columns.assign(4, std::vector<double>(n));
+        } else {
+            m_columns.assign(2, std::vector<double>(n));
+        }
+        for (int64_t k = 0; k < n; ++k) {
+            const FourVector p(px[k * stride], py[k * stride], pz[k * stride], e[k * stride]);
+            if (quantity == PAIR_MASS) {
+                m_columns[0][k] = p.px();
+                m_columns[1][k] = p.py();
+                m_columns[2][k] = p.pz();
+                m_columns[3][k] = p.e();
+            } else {
+                m_columns[0][k] = quantity == PAIR_DELTA_R ? p.eta() : p.rap();
+                m_columns[1][k] = p.phi();
+            }
+        }
+    }
+
+    // Values of the pairs (i, j) for j = i + 1 .. n - 1, to out[0 .. n - i - 2].
+    // Both loops vectorise given -fno-math-errno and -fno-trapping-math, which
+    // CMakeLists.txt sets for this file.
+    void row(int64_t i, double* __restrict out) const {
+        const int64_t first = i + 1, count = m_n - first;
+        if (m_quantity == PAIR_MASS) {
+            const double* __restrict px = m_columns[0].data() + first;
+            const double* __restrict py = m_columns[1].data() + first;
+            const double* __restrict pz = m_columns[2].data() + first;
+            const double* __restrict e = m_columns[3].data() + first;
+            const double xi = m_columns[0][i], yi = m_columns[1][i], zi = m_columns[2][i], ei = m_columns[3][i];
+            for (int64_t j = 0; j < count; ++j) {
+                const double sx = xi + px[j], sy = yi + py[j], sz = zi + pz[j], se = ei + e[j];
+                const double m2 = se * se - sx * sx - sy * sy - sz * sz;
+                out[j] = std::copysign(std::sqrt(std::fabs(m2)), m2);   // negative when space-like, as FourVector::m
+            }
+        } else {
+            const double* __restrict rapidity = m_columns[0].data() + first;
+            const double* __restrict phi = m_columns[1].data() + first;
+            const double ri = m_columns[0][i], phii = m_columns[1][i];
+            const double pi = 3.14159265358979323846, two_pi = 2.0 * pi;
+            for (int64_t j = 0; j < count; ++j) {
+                double dphi = phii - phi[j];
+                dphi = dphi >= pi ? dphi - two_pi : dphi;
+                dphi = dphi < -pi ? dphi + two_pi : dphi;
+                const double drap = ri - rapidity[j];
+                out[j] = std::sqrt(drap * drap + dphi * dphi);
+            }
+        }
+    }
+
+private:
+    int m_quantity;
+    int64_t m_n;
+    std::vector<std::vector<double>> m_columns;
+};
+
+// Row ranges of the pair triangle for up to `n_threads` threads (all cores
+// when 0), each with about the same number of pairs: part k is rows
+// [bounds[k], bounds[k + 1]). Small inputs get one part.
+std::vector<int64_t> pair_row_bounds(int64_t n, int n_threads) {
+    const int64_t pairs = pair_row_offset(n, n);
+    const int64_t min_pairs_per_thread = 1 << 15;
+    int64_t parts = n_threads > 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency());
+    parts = std::max<int64_t>(1, std::min(parts, pairs / min_pairs_per_thread));
+    std::vector<int64_t> bounds{0};
+    for (int64_t i = 0, k = 1; i < n && k < parts; ++i) {
+        if (pair_row_offset(n, i + 1) >= pairs * k / parts) {
+            bounds.push_back(i + 1);
+            ++k;
+        }
+    }
+    bounds.push_back(n);
+    return bounds;
+}
+
+struct PairList {
+    std::vector<int64_t> first;
+    std::vector<int64_t> second;
+    std::vector<double> values;
+};
+
+}  // namespace
+
+// Copy the momenta of the particles of `event` accepted by the selection
+// (as for run_event_engine) to `out`, 4 doubles per particle, and their ids
+// to `ids`. Both must have room for every particle. Returns the number
+// selected.
+int select_particle_momenta(void* event, int status, int* abs_pdg, int n_pdg, double pt_min, double abs_eta_max,
+                            int* ids, double* out) {
+    ParticleSelection selection;
+    selection.status = status;
+    if (n_pdg > 0) selection.abs_pdg.assign(abs_pdg, abs_pdg + n_pdg);
+    selection.pt_min = pt_min;
+    selection.abs_eta_max = abs_eta_max;
+    int n = 0;
+    for (const auto& particle : static_cast<GenEvent*>(event)->particles()) {
+        if (!selection.accepts(*particle)) continue;
+        const FourVector& p = particle->momentum();
+        ids[n] = particle->id();
+        out[4 * n] = p.px();
+        out[4 * n + 1] = p.py();
+        out[4 * n + 2] = p.pz();
+        out[4 * n + 3] = p.e();
+        ++n;
+    }
+    return n;
+}
+
+// Fill `out` with the packed upper triangle of a pair quantity (ΔR in η or
+// in rapidity, or the invariant mass of the pair) over `n` momenta, pairs
+// ordered as (0, 1), (0, 2), ..., (1, 2), ...: n (n - 1) / 2 values. Momentum
+// k is (px[k * stride], py[k * stride], pz[k * stride], e[k * stride]).
+void fill_pair_matrix(int quantity, int64_t n, double* px, double* py, double* pz, double* e, int64_t stride,
+                      double* out, int n_threads) {
+    const PairColumns columns(quantity, n, px, py, pz, e, stride);
+    const auto bounds = pair_row_bounds(n, n_threads);
+    const int64_t parts = bounds.size() - 1;
+    parallel_ranges(parts, parts, [&](int64_t first, int64_t last) {
+        for (int64_t i = bounds[first]; i < bounds[last]; ++i) columns.row(i, out + pair_row_offset(n, i));
+    });
+}
+
+// Pairs whose quantity lies strictly between `low` and `high`, ordered as in
+// fill_pair_matrix. Returns a list for pair_list_size and copy_pair_list.
+void* find_particle_pairs(int quantity, int64_t n, double* px, double* py, double* pz, double* e, int64_t stride,
+                          double low, double high, int n_threads) {
+    const PairColumns columns(quantity, n, px, py, pz, e, stride);
+    const auto bounds = pair_row_bounds(n, n_threads);
+    const int64_t n_parts = bounds.size() - 1;
+    std::vector<PairList> parts(n_parts);
+    parallel_ranges(n_parts, n_parts, [&](int64_t first, int64_t last) {
+        std::vector<double> row(n);
+        for (int64_t part = first; part < last; ++part) {
+            PairList& found = parts[part];
+            for (int64_t i = bounds[part]; i < bounds[part + 1]; ++i) {
+                columns.row(i, row.data());
+                for (int64_t j = 0; j < n - i - 1; ++j) {
+                    if (row[j] > low && row[j] < high) {
+                        found.first.push_back(i);
+                        found.second.push_back(i + 1 + j);
+                        found.values.push_back(row[j]);
+                    }
+                }
+            }
+        }
+    });
+
+    auto list = new PairList;
+    for (int64_t part = 0; part < n_parts; ++part) {
+        list->first.insert(list->first.end(), parts[part].first.begin(), parts[part].first.end());
+        list->second.insert(list->second.end(), parts[part].second.begin(), parts[part].second.end());
+        list->values.insert(list->values.end(), parts[part].values.begin(), parts[part].values.end());
+    }
+    return list;
+}
+
+int64_t pair_list_size(void* list) {
+    return static_cast<PairList*>(list)->values.size();
+}
+
+// Copy the pairs as 0-based momentum indices and their values
+void copy_pair_list(void* list, int64_t* first, int64_t* second, double* values) {
+    const auto pairs = static_cast<PairList*>(list);
+    std::copy(pairs->first.begin(), pairs->first.end(), first);
+    std::copy(pairs->second.begin(), pairs->second.end(), second);
+    std::copy(pairs->values.begin(), pairs->values.end(), values);
+}
+
+void delete_pair_list(void* list) {
+    delete static_cast<PairList*>(list);
+}
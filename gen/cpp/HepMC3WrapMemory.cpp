@@ -0,0 +1,405 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapMemory.h"
+#include "HepMC3WrapAttributes.h"
+#include "HepMC3/Attribute.h"
+#include "HepMC3/GenCrossSection.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenHeavyIon.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenPdfInfo.h"
+#include "HepMC3/GenVertex.h"
+#include "HepMC3/ReaderAscii.h"
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Event pool
+// ---------------------------------------------------------------------------
+
+EventPool::EventPool(size_t max_idle) : m_state(std::make_shared<State>()) {
+    m_state->max_idle = max_idle;
+}
+
+EventPool::~EventPool() {
+    // Events still in use are freed when released
+    std::vector<GenEvent*> idle;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->closed = true;
+        idle.swap(m_state->idle);
+    }
+    NativeMemory::pooled_events -= idle.size();
+    for (GenEvent* event : idle) delete event;
+}
+
+std::shared_ptr<GenEvent> EventPool::acquire() {
+    GenEvent* event = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->idle.empty()) {
+            event = m_state->idle.back();
+            m_state->idle.pop_back();
+            --NativeMemory::pooled_events;
+        }
+    }
+    if (event) {
+        ++m_state->hits;
+    } else {
+        event = new GenEvent;
+        ++m_state->misses;
+    }
+    std::shared_ptr<State> state = m_state;
+    return std::shared_ptr<GenEvent>(event, [state](GenEvent* e) { state->release(e); });
+}
+
+void EventPool::State::release(GenEvent* event) {
+    // Back to the state of a new GenEvent; clear() keeps vector capacity
+    event->clear();
+    event->set_run_info(nullptr);
+    event->set_units(Units::GEV, Units::MM);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!closed && idle.size() < max_idle) {
+            idle.push_back(event);
+            ++NativeMemory::pooled_events;
+            ++released;
+            return;
+        }
+    }
+    ++discarded;
+    delete event;
+}
+
+void EventPool::stats(int64_t* out) const {
+    out[0] = m_state->hits;
+    out[1] = m_state->misses;
+    out[2] = m_state->released;
+    out[3] = m_state->discarded;
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    out[4] = m_state->idle.size();
+}
+
+void* create_event_pool(int max_idle) {
+    return new EventPool(max_idle > 0 ? max_idle : 0);
+}
+
+// hits, misses, released, discarded, idle
+void event_pool_counts(void* pool, int64_t* out) {
+    static_cast<EventPool*>(pool)->stats(out);
+}
+
+void delete_event_pool(void* pool) {
+    delete static_cast<EventPool*>(pool);
+}
+
+// A cleared event from the pool, as an event pointer like those of
+// read_hepmc_file.
+void* event_pool_acquire(void* pool) {
+    return new std::shared_ptr<GenEvent>(static_cast<EventPool*>(pool)->acquire());
+}
+
+// Free an event pointer from read_hepmc_file or the pool functions. Pooled
+// events go back to their pool once no other reference remains.
+void release_event_shared(void* event) {
+    delete static_cast<std::shared_ptr<GenEvent>*>(event);
+}
+
+// read_all_events_from_file, filling events from `pool` and applying the
+// attribute `policy` to each event. Either may be null.
+void* read_all_events_from_file_pooled(const char* filename, int max_events, void* pool, void* policy) {
+    auto p = static_cast<EventPool*>(pool);
+    auto rules = static_cast<const AttributePolicy*>(policy);
+    ReaderAscii reader(filename);
+    if (reader.failed()) return nullptr;
+
+    auto events = new std::vector<std::shared_ptr<GenEvent>>();
+    while (!reader.failed() && (max_events < 0 || static_cast<int>(events->size()) < max_events)) {
+        auto event = p ? p->acquire() : std::make_shared<GenEvent>();
+        reader.read_event(*event);
+        if (reader.failed()) break;   // the unused event returns to the pool
+        if (rules) rules->apply(*event);
+        account_native_memory(*event);
+        events->push_back(event);
+    }
+    return events;
+}
+
+// Read the next event of a ReaderAscii handle into an event from `pool`,
+// applying the attribute `policy` unless it is null. Returns an event
+// pointer, or nullptr at the end of the file.
+void* reader_read_event_pooled(void* reader, void* pool, void* policy) {
+    auto r = static_cast<ReaderAscii*>(reader);
+    if (r->failed()) return nullptr;
+    auto event = static_cast<EventPool*>(pool)->acquire();
+    r->read_event(*event);
+    if (r->failed()) return nullptr;
+    if (policy) static_cast<const AttributePolicy*>(policy)->apply(*event);
+    account_native_memory(*event);
+    return new std::shared_ptr<GenEvent>(event);
+}
+
+// ---------------------------------------------------------------------------
+// Event arenas
+// ---------------------------------------------------------------------------
+
+EventArena::EventArena(size_t block_size) : m_block_size(std::max<size_t>(block_size, 1024)) {
+    ++NativeMemory::arenas;
+}
+
+EventArena::~EventArena() {
+    for (char* block : m_blocks) delete[] block;
+    NativeMemory::arena_bytes -= m_reserved;
+    --NativeMemory::arenas;
+}
+
+void* EventArena::allocate(size_t bytes, size_t alignment) {
+    void* p = m_next;
+    if (!std::align(alignment, bytes, p, m_left)) {
+        add_block(bytes + alignment);
+        p = m_next;
+        std::align(alignment, bytes, p, m_left);
+    }
+    m_next = static_cast<char*>(p) + bytes;
+    m_left -= bytes;
+    m_used += bytes;
+    return p;
+}
+
+void EventArena::add_block(size_t min_size) {
+    const size_t size = std::max(m_block_size, min_size);
+    m_blocks.push_back(new char[size]);
+    m_next = m_blocks.back();
+    m_left = size;
+    m_reserved += size;
+    NativeMemory::arena_bytes += size;
+}
+
+void read_data_in_arena(GenEvent& event, const GenEventData& data) {
+    // read_data clears the event and sets everything but the record itself
+    GenEventData header;
+    header.event_number = data.event_number;
+    header.momentum_unit = data.momentum_unit;
+    header.length_unit = data.length_unit;
+    header.weights = data.weights;
+    header.event_pos = data.event_pos;
+    event.read_data(header);
+
+    // One block for the whole record; the allowance covers a control block
+    // and its copy of the allocator
+    const size_t overhead = 64;
+    auto arena = std::make_shared<EventArena>(data.particles.size() * (sizeof(GenParticle) + overhead) +
+                                              data.vertices.size() * (sizeof(GenVertex) + overhead));
+    ArenaAllocator<GenParticle> particle_allocator(arena);
+    ArenaAllocator<GenVertex> vertex_allocator(arena);
+
+    std::vector<GenParticlePtr> particles;
+    particles.reserve(data.particles.size());
+    for (const GenParticleData& pd : data.particles) {
+        particles.push_back(std::allocate_shared<GenParticle>(particle_allocator, pd));
+    }
+    std::vector<GenVertexPtr> vertices;
+    vertices.reserve(data.vertices.size());
+    for (const GenVertexData& vd : data.vertices) {
+        vertices.push_back(std::allocate_shared<GenVertex>(vertex_allocator, vd));
+    }
+
+    // Link the detached objects first, then add particles and vertices in
+    // data order so that they get the ids read_data would give them
+    for (size_t i = 0; i < data.links1.size(); ++i) {
+        const int id1 = data.links1[i], id2 = data.links2[i];
+        if (id1 > 0) {
+            vertices.at(-id2 - 1)->add_particle_in(particles.at(id1 - 1));
+        } else if (id1 < 0) {
+            vertices.at(-id1 - 1)->add_particle_out(particles.at(id2 - 1));
+        }
+    }
+    event.reserve(particles.size(), vertices.size());
+    for (const auto& particle : particles) event.add_particle(particle);
+    for (const auto& vertex : vertices) event.add_vertex(vertex);
+
+    for (size_t i = 0; i < data.attribute_id.size(); ++i) {
+        event.add_attribute(data.attribute_name[i], std::make_shared<StringAttribute>(data.attribute_string[i]),
+                            data.attribute_id[i]);
+    }
+}
+
+// Rebuild the record of `event` in an arena: same content and ids, with the
+// particles and vertices packed together. Particle and vertex pointers taken
+// from the event before the call refer to the old, detached objects.
+void move_event_to_arena(void* event) {
+    auto evt = static_cast<GenEvent*>(event);
+    GenEventData data;
+    evt->write_data(data);
+    read_data_in_arena(*evt, data);
+    note_event_modified(evt);
+    account_native_memory(*evt);
+}
+
+// ---------------------------------------------------------------------------
+// Memory accounting
+// ---------------------------------------------------------------------------
+
+std::atomic<int64_t> NativeMemory::arena_bytes{0};
+std::atomic<int64_t> NativeMemory::arenas{0};
+std::atomic<int64_t> NativeMemory::pooled_events{0};
+std::atomic<int64_t> NativeMemory::gc_limit{0};
+std::atomic<int64_t> NativeMemory::gc_pending{0};
+std::atomic<int64_t> NativeMemory::gc_requests{0};
+
+namespace {
+
+// Allocation overhead of a make_shared object: control block and malloc
+// header
+const size_t SHARED_OVERHEAD = 32;
+// Bytes of one std::map node besides its value
+const size_t MAP_NODE_OVERHEAD = 48;
+
+size_t string_bytes(const std::string& s) {
+    static const size_t inline_capacity = std::string().capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+template <class T>
+size_t vector_bytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Bytes of an attribute object of type T, with the values of vector types
+template <class T>
+size_t attribute_object_bytes(const Attribute&) {
+    return sizeof(T);
+}
+
+template <class T>
+size_t vector_attribute_bytes(const Attribute& attribute) {
+    const auto& values = static_cast<const T&>(attribute).value();
+    return sizeof(T) + values.size() * sizeof(values[0]);
+}
+
+size_t vector_string_attribute_bytes(const Attribute& attribute) {
+    const auto& values = static_cast<const VectorStringAttribute&>(attribute).value();
+    size_t bytes = sizeof(VectorStringAttribute) + values.size() * sizeof(std::string);
+    for (const auto& value : values) bytes += string_bytes(value);
+    return bytes;
+}
+
+// Bytes of an attribute besides its text, by its dynamic type. Unparsed
+// attributes are StringAttributes; types not listed count as the base class.
+size_t attribute_bytes(const Attribute& attribute) {
+    using Size = size_t (*)(const Attribute&);
+    static const std::unordered_map<std::type_index, Size> sizes = {
+        {typeid(StringAttribute), attribute_object_bytes<StringAttribute>},
+        {typeid(IntAttribute), attribute_object_bytes<IntAttribute>},
+        {typeid(LongAttribute), attribute_object_bytes<LongAttribute>},
+        {typeid(LongLongAttribute), attribute_object_bytes<LongLongAttribute>},
+        {typeid(UIntAttribute), attribute_object_bytes<UIntAttribute>},
+        {typeid(ULongAttribute), attribute_object_bytes<ULongAttribute>},
+        {typeid(ULongLongAttribute), attribute_object_bytes<ULongLongAttribute>},
+        {typeid(DoubleAttribute), attribute_object_bytes<DoubleAttribute>},
+        {typeid(FloatAttribute), attribute_object_bytes<FloatAttribute>},
+        {typeid(CharAttribute), attribute_object_bytes<CharAttribute>},
+        {typeid(BoolAttribute), attribute_object_bytes<BoolAttribute>},
+        {typeid(GenPdfInfo), attribute_object_bytes<GenPdfInfo>},
+        {typeid(GenCrossSection), attribute_object_bytes<GenCrossSection>},
+        {typeid(GenHeavyIon), attribute_object_bytes<GenHeavyIon>},
+        {typeid(VectorCharAttribute), vector_attribute_bytes<VectorCharAttribute>},
+        {typeid(VectorFloatAttribute), vector_attribute_bytes<VectorFloatAttribute>},
+        {typeid(VectorDoubleAttribute), vector_attribute_bytes<VectorDoubleAttribute>},
+        {typeid(VectorIntAttribute), vector_attribute_bytes<VectorIntAttribute>},
+        {typeid(VectorLongIntAttribute), vector_attribute_bytes<VectorLongIntAttribute>},
+        {typeid(VectorLongLongAttribute), vector_attribute_bytes<VectorLongLongAttribute>},
+        {typeid(VectorUIntAttribute), vector_attribute_bytes<VectorUIntAttribute>},
+        {typeid(VectorULongAttribute), vector_attribute_bytes<VectorULongAttribute>},
+        {typeid(VectorULongLongAttribute), vector_attribute_bytes<VectorULongLongAttribute>},
+        {typeid(VectorStringAttribute), vector_string_attribute_bytes},
+    };
+    const auto found = sizes.find(typeid(attribute));
+    return found != sizes.end() ? found->second(attribute) : sizeof(Attribute);
+}
+
+// The event, its particles and vertices with their link vectors, and the
+// weights. Works from the vector sizes alone, without the attribute map.
+size_t event_record_bytes(const GenEvent& event) {
+    size_t bytes = sizeof(GenEvent) + sizeof(GenVertex) + SHARED_OVERHEAD;   // with the root vertex
+    bytes += vector_bytes(event.particles()) + vector_bytes(event.vertices()) + vector_bytes(event.weights());
+    bytes += event.particles().size() * (sizeof(GenParticle) + SHARED_OVERHEAD);
+    for (const auto& vertex : event.vertices()) {
+        bytes += sizeof(GenVertex) + SHARED_OVERHEAD + vector_bytes(vertex->particles_in()) +
+                 vector_bytes(vertex->particles_out());
+    }
+    return bytes;
+}
+
+}  // namespace
+
+int64_t event_memory_bytes(const GenEvent& event) {
+    size_t bytes = event_record_bytes(event);
+    // GenEvent only hands out its attribute map by value, so this walks a copy
+    for (const auto& named : event.attributes()) {
+        bytes += MAP_NODE_OVERHEAD + sizeof(named) + string_bytes(named.first);
+        for (const auto& entry : named.second) {
+            // The text is all an unparsed attribute holds; parsed ones keep
+            // the text they were built from, if any, besides their values
+            bytes += MAP_NODE_OVERHEAD + sizeof(entry) + SHARED_OVERHEAD + attribute_bytes(*entry.second) +
+                     string_bytes(entry.second->unparsed_string());
+        }
+    }
+    return bytes;
+}
+
+int64_t estimate_event_memory(void* event) {
+    return event_memory_bytes(*static_cast<GenEvent*>(event));
+}
+
+void account_native_memory(const GenEvent& event) {
+    const int64_t limit = NativeMemory::gc_limit.load(std::memory_order_relaxed);
+    if (limit == 0) return;
+    // Attributes are left out: taking the copy of the attribute map on
+    // every read or build would cost more than the count is worth
+    const int64_t pending = NativeMemory::gc_pending += event_record_bytes(event);
+    // Of the threads passing the limit together, the one that resets the
+    // counter files the request
+    if (pending >= limit && NativeMemory::gc_pending.exchange(0) >= limit) ++NativeMemory::gc_requests;
+}
+
+// File a collection request every `limit` bytes of events filled, or stop
+// counting with 0. Bytes counted so far are dropped. Returns the previous
+// limit.
+int64_t set_native_gc_limit(int64_t limit) {
+    NativeMemory::gc_pending = 0;
+    return NativeMemory::gc_limit.exchange(limit);
+}
+
+int64_t native_gc_requests() {
+    return NativeMemory::gc_requests;
+}
+
+// heap bytes in use, heap bytes in mmapped chunks (-1 each when the C
+// library cannot tell), arena bytes, arenas, pooled idle events, bytes
+// counted towards the next collection request, requests filed
+void native_memory_counts(int64_t* out) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    out[0] = info.uordblks;
+    out[1] = info.hblkhd;
+#else
+    out[0] = -1;
+    out[1] = -1;
+#endif
+    out[2] = NativeMemory::arena_bytes;
+    out[3] = NativeMemory::arenas;
+    out[4] = NativeMemory::pooled_events;
+    out[5] = NativeMemory::gc_pending;
+    out[6] = NativeMemory::gc_requests;
+}
@@ -0,0 +1,134 @@
+#ifndef HEPMC3_WRAP_MEMORY_H
+#define HEPMC3_WRAP_MEMORY_H
+
+// Event recycling and arena allocation shared by the reader functions, the
+// column builder and the event pipeline (HepMC3WrapMemory.cpp).
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/Data/GenEventData.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pool of cleared GenEvents. acquire() hands out an idle event when there is
+// one (a hit) and a new one otherwise (a miss). When the last reference to an
+// acquired event goes away, the event is cleared and kept for reuse, up to
+// `max_idle` events; cleared events keep the capacity of their particle and
+// vertex vectors. The pool's state lives until its last event is released,
+// so events may outlive the EventPool object.
+class EventPool {
+public:
+    explicit EventPool(size_t max_idle);
+    ~EventPool();
+
+    std::shared_ptr<HepMC3::GenEvent> acquire();
+
+    // hits, misses, released (returned for reuse), discarded (freed because
+    // the pool was full or closed), idle
+    void stats(int64_t* out) const;
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<HepMC3::GenEvent*> idle;
+        size_t max_idle = 0;
+        bool closed = false;
+        std::atomic<int64_t> hits{0};
+        std::atomic<int64_t> misses{0};
+        std::atomic<int64_t> released{0};
+        std::atomic<int64_t> discarded{0};
+
+        void release(HepMC3::GenEvent* event);
+    };
+
+    std::shared_ptr<State> m_state;
+};
+
+// Approximate heap bytes held by `event`: the event itself, its particles and
+// vertices with their shared_ptr control blocks and link vectors, weights and
+// attributes (names, values and map nodes). The run info, shared between
+// events, is not counted.
+int64_t event_memory_bytes(const HepMC3::GenEvent& event);
+
+// Process-wide gauges of native memory: live arena blocks and their bytes,
+// and events idle in pools. The gc_ counters track bytes of events filled
+// since the last collection request, the byte limit that files a request
+// (0: not counting) and the requests filed, for native_gc_pressure!.
+struct NativeMemory {
+    static std::atomic<int64_t> arena_bytes;
+    static std::atomic<int64_t> arenas;
+    static std::atomic<int64_t> pooled_events;
+    static std::atomic<int64_t> gc_limit;
+    static std::atomic<int64_t> gc_pending;
+    static std::atomic<int64_t> gc_requests;
+};
+
+// Count the bytes of a newly filled `event`, as by event_memory_bytes but
+// without its attributes, towards the next collection request. Does nothing
+// unless a limit is set; safe to call from any thread.
+void account_native_memory(const HepMC3::GenEvent& event);
+
+// Monotonic memory for the particles and vertices of one event. Memory is
+// handed out in order from large blocks and never returned piece by piece;
+// all blocks are freed together with the arena. Not thread-safe: an event is
+// built by one thread.
+class EventArena {
+public:
+    explicit EventArena(size_t block_size);
+    EventArena(const EventArena&) = delete;
+    EventArena& operator=(const EventArena&) = delete;
+    ~EventArena();
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    size_t bytes_used() const { return m_used; }
+    size_t blocks() const { return m_blocks.size(); }
+
+private:
+    void add_block(size_t min_size);
+
+    std::vector<char*> m_blocks;
+    char* m_next = nullptr;
+    size_t m_left = 0;
+    size_t m_block_size;
+    size_t m_used = 0;
+    size_t m_reserved = 0;
+};
+
+// std::allocate_shared allocator drawing from an EventArena. Every copy,
+// including the one stored in each shared_ptr control block, keeps the arena
+// alive, so the arena goes away with the last particle or vertex (or weak
+// reference to one) that uses it.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<EventArena> arena) : m_arena(std::move(arena)) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.arena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    const std::shared_ptr<EventArena>& arena() const { return m_arena; }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.arena(); }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.arena(); }
+
+private:
+    std::shared_ptr<EventArena> m_arena;
+};
+
+// Replace the content of `event` with `data`, like GenEvent::read_data, but
+// allocate all particles and vertices, with their shared_ptr control blocks,
+// from one new EventArena sized for the record. Particle and vertex ids are
+// the same as with read_data.
+void read_data_in_arena(HepMC3::GenEvent& event, const HepMC3::GenEventData& data);
+
+#endif
@@ -0,0 +1,517 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapEngine.h"
+#include "HepMC3WrapMemory.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/ReaderAscii.h"
+#include "HepMC3/WriterAscii.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Lock-free queues
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Bounded single-producer single-consumer ring.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : m_slots(capacity + 1) {}
+
+    bool try_push(T value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % m_slots.size();
+        if (next == m_head.load(std::memory_order_acquire)) return false;
+        m_slots[tail] = value;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        value = m_slots[head];
+        m_head.store((head + 1) % m_slots.size(), std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        const size_t head = m_head.load(std::memory_order_relaxed), tail = m_tail.load(std::memory_order_relaxed);
+        return (tail + m_slots.size() - head) % m_slots.size();
+    }
+
+private:
+    std::vector<T> m_slots;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+// Bounded multi-producer multi-consumer ring (D. Vyukov's design): every slot
+// carries a sequence number telling producers and consumers whose turn it is.
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t n = 2;
+        while (n < capacity) n *= 2;
+        m_mask = n - 1;
+        m_slots.reset(new Slot[n]);
+        for (size_t i = 0; i < n; ++i) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool try_push(T value) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[pos & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[pos & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = slot.value;
+                    slot.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t size() const {
+        const size_t head = m_head.load(std::memory_order_relaxed), tail = m_tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+// Spin briefly, then yield, then sleep: waits are short under load and cheap
+// when a stage is idle.
+void backoff(int& spins) {
+    if (++spins < 64) return;
+    if (spins < 256) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+struct StageCounters {
+    std::atomic<int64_t> in{0};
+    std::atomic<int64_t> out{0};
+    std::atomic<int64_t> busy_ns{0};
+    std::atomic<int64_t> full_waits{0};    // pushes that found the next queue full
+    std::atomic<int64_t> empty_waits{0};   // pops that found the input queue empty
+};
+
+// Queue between two stages: SPSC when both sides have one thread, MPMC
+// otherwise. Pushes block while the queue is full, which is what applies
+// backpressure to upstream stages.
+template <typename T>
+class StageQueue {
+public:
+    StageQueue(size_t capacity, int producers, int consumers, const std::atomic<bool>& stop)
+        : m_producers(producers), m_stop(stop) {
+        if (producers == 1 && consumers == 1) {
+            m_spsc.reset(new SpscQueue<T>(capacity));
+        } else {
+            m_mpmc.reset(new MpmcQueue<T>(capacity));
+        }
+    }
+
+    // False if the pipeline stopped before the item could be queued.
+    bool push(T value, StageCounters& counters) {
+        int spins = 0;
+        while (!try_push(value)) {
+            if (spins == 0) ++counters.full_waits;
+            if (m_stop.load(std::memory_order_relaxed)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    // False once every producer is done and the queue is drained, or if the
+    // pipeline stopped.
+    bool pop(T& value, StageCounters& counters) {
+        int spins = 0;
+        while (!try_pop(value)) {
+            if (m_producers.load(std::memory_order_acquire) == 0) return try_pop(value);
+            if (spins == 0) ++counters.empty_waits;
+            if (m_stop.load(std::memory_order_relaxed)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    void producer_done() { m_producers.fetch_sub(1, std::memory_order_release); }
+
+    size_t size() const { return m_spsc ? m_spsc->size() : m_mpmc->size(); }
+
+private:
+    bool try_push(T value) { return m_spsc ? m_spsc->try_push(value) : m_mpmc->try_push(value); }
+    bool try_pop(T& value) { return m_spsc ? m_spsc->try_pop(value) : m_mpmc->try_pop(value); }
+
+    std::unique_ptr<SpscQueue<T>> m_spsc;
+    std::unique_ptr<MpmcQueue<T>> m_mpmc;
+    std::atomic<int> m_producers;
+    const std::atomic<bool>& m_stop;
+};
+
+// ---------------------------------------------------------------------------
+// Event pipeline
+// ---------------------------------------------------------------------------
+
+struct PipelineItem {
+    int64_t sequence = 0;
+    std::shared_ptr<GenEvent> event;   // from the pipeline's event pool
+    bool accepted = true;
+    KernelOutput rows;
+};
+
+using ItemQueue = StageQueue<PipelineItem*>;
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(std::atomic<int64_t>& total) : m_total(total), m_start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        m_total += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start)
+                       .count();
+    }
+
+private:
+    std::atomic<int64_t>& m_total;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// read -> filter -> extract -> sink. The source thread reads events, filter
+// threads keep events with between min_selected and max_selected selected
+// particles, extract threads run a kernel on accepted events, and the sink
+// thread writes accepted events and collects kernel rows in read order.
+// Rejected events travel on as empty items so the sink can restore the order
+// without waiting for gaps. The extract stage is skipped without a kernel.
+class EventPipeline {
+public:
+    enum Stage { SOURCE, FILTER, EXTRACT, SINK, N_STAGES };
+
+    EventPipeline(ReaderAscii* reader, std::unique_ptr<ReaderAscii> owned_reader, WriterAscii* writer,
+                  const std::string& kernel, const KernelConfig& config, int min_selected, int max_selected,
+                  int filter_threads, int extract_threads, int capacity, int64_t max_events)
+        : m_owned_reader(std::move(owned_reader)), m_reader(reader), m_writer(writer),
+          m_selection(config.selection), m_min_selected(min_selected), m_max_selected(max_selected),
+          m_max_events(max_events), m_pool(3 * std::max(1, capacity) + 2) {
+        filter_threads = std::max(1, filter_threads);
+        extract_threads = kernel.empty() ? 0 : std::max(1, extract_threads);
+        capacity = std::max(1, capacity);
+        m_window = 3 * capacity + filter_threads + extract_threads;
+        for (int i = 0; i < extract_threads; ++i) m_kernels.push_back(make_event_kernel(kernel, config));
+        if (!m_kernels.empty()) m_result.names = m_kernels[0]->columns();
+        m_result.output = KernelOutput(m_result.names.size());
+
+        m_filter_queue.reset(new ItemQueue(capacity, 1, filter_threads, m_stop));
+        if (extract_threads > 0) m_extract_queue.reset(new ItemQueue(capacity, filter_threads, extract_threads, m_stop));
+        m_sink_queue.reset(new ItemQueue(capacity, extract_threads > 0 ? extract_threads : filter_threads, 1, m_stop));
+
+        m_running = 2 + filter_threads + extract_threads;
+        m_threads.emplace_back(&EventPipeline::source, this);
+        for (int i = 0; i < filter_threads; ++i) m_threads.emplace_back(&EventPipeline::filter, this);
+        for (int i = 0; i < extract_threads; ++i) m_threads.emplace_back(&EventPipeline::extract, this, i);
+        m_threads.emplace_back(&EventPipeline::sink, this);
+    }
+
+    ~EventPipeline() {
+        m_stop = true;
+        join();
+    }
+
+    bool running() const { return m_running.load() > 0; }
+
+    // Wait for the pipeline to drain and hand over its result.
+    EngineResult* finish() {
+        join();
+        auto result = new EngineResult;
+        result->names = m_result.names;
+        result->output = std::move(m_result.output);
+        for (size_t i = 1; i < m_kernels.size(); ++i) m_kernels[0]->merge(*m_kernels[i]);
+        if (!m_kernels.empty()) result->kernel = std::move(m_kernels[0]);
+        result->events = m_counters[SOURCE].out;
+        result->error = m_error;
+        m_kernels.clear();
+        return result;
+    }
+
+    // Per stage: in, out, busy_ns, full_waits, empty_waits; then the sizes of
+    // the filter, extract and sink queues.
+    void stats(int64_t* out) const {
+        for (int s = 0; s < N_STAGES; ++s) {
+            const StageCounters& c = m_counters[s];
+            out[5 * s + 0] = c.in;
+            out[5 * s + 1] = c.out;
+            out[5 * s + 2] = c.busy_ns;
+            out[5 * s + 3] = c.full_waits;
+            out[5 * s + 4] = c.empty_waits;
+        }
+        out[5 * N_STAGES + 0] = m_filter_queue->size();
+        out[5 * N_STAGES + 1] = m_extract_queue ? m_extract_queue->size() : 0;
+        out[5 * N_STAGES + 2] = m_sink_queue->size();
+    }
+
+private:
+    // Runs a stage body, stopping the whole pipeline if it throws.
+    template <typename Body>
+    void guarded(Body body) {
+        try {
+            body();
+        } catch (const std::exception& e) {
+            fail(e.what());
+        } catch (...) {
+            fail("unknown error in pipeline stage");
+        }
+        --m_running;
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(m_error_mutex);
+        if (m_error.empty()) m_error = message;
+        m_stop = true;
+    }
+
+    void source() {
+        guarded([this] {
+            StageCounters& c = m_counters[SOURCE];
+            int64_t n = 0;
+            while (!m_stop && (m_max_events < 0 || n < m_max_events) && !m_reader->failed()) {
+                if (!wait_for_window(n, c)) break;
+                std::shared_ptr<GenEvent> event = m_pool.acquire();
+                {
+                    ScopedTimer timer(c.busy_ns);
+                    m_reader->read_event(*event);
+                }
+                if (m_reader->failed()) break;
+                auto item = new PipelineItem;
+                item->sequence = n++;
+                item->event = std::move(event);
+                ++c.in;
+                ++c.out;
+                if (!m_filter_queue->push(item, c)) {
+                    delete item;
+                    break;
+                }
+            }
+        });
+        m_filter_queue->producer_done();
+    }
+
+    // Wait until event `n` is within m_window of the next one the sink
+    // commits; false if the pipeline stopped. Without this, one slow event
+    // would let the events behind it pile up in the sink's reorder map.
+    bool wait_for_window(int64_t n, StageCounters& c) {
+        int spins = 0;
+        while (n - m_committed.load(std::memory_order_acquire) >= m_window) {
+            if (spins == 0) ++c.full_waits;
+            if (m_stop.load(std::memory_order_relaxed)) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    void filter() {
+        ItemQueue& next = m_extract_queue ? *m_extract_queue : *m_sink_queue;
+        guarded([this, &next] {
+            StageCounters& c = m_counters[FILTER];
+            PipelineItem* item = nullptr;
+            while (m_filter_queue->pop(item, c)) {
+                ++c.in;
+                {
+                    ScopedTimer timer(c.busy_ns);
+                    int n = 0;
+                    for (const auto& particle : item->event->particles()) n += m_selection.accepts(*particle);
+                    item->accepted = n >= m_min_selected && (m_max_selected < 0 || n <= m_max_selected);
+                    if (!item->accepted) item->event.reset();
+                }
+                if (item->accepted) ++c.out;
+                if (!next.push(item, c)) {
+                    delete item;
+                    break;
+                }
+            }
+        });
+        next.producer_done();
+    }
+
+    void extract(int worker) {
+        guarded([this, worker] {
+            StageCounters& c = m_counters[EXTRACT];
+            PipelineItem* item = nullptr;
+            while (m_extract_queue->pop(item, c)) {
+                ++c.in;
+                if (item->accepted) {
+                    ScopedTimer timer(c.busy_ns);
+                    item->rows = KernelOutput(m_result.names.size());
+                    item->rows.current_event = item->sequence;
+                    m_kernels[worker]->process(*item->event, item->rows);
+                    ++c.out;
+                }
+                if (!m_sink_queue->push(item, c)) {
+                    delete item;
+                    break;
+                }
+            }
+        });
+        m_sink_queue->producer_done();
+    }
+
+    void sink() {
+        std::map<int64_t, PipelineItem*> pending;
+        guarded([this, &pending] {
+            StageCounters& c = m_counters[SINK];
+            int64_t next = 0;
+            PipelineItem* item = nullptr;
+            while (m_sink_queue->pop(item, c)) {
+                ++c.in;
+                pending[item->sequence] = item;
+                while (!pending.empty() && pending.begin()->first == next) {
+                    std::unique_ptr<PipelineItem> ready(pending.begin()->second);
+                    pending.erase(pending.begin());
+                    m_committed.store(++next, std::memory_order_release);
+                    if (!ready->accepted) continue;
+                    ScopedTimer timer(c.busy_ns);
+                    if (m_writer) {
+                        m_writer->write_event(*ready->event);
+                        if (m_writer->failed()) throw std::runtime_error("write failed (disk full or stream closed)");
+                    }
+                    if (m_extract_queue) m_result.output.append(ready->rows);
+                    ++c.out;
+                }
+            }
+        });
+        for (auto& entry : pending) delete entry.second;
+    }
+
+    void join() {
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) thread.join();
+        }
+        // Items left behind by a stopped pipeline
+        PipelineItem* item = nullptr;
+        StageCounters scratch;
+        for (ItemQueue* queue : {m_filter_queue.get(), m_extract_queue.get(), m_sink_queue.get()}) {
+            while (queue && queue->pop(item, scratch)) delete item;
+        }
+    }
+
+    std::unique_ptr<ReaderAscii> m_owned_reader;
+    ReaderAscii* m_reader;
+    WriterAscii* m_writer;
+    ParticleSelection m_selection;
+    int m_min_selected;
+    int m_max_selected;
+    int64_t m_max_events;
+    // Events cycle from source to sink; the three queues and the window bound
+    // how many are in flight, so steady state reuses events instead of
+    // allocating them
+    EventPool m_pool;
+    // Events the source may read ahead of the sink: room for every queue
+    // and one event held by each filter and extract thread
+    int64_t m_window = 0;
+    std::atomic<int64_t> m_committed{0};   // events the sink has taken in order
+    std::vector<std::unique_ptr<EventKernel>> m_kernels;
+    EngineResult m_result;
+    std::atomic<bool> m_stop{false};
+    std::unique_ptr<ItemQueue> m_filter_queue;
+    std::unique_ptr<ItemQueue> m_extract_queue;
+    std::unique_ptr<ItemQueue> m_sink_queue;
+    StageCounters m_counters[N_STAGES];
+    std::mutex m_error_mutex;
+    std::string m_error;
+    std::atomic<int> m_running{0};
+    std::vector<std::thread> m_threads;
+};
+
+}  // namespace
+
+// Start a pipeline reading from the ReaderAscii handle `reader`, or from
+// `filename` when `reader` is null, and writing accepted events to the
+// WriterAscii handle `writer` (may be null). `kernel` (may be empty) runs on
+// accepted events with the same selection the filter counts with. The
+// reader and writer handles must not be used until pipeline_finish returns;
+// the writer is not closed.
+void* create_event_pipeline(void* reader, const char* filename, void* writer, const char* kernel, int status,
+                            int* abs_pdg, int n_pdg, double pt_min, double abs_eta_max, int min_selected,
+                            int max_selected, int filter_threads, int extract_threads, int capacity,
+                            int64_t max_events) {
+    KernelConfig config;
+    config.selection.status = status;
+    config.selection.abs_pdg.assign(abs_pdg, abs_pdg + n_pdg);
+    config.selection.pt_min = pt_min;
+    config.selection.abs_eta_max = abs_eta_max;
+    std::unique_ptr<ReaderAscii> owned;
+    if (!reader) owned.reset(new ReaderAscii(std::string(filename)));
+    ReaderAscii* source = reader ? static_cast<ReaderAscii*>(reader) : owned.get();
+    return new EventPipeline(source, std::move(owned), static_cast<WriterAscii*>(writer), kernel, config,
+                             min_selected, max_selected, filter_threads, extract_threads, capacity, max_events);
+}
+
+bool pipeline_running(void* pipeline) {
+    return static_cast<EventPipeline*>(pipeline)->running();
+}
+
+// 23 counters; see EventPipeline::stats.
+void pipeline_counts(void* pipeline, int64_t* out) {
+    static_cast<EventPipeline*>(pipeline)->stats(out);
+}
+
+// Wait for all events to pass and return an engine result handle with the
+// kernel rows; the number of events read is engine_result_events.
+void* pipeline_finish(void* pipeline) {
+    return static_cast<EventPipeline*>(pipeline)->finish();
+}
+
+// Stop the pipeline if it still runs and free it.
+void delete_event_pipeline(void* pipeline) {
+    delete static_cast<EventPipeline*>(pipeline);
+}
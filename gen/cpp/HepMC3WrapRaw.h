@@ -0,0 +1,156 @@
+#ifndef HEPMC3_WRAP_RAW_H
+#define HEPMC3_WRAP_RAW_H
+
+// Raw event text reader shared by the pass-through writer (HepMC3WrapIO.cpp)
+// and the event engine (HepMC3WrapEngine.cpp).
+
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Reads an ASCII file as raw per-event text spans. The text before the first
+// "E" line is the header and the end-of-listing line starts the footer. A
+// run info block written between events ("T" lines, or any line other than
+// "P" and "V" once an event's particles and vertices have started) is not
+// part of either event: it is appended to run_info(), which holds every such
+// block read so far, and the first run_info_before() bytes of it precede the
+// current event. Writers copy the blocks whether or not the events around
+// them are kept.
+//
+// Next to the raw text, each event gets a light view parsed from its "E" and
+// "P" lines only: event number, counts, and per particle the pid, status,
+// momentum, mass and the raw parent field (negative: production vertex id,
+// positive: id of the particle whose end vertex produced it, 0: none).
+class RawEventReader {
+public:
+    // With `view` false only the raw text is kept, for readers that parse the
+    // events themselves.
+    explicit RawEventReader(const std::string& filename, bool view = true)
+        : m_in(filename, std::ios::binary), m_view(view) {
+        if (!m_in) return;
+        m_ok = true;
+        while (std::getline(m_in, m_line)) {
+            if (starts_event(m_line)) {
+                m_pending = true;
+                break;
+            }
+            if (ends_listing(m_line)) {
+                m_footer = m_line + "\n";
+                read_footer();
+                break;
+            }
+            m_header += m_line;
+            m_header += '\n';
+        }
+    }
+
+    bool ok() const { return m_ok; }
+    const std::string& header() const { return m_header; }
+    const std::string& footer() const { return m_footer; }
+    const std::string& text() const { return m_text; }
+    const std::string& run_info() const { return m_run_info; }
+    size_t run_info_before() const { return m_run_info_before; }
+
+    // Load the next event. Returns false at the end of the listing.
+    bool next() {
+        m_text.clear();
+        clear_view();
+        m_run_info_before = m_run_info.size();
+        if (!m_pending) return false;
+        m_pending = false;
+        append_line(m_line);
+        bool in_record = false, in_run_info = false;
+        while (std::getline(m_in, m_line)) {
+            if (starts_event(m_line)) {
+                m_pending = true;
+                break;
+            }
+            if (ends_listing(m_line)) {
+                m_footer = m_line + "\n";
+                read_footer();
+                break;
+            }
+            if (!in_run_info && !m_line.empty()) {
+                const char c = m_line[0];
+                in_run_info = c == 'T' || m_line.compare(0, 7, "HepMC::") == 0 || (in_record && c != 'P' && c != 'V');
+                in_record = in_record || c == 'P' || c == 'V';
+            }
+            if (in_run_info) {
+                m_run_info += m_line;
+                m_run_info += '\n';
+            } else {
+                append_line(m_line);
+            }
+        }
+        return true;
+    }
+
+    int event_number = 0;
+    int n_vertices = 0;
+    std::vector<int> pid, status, parent;
+    std::vector<double> momenta, mass;   // momenta as px, py, pz, e per particle
+
+private:
+    static bool starts_event(const std::string& line) { return line.size() > 1 && line[0] == 'E' && line[1] == ' '; }
+    static bool ends_listing(const std::string& line) { return line.compare(0, 32, "HepMC::Asciiv3-END_EVENT_LISTING") == 0; }
+
+    void read_footer() {
+        while (std::getline(m_in, m_line)) {
+            m_footer += m_line;
+            m_footer += '\n';
+        }
+    }
+
+    void clear_view() {
+        event_number = 0;
+        n_vertices = 0;
+        pid.clear();
+        status.clear();
+        parent.clear();
+        momenta.clear();
+        mass.clear();
+    }
+
+    void append_line(const std::string& line) {
+        m_text += line;
+        m_text += '\n';
+        if (!m_view) return;
+        const char* s = line.c_str();
+        char* end = nullptr;
+        if (line[0] == 'E') {
+            event_number = std::strtol(s + 1, &end, 10);
+            n_vertices = std::strtol(end, &end, 10);
+            const long n_particles = std::strtol(end, &end, 10);
+            if (n_particles > 0) {
+                pid.reserve(n_particles);
+                status.reserve(n_particles);
+                parent.reserve(n_particles);
+                momenta.reserve(4 * n_particles);
+                mass.reserve(n_particles);
+            }
+        } else if (line[0] == 'P') {
+            // P id parent pid px py pz e m status
+            std::strtol(s + 1, &end, 10);
+            parent.push_back(std::strtol(end, &end, 10));
+            pid.push_back(std::strtol(end, &end, 10));
+            for (int k = 0; k < 4; ++k) momenta.push_back(std::strtod(end, &end));
+            mass.push_back(std::strtod(end, &end));
+            status.push_back(std::strtol(end, &end, 10));
+        }
+    }
+
+    std::ifstream m_in;
+    std::string m_line;
+    std::string m_header;
+    std::string m_footer;
+    std::string m_text;
+    std::string m_run_info;
+    size_t m_run_info_before = 0;
+    bool m_ok = false;
+    bool m_pending = false;
+    bool m_view = true;
+};
+
+#endif
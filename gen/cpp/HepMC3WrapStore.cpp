@@ -0,0 +1,591 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3WrapStore.h"
+#include "HepMC3WrapAttributes.h"
+#include "HepMC3WrapMemory.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/ReaderAscii.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Event store
+// ---------------------------------------------------------------------------
+
+namespace {
+
+template <class T>
+size_t column_bytes(const std::vector<T>& column) {
+    return column.capacity() * sizeof(T);
+}
+
+}  // namespace
+
+EventStore::EventStore(bool single_precision) : m_single(single_precision) {}
+
+void EventStore::add(const GenEvent& event) {
+    GenEventData data;
+    event.write_data(data);
+    // Events of one file share their run info, so the table stays short
+    const auto run_info = std::find(m_run_infos.begin(), m_run_infos.end(), event.run_info());
+    m_run_info_index.push_back(run_info - m_run_infos.begin());
+    if (run_info == m_run_infos.end()) m_run_infos.push_back(event.run_info());
+
+    if (!m_event_number.empty() && data.event_number < m_event_number.back()) m_numbers_sorted = false;
+    m_event_number.push_back(data.event_number);
+    m_units.push_back(static_cast<uint8_t>(data.momentum_unit | data.length_unit << 1));
+    const FourVector& pos = data.event_pos;
+    m_event_pos.insert(m_event_pos.end(), {pos.x(), pos.y(), pos.z(), pos.t()});
+
+    for (const GenParticleData& p : data.particles) {
+        m_pid.push_back(p.pid);
+        m_status.push_back(p.status);
+        for (double x : {p.momentum.px(), p.momentum.py(), p.momentum.pz(), p.momentum.e()}) {
+            put(x, m_momentum, m_momentum_single);
+        }
+        put(p.is_mass_set ? p.mass : std::numeric_limits<double>::quiet_NaN(), m_mass, m_mass_single);
+    }
+    for (const GenVertexData& v : data.vertices) {
+        m_vertex_status.push_back(v.status);
+        for (double x : {v.position.x(), v.position.y(), v.position.z(), v.position.t()}) {
+            put(x, m_position, m_position_single);
+        }
+    }
+    m_links1.insert(m_links1.end(), data.links1.begin(), data.links1.end());
+    m_links2.insert(m_links2.end(), data.links2.begin(), data.links2.end());
+    m_weights.insert(m_weights.end(), data.weights.begin(), data.weights.end());
+
+    for (size_t i = 0; i < data.attribute_id.size(); ++i) {
+        auto name = m_name_index.find(data.attribute_name[i]);
+        if (name == m_name_index.end()) {
+            name = m_name_index.emplace(data.attribute_name[i], m_names.size()).first;
+            m_names.push_back(data.attribute_name[i]);
+        }
+        m_attribute_id.push_back(data.attribute_id[i]);
+        m_attribute_name.push_back(name->second);
+        m_values += data.attribute_string[i];
+        m_value_begin.push_back(m_values.size());
+    }
+
+    m_particle_begin.push_back(m_pid.size());
+    m_vertex_begin.push_back(m_vertex_status.size());
+    m_link_begin.push_back(m_links1.size());
+    m_weight_begin.push_back(m_weights.size());
+    m_attribute_begin.push_back(m_attribute_id.size());
+
+    std::lock_guard<std::mutex> lock(m_order_mutex);
+    m_order.clear();
+}
+
+void EventStore::materialize(size_t index, GenEvent& event, bool in_arena) const {
+    if (index >= size()) throw std::out_of_range("event index out of range");
+
+    GenEventData data;
+    data.event_number = m_event_number[index];
+    data.momentum_unit = static_cast<Units::MomentumUnit>(m_units[index] & 1);
+    data.length_unit = static_cast<Units::LengthUnit>(m_units[index] >> 1 & 1);
+    data.event_pos = FourVector(m_event_pos[4 * index], m_event_pos[4 * index + 1], m_event_pos[4 * index + 2],
+                                m_event_pos[4 * index + 3]);
+
+    const size_t p0 = m_particle_begin[index], p1 = m_particle_begin[index + 1];
+    data.particles.resize(p1 - p0);
+    for (size_t i = p0; i < p1; ++i) {
+        GenParticleData& p = data.particles[i - p0];
+        p.pid = m_pid[i];
+        p.status = m_status[i];
+        p.momentum = FourVector(get(4 * i, m_momentum, m_momentum_single), get(4 * i + 1, m_momentum, m_momentum_single),
+                                get(4 * i + 2, m_momentum, m_momentum_single),
+                                get(4 * i + 3, m_momentum, m_momentum_single));
+        const double mass = get(i, m_mass, m_mass_single);
+        p.is_mass_set = !std::isnan(mass);
+        p.mass = p.is_mass_set ? mass : 0.0;
+    }
+
+    const size_t v0 = m_vertex_begin[index], v1 = m_vertex_begin[index + 1];
+    data.vertices.resize(v1 - v0);
+    for (size_t v = v0; v < v1; ++v) {
+        GenVertexData& vd = data.vertices[v - v0];
+        vd.status = m_vertex_status[v];
+        vd.position = FourVector(get(4 * v, m_position, m_position_single), get(4 * v + 1, m_position, m_position_single),
+                                 get(4 * v + 2, m_position, m_position_single),
+                                 get(4 * v + 3, m_position, m_position_single));
+    }
+
+    data.links1.assign(m_links1.begin() + m_link_begin[index], m_links1.begin() + m_link_begin[index + 1]);
+    data.links2.assign(m_links2.begin() + m_link_begin[index], m_links2.begin() + m_link_begin[index + 1]);
+    data.weights.assign(m_weights.begin() + m_weight_begin[index], m_weights.begin() + m_weight_begin[index + 1]);
+
+    for (size_t a = m_attribute_begin[index]; a < m_attribute_begin[index + 1]; ++a) {
+        data.attribute_id.push_back(m_attribute_id[a]);
+        data.attribute_name.push_back(m_names[m_attribute_name[a]]);
+        data.attribute_string.emplace_back(m_values, m_value_begin[a], m_value_begin[a + 1] - m_value_begin[a]);
+    }
+
+    // Attributes such as GenCrossSection look at the run info when parsed
+    event.set_run_info(m_run_infos[m_run_info_index[index]]);
+    if (in_arena) {
+        read_data_in_arena(event, data);
+    } else {
+        event.read_data(data);
+    }
+}
+
+int64_t EventStore::find(int event_number) const {
+    if (m_numbers_sorted) {
+        auto it = std::lower_bound(m_event_number.begin(), m_event_number.end(), event_number);
+        return it != m_event_number.end() && *it == event_number ? it - m_event_number.begin() : -1;
+    }
+    std::lock_guard<std::mutex> lock(m_order_mutex);
+    if (m_order.empty()) {
+        m_order.resize(size());
+        for (size_t i = 0; i < m_order.size(); ++i) m_order[i] = i;
+        std::stable_sort(m_order.begin(), m_order.end(),
+                         [this](size_t a, size_t b) { return m_event_number[a] < m_event_number[b]; });
+    }
+    auto it = std::lower_bound(m_order.begin(), m_order.end(), event_number,
+                               [this](size_t i, int number) { return m_event_number[i] < number; });
+    return it != m_order.end() && m_event_number[*it] == event_number ? static_cast<int64_t>(*it) : -1;
+}
+
+void EventStore::shrink_to_fit() {
+    m_event_number.shrink_to_fit();
+    m_run_info_index.shrink_to_fit();
+    m_units.shrink_to_fit();
+    m_event_pos.shrink_to_fit();
+    m_particle_begin.shrink_to_fit();
+    m_vertex_begin.shrink_to_fit();
+    m_link_begin.shrink_to_fit();
+    m_weight_begin.shrink_to_fit();
+    m_attribute_begin.shrink_to_fit();
+    m_pid.shrink_to_fit();
+    m_status.shrink_to_fit();
+    m_momentum.shrink_to_fit();
+    m_momentum_single.shrink_to_fit();
+    m_mass.shrink_to_fit();
+    m_mass_single.shrink_to_fit();
+    m_vertex_status.shrink_to_fit();
+    m_position.shrink_to_fit();
+    m_position_single.shrink_to_fit();
+    m_links1.shrink_to_fit();
+    m_links2.shrink_to_fit();
+    m_weights.shrink_to_fit();
+    m_attribute_id.shrink_to_fit();
+    m_attribute_name.shrink_to_fit();
+    m_value_begin.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+void EventStore::stats(int64_t* out) const {
+    out[0] = size();
+    out[1] = m_pid.size();
+    out[2] = m_vertex_status.size();
+    size_t bytes = sizeof(EventStore) + column_bytes(m_run_infos) + column_bytes(m_event_number) +
+                   column_bytes(m_run_info_index) + column_bytes(m_units) +
+                   column_bytes(m_event_pos) + column_bytes(m_particle_begin) + column_bytes(m_vertex_begin) +
+                   column_bytes(m_link_begin) + column_bytes(m_weight_begin) + column_bytes(m_attribute_begin) +
+                   column_bytes(m_pid) + column_bytes(m_status) + column_bytes(m_momentum) +
+                   column_bytes(m_momentum_single) + column_bytes(m_mass) + column_bytes(m_mass_single) +
+                   column_bytes(m_vertex_status) + column_bytes(m_position) + column_bytes(m_position_single) +
+                   column_bytes(m_links1) + column_bytes(m_links2) + column_bytes(m_weights) +
+                   column_bytes(m_attribute_id) + column_bytes(m_attribute_name) + column_bytes(m_value_begin) +
+                   m_values.capacity();
+    for (const auto& name : m_names) bytes += 2 * (name.capacity() + sizeof(std::string)) + sizeof(uint32_t);
+    std::lock_guard<std::mutex> lock(m_order_mutex);
+    out[3] = bytes + column_bytes(m_order);
+}
+
+void* create_event_store(bool single_precision) {
+    return new EventStore(single_precision);
+}
+
+void event_store_add(void* store, void* event) {
+    static_cast<EventStore*>(store)->add(*static_cast<GenEvent*>(event));
+}
+
+// Add up to `max_events` events (all for -1) of an ASCII file, applying the
+// attribute `policy` unless it is null. Returns the number of events added,
+// or -1 when the file cannot be opened.
+int64_t event_store_read_file(void* store, const char* filename, int64_t max_events, void* policy) {
+    auto s = static_cast<EventStore*>(store);
+    auto rules = static_cast<const AttributePolicy*>(policy);
+    ReaderAscii reader(filename);
+    if (reader.failed()) return -1;
+
+    GenEvent event;
+    int64_t n = 0;
+    while (!reader.failed() && (max_events < 0 || n < max_events)) {
+        reader.read_event(event);
+        if (reader.failed()) break;
+        if (rules) rules->apply(event);
+        s->add(event);
+        ++n;
+    }
+    s->shrink_to_fit();
+    return n;
+}
+
+// events, particles, vertices, bytes
+void event_store_counts(void* store, int64_t* out) {
+    static_cast<EventStore*>(store)->stats(out);
+}
+
+// The event at 0-based `index` as a new event pointer like those of
+// read_hepmc_file.
+void* event_store_materialize(void* store, int64_t index, bool in_arena) {
+    auto event = std::make_shared<GenEvent>();
+    static_cast<EventStore*>(store)->materialize(index, *event, in_arena);
+    return new std::shared_ptr<GenEvent>(event);
+}
+
+int64_t event_store_find(void* store, int event_number) {
+    return static_cast<EventStore*>(store)->find(event_number);
+}
+
+void delete_event_store(void* store) {
+    delete static_cast<EventStore*>(store);
+}
+
+// ---------------------------------------------------------------------------
+// Event cache
+// ---------------------------------------------------------------------------
+
+namespace {
+
+template <class T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+T take(const char*& in) {
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+void put_vector(std::string& out, const FourVector& v) {
+    for (double x : {v.x(), v.y(), v.z(), v.t()}) put(out, x);
+}
+
+FourVector take_vector(const char*& in) {
+    const double x = take<double>(in), y = take<double>(in), z = take<double>(in);
+    return FourVector(x, y, z, take<double>(in));
+}
+
+template <class T>
+void put_column(std::string& out, const std::vector<T>& column) {
+    put<uint64_t>(out, column.size());
+    if (!column.empty()) out.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+template <class T>
+void take_column(const char*& in, std::vector<T>& column) {
+    column.resize(take<uint64_t>(in));
+    if (!column.empty()) std::memcpy(column.data(), in, column.size() * sizeof(T));
+    in += column.size() * sizeof(T);
+}
+
+void put_string(std::string& out, const std::string& s) {
+    put<uint64_t>(out, s.size());
+    out += s;
+}
+
+std::string take_string(const char*& in) {
+    const uint64_t n = take<uint64_t>(in);
+    std::string s(in, n);
+    in += n;
+    return s;
+}
+
+// GenEventData records appended to a scratch file, which is removed again
+// with the SpillFile
+class SpillFile {
+public:
+    explicit SpillFile(const std::string& path)
+        : m_path(path), m_file(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc) {
+        if (!m_file) throw std::runtime_error("cannot open scratch file " + path);
+    }
+
+    ~SpillFile() {
+        m_file.close();
+        std::remove(m_path.c_str());
+    }
+
+    // Offset of the new record
+    int64_t write(const GenEventData& data) {
+        m_buffer.clear();
+        put(m_buffer, data.event_number);
+        put(m_buffer, static_cast<int32_t>(data.momentum_unit));
+        put(m_buffer, static_cast<int32_t>(data.length_unit));
+        put_vector(m_buffer, data.event_pos);
+        put<uint64_t>(m_buffer, data.particles.size());
+        for (const GenParticleData& p : data.particles) {
+            put(m_buffer, p.pid);
+            put(m_buffer, p.status);
+            put<uint8_t>(m_buffer, p.is_mass_set);
+            put(m_buffer, p.mass);
+            put_vector(m_buffer, p.momentum);
+        }
+        put<uint64_t>(m_buffer, data.vertices.size());
+        for (const GenVertexData& v : data.vertices) {
+            put(m_buffer, v.status);
+            put_vector(m_buffer, v.position);
+        }
+        put_column(m_buffer, data.links1);
+        put_column(m_buffer, data.links2);
+        put_column(m_buffer, data.weights);
+        put_column(m_buffer, data.attribute_id);
+        for (size_t i = 0; i < data.attribute_id.size(); ++i) {
+            put_string(m_buffer, data.attribute_name[i]);
+            put_string(m_buffer, data.attribute_string[i]);
+        }
+
+        const int64_t offset = m_size;
+        const uint64_t n = m_buffer.size();
+        m_file.seekp(offset);
+        m_file.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        m_file.write(m_buffer.data(), n);
+        if (!m_file) throw std::runtime_error("cannot write to scratch file " + m_path);
+        m_size += sizeof(n) + n;
+        return offset;
+    }
+
+    void read(int64_t offset, GenEventData& data) {
+        uint64_t n = 0;
+        m_file.seekg(offset);
+        m_file.read(reinterpret_cast<char*>(&n), sizeof(n));
+        m_buffer.resize(n);
+        m_file.read(&m_buffer[0], n);
+        if (!m_file) throw std::runtime_error("cannot read from scratch file " + m_path);
+
+        const char* in = m_buffer.data();
+        data.event_number = take<int>(in);
+        data.momentum_unit = static_cast<Units::MomentumUnit>(take<int32_t>(in));
+        data.length_unit = static_cast<Units::LengthUnit>(take<int32_t>(in));
+        data.event_pos = take_vector(in);
+        data.particles.resize(take<uint64_t>(in));
+        for (GenParticleData& p : data.particles) {
+            p.pid = take<int>(in);
+            p.status = take<int>(in);
+            p.is_mass_set = take<uint8_t>(in);
+            p.mass = take<double>(in);
+            p.momentum = take_vector(in);
+        }
+        data.vertices.resize(take<uint64_t>(in));
+        for (GenVertexData& v : data.vertices) {
+            v.status = take<int>(in);
+            v.position = take_vector(in);
+        }
+        take_column(in, data.links1);
+        take_column(in, data.links2);
+        take_column(in, data.weights);
+        take_column(in, data.attribute_id);
+        data.attribute_name.resize(data.attribute_id.size());
+        data.attribute_string.resize(data.attribute_id.size());
+        for (size_t i = 0; i < data.attribute_id.size(); ++i) {
+            data.attribute_name[i] = take_string(in);
+            data.attribute_string[i] = take_string(in);
+        }
+    }
+
+    int64_t size() const { return m_size; }
+
+private:
+    std::string m_path;
+    std::fstream m_file;
+    std::string m_buffer;
+    int64_t m_size = 0;
+};
+
+// Events of a file or EventStore by position, with the most recently used
+// ones kept in memory up to a byte budget (as by event_memory_bytes). File
+// events pushed out of memory are written to a scratch file first, as the
+// reader cannot go back; store events are materialised again. Callers share
+// the cached events read-only, or ask for a copy they may modify, so every
+// access sees the source's content whether or not the event was evicted in
+// between.
+class EventCache {
+public:
+    EventCache(const std::string& filename, const EventStore* store, int64_t budget, const std::string& scratch)
+        : m_store(store), m_budget(budget), m_scratch(scratch) {
+        if (!store) {
+            m_reader.reset(new ReaderAscii(filename));
+            if (m_reader->failed()) throw std::runtime_error("cannot open " + filename);
+        }
+    }
+
+    // The event at 0-based `index`, or nullptr past the last event. Holders
+    // keep an evicted event alive through its shared_ptr.
+    std::shared_ptr<const GenEvent> get(int64_t index) { return find(index); }
+
+    // A copy of the event at `index` that the caller may modify, made outside
+    // the lock.
+    std::shared_ptr<GenEvent> get_copy(int64_t index) {
+        const std::shared_ptr<const GenEvent> cached = find(index);
+        if (!cached) return nullptr;
+        GenEventData data;
+        cached->write_data(data);
+        auto event = std::make_shared<GenEvent>();
+        event->set_run_info(cached->run_info());
+        event->read_data(data);
+        return event;
+    }
+
+    // hits, disk hits, misses, events read from the source, events spilled,
+    // evictions, events in memory, bytes in memory, scratch file bytes
+    void stats(int64_t* out) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        out[0] = m_hits;
+        out[1] = m_disk_hits;
+        out[2] = m_misses;
+        out[3] = m_reads;
+        out[4] = m_spills;
+        out[5] = m_evictions;
+        out[6] = m_lru.size();
+        out[7] = m_memory_bytes;
+        out[8] = m_spill ? m_spill->size() : 0;
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const GenEvent> event;   // null when not in memory
+        int64_t bytes = 0;
+        int64_t spill_offset = -1;
+        std::list<int64_t>::iterator position;
+    };
+
+    // The cached event at `index`, loading it if needed
+    std::shared_ptr<const GenEvent> find(int64_t index) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (index < 0) return nullptr;
+        if (index < static_cast<int64_t>(m_entries.size())) {
+            Entry& entry = m_entries[index];
+            if (entry.event) {
+                ++m_hits;
+                m_lru.splice(m_lru.begin(), m_lru, entry.position);
+                return entry.event;
+            }
+            if (entry.spill_offset >= 0) {
+                ++m_disk_hits;
+                GenEventData data;
+                m_spill->read(entry.spill_offset, data);
+                auto event = std::make_shared<GenEvent>();
+                event->set_run_info(m_reader->run_info());
+                event->read_data(data);
+                return insert(index, event);
+            }
+        }
+
+        if (m_store) {
+            if (index >= static_cast<int64_t>(m_store->size())) return nullptr;
+            if (m_entries.size() < m_store->size()) m_entries.resize(m_store->size());
+            ++m_misses;
+            ++m_reads;
+            auto event = std::make_shared<GenEvent>();
+            m_store->materialize(index, *event, false);
+            return insert(index, event);
+        }
+
+        // Read forward; events passed on the way are cached as well
+        while (static_cast<int64_t>(m_entries.size()) <= index) {
+            if (m_reader->failed()) return nullptr;
+            auto event = std::make_shared<GenEvent>();
+            m_reader->read_event(*event);
+            if (m_reader->failed()) return nullptr;
+            ++m_reads;
+            m_entries.emplace_back();
+            insert(m_entries.size() - 1, event);
+        }
+        ++m_misses;
+        return m_entries[index].event;
+    }
+
+    const std::shared_ptr<const GenEvent>& insert(int64_t index, std::shared_ptr<const GenEvent> event) {
+        Entry& entry = m_entries[index];
+        entry.bytes = event_memory_bytes(*event);
+        entry.event = std::move(event);
+        m_lru.push_front(index);
+        entry.position = m_lru.begin();
+        m_memory_bytes += entry.bytes;
+        // The newest event stays even when it alone exceeds the budget
+        while (m_memory_bytes > m_budget && m_lru.size() > 1) evict(m_lru.back());
+        return entry.event;
+    }
+
+    void evict(int64_t index) {
+        Entry& entry = m_entries[index];
+        if (m_reader && entry.spill_offset < 0) {
+            if (!m_spill) m_spill.reset(new SpillFile(m_scratch));
+            GenEventData data;
+            entry.event->write_data(data);
+            entry.spill_offset = m_spill->write(data);
+            ++m_spills;
+        }
+        m_lru.erase(entry.position);
+        m_memory_bytes -= entry.bytes;
+        entry.event.reset();
+        ++m_evictions;
+    }
+
+    std::mutex m_mutex;
+    std::unique_ptr<ReaderAscii> m_reader;
+    const EventStore* m_store;
+    int64_t m_budget;
+    std::string m_scratch;
+    std::unique_ptr<SpillFile> m_spill;
+    std::vector<Entry> m_entries;
+    std::list<int64_t> m_lru;   // most recently used first
+    int64_t m_memory_bytes = 0;
+    int64_t m_hits = 0;
+    int64_t m_disk_hits = 0;
+    int64_t m_misses = 0;
+    int64_t m_reads = 0;
+    int64_t m_spills = 0;
+    int64_t m_evictions = 0;
+};
+
+}  // namespace
+
+// A cache over the ASCII file `filename`, or over `store` when it is not
+// null, holding at most `budget_bytes` of events in memory. Evicted file
+// events go to the file `scratch`, created on first use and removed with the
+// cache.
+void* create_event_cache(const char* filename, void* store, int64_t budget_bytes, const char* scratch) {
+    return new EventCache(filename, static_cast<const EventStore*>(store), budget_bytes, scratch);
+}
+
+// The event at 0-based `index` as a new event pointer like those of
+// read_hepmc_file, or nullptr past the last event. Without `copy` the pointer
+// shares the cached event, which must not be modified: event pointers are
+// std::shared_ptr<GenEvent>, so the const is cast away here. With `copy` it
+// owns a private copy. Either way, events still held by the caller do not
+// count against the cache's budget.
+void* event_cache_get(void* cache, int64_t index, bool copy) {
+    auto c = static_cast<EventCache*>(cache);
+    if (copy) {
+        auto event = c->get_copy(index);
+        return event ? new std::shared_ptr<GenEvent>(std::move(event)) : nullptr;
+    }
+    auto event = c->get(index);
+    return event ? new std::shared_ptr<GenEvent>(std::const_pointer_cast<GenEvent>(event)) : nullptr;
+}
+
+void event_cache_counts(void* cache, int64_t* out) {
+    static_cast<EventCache*>(cache)->stats(out);
+}
+
+void delete_event_cache(void* cache) {
+    delete static_cast<EventCache*>(cache);
+}
@@ -0,0 +1,100 @@
+#ifndef HEPMC3_WRAP_STORE_H
+#define HEPMC3_WRAP_STORE_H
+
+// Packed in-memory event storage (HepMC3WrapStore.cpp).
+
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenRunInfo.h"
+#include "HepMC3/Data/GenEventData.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Events stored column by column: one entry per event for the event fields
+// and offsets, then flat columns of all particles, vertices, links, weights
+// and attributes. With `single_precision`, momenta, masses and vertex
+// positions are kept as float. Events are rebuilt as GenEvents on demand
+// with materialize(), which may run on several threads at once; add() may
+// not run concurrently with anything else.
+class EventStore {
+public:
+    explicit EventStore(bool single_precision);
+
+    void add(const HepMC3::GenEvent& event);
+
+    size_t size() const { return m_event_number.size(); }
+
+    void materialize(size_t index, HepMC3::GenEvent& event, bool in_arena) const;
+
+    // Index of the first event with `event_number`, or -1
+    int64_t find(int event_number) const;
+
+    // Give back spare column capacity after the last add()
+    void shrink_to_fit();
+
+    // events, particles, vertices, bytes held by the columns
+    void stats(int64_t* out) const;
+
+private:
+    void put(double value, std::vector<double>& wide, std::vector<float>& narrow) {
+        if (m_single) {
+            narrow.push_back(static_cast<float>(value));
+        } else {
+            wide.push_back(value);
+        }
+    }
+
+    double get(size_t i, const std::vector<double>& wide, const std::vector<float>& narrow) const {
+        return m_single ? narrow[i] : wide[i];
+    }
+
+    bool m_single;
+    // Distinct run infos (usually one), indexed per event by m_run_info_index
+    std::vector<std::shared_ptr<HepMC3::GenRunInfo>> m_run_infos;
+
+    // Per event; the *_begin columns have one extra entry at the end
+    std::vector<int32_t> m_event_number;
+    std::vector<uint32_t> m_run_info_index;
+    std::vector<uint8_t> m_units;
+    std::vector<double> m_event_pos;
+    std::vector<uint64_t> m_particle_begin{0};
+    std::vector<uint64_t> m_vertex_begin{0};
+    std::vector<uint64_t> m_link_begin{0};
+    std::vector<uint64_t> m_weight_begin{0};
+    std::vector<uint64_t> m_attribute_begin{0};
+
+    // Particles; masses are NaN when not set
+    std::vector<int32_t> m_pid;
+    std::vector<int32_t> m_status;
+    std::vector<double> m_momentum;
+    std::vector<float> m_momentum_single;
+    std::vector<double> m_mass;
+    std::vector<float> m_mass_single;
+
+    std::vector<int32_t> m_vertex_status;
+    std::vector<double> m_position;
+    std::vector<float> m_position_single;
+
+    std::vector<int32_t> m_links1;
+    std::vector<int32_t> m_links2;
+    std::vector<double> m_weights;
+
+    // Attributes: names are stored once per store, values in one buffer
+    std::vector<int32_t> m_attribute_id;
+    std::vector<uint32_t> m_attribute_name;
+    std::vector<uint64_t> m_value_begin{0};
+    std::string m_values;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, uint32_t> m_name_index;
+
+    // Event numbers are usually increasing and searched directly; otherwise
+    // find() sorts positions by event number once
+    bool m_numbers_sorted = true;
+    mutable std::mutex m_order_mutex;
+    mutable std::vector<size_t> m_order;
+};
+
+#endif
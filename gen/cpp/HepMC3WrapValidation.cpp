@@ -0,0 +1,185 @@
+#include "HepMC3Wrap.h"
+#include "HepMC3/GenEvent.h"
+#include "HepMC3/GenParticle.h"
+#include "HepMC3/GenVertex.h"
+#include "HepMC3/ReaderAscii.h"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+using namespace HepMC3;
+
+// ---------------------------------------------------------------------------
+// Four-momentum conservation
+// ---------------------------------------------------------------------------
+
+namespace {
+
+// Per-vertex sums kept as separate component arrays, so the final tolerance
+// test is a straight loop over contiguous doubles.
+struct MomentumResiduals {
+    std::vector<double> px, py, pz, e;   // sum(in) - sum(out)
+    std::vector<double> e_in;            // sum of incoming energies
+    std::vector<unsigned char> links;    // bit 0: has incoming, bit 1: has outgoing
+    std::vector<double> metric;          // largest |component|, scaled if relative
+};
+
+// Vertex position (0-based) of a vertex that belongs to `event`, -1 otherwise.
+inline int vertex_position(const GenEvent* event, const GenVertex* v, int n_vertices) {
+    if (!v || v->parent_event() != event) return -1;
+    const int position = -v->id() - 1;
+    return position < n_vertices ? position : -1;
+}
+
+// Accumulate sum(in) - sum(out) for every vertex in one pass over the
+// particles: each particle is added at its end vertex and subtracted at its
+// production vertex. Returns the number of vertices that have both incoming
+// and outgoing particles and exceed the tolerance; residuals with a NaN
+// component count as infinite.
+int compute_residuals(const GenEvent* event, double tolerance, bool relative, MomentumResiduals& r) {
+    const int n = event->vertices().size();
+    r.px.assign(n, 0.0);
+    r.py.assign(n, 0.0);
+    r.pz.assign(n, 0.0);
+    r.e.assign(n, 0.0);
+    r.e_in.assign(n, 0.0);
+    r.links.assign(n, 0);
+    r.metric.resize(n);
+
+    for (const auto& p : event->particles()) {
+        const FourVector& m = p->momentum();
+        const int end = vertex_position(event, p->end_vertex().get(), n);
+        if (end >= 0) {
+            r.px[end] += m.px();
+            r.py[end] += m.py();
+            r.pz[end] += m.pz();
+            r.e[end] += m.e();
+            r.e_in[end] += m.e();
+            r.links[end] |= 1;
+        }
+        const int production = vertex_position(event, p->production_vertex().get(), n);
+        if (production >= 0) {
+            r.px[production] -= m.px();
+            r.py[production] -= m.py();
+            r.pz[production] -= m.pz();
+            r.e[production] -= m.e();
+            r.links[production] |= 2;
+        }
+    }
+
+    int n_failed = 0;
+    for (int v = 0; v < n; ++v) {
+        const double largest = std::max(std::max(std::fabs(r.px[v]), std::fabs(r.py[v])),
+                                         std::max(std::fabs(r.pz[v]), std::fabs(r.e[v])));
+        const double metric = relative ? largest / std::max(r.e_in[v], 1e-300) : largest;
+        // std::max drops NaN components: a NaN anywhere makes the residual
+        // the worst possible one
+        r.metric[v] = std::isnan(metric + r.px[v] + r.py[v] + r.pz[v] + r.e[v]) ? HUGE_VAL : metric;
+        n_failed += (r.links[v] == 3) & !(r.metric[v] <= tolerance);
+    }
+    return n_failed;
+}
+
+inline bool vertex_failed(const MomentumResiduals& r, int v, double tolerance) {
+    return r.links[v] == 3 && !(r.metric[v] <= tolerance);
+}
+
+// Summary of a whole-file scan; only the first `max_records` failing
+// vertices are kept in full.
+struct MomentumFileCheck {
+    int64_t n_events = 0;
+    int64_t n_failed_events = 0;
+    int64_t n_failed_vertices = 0;
+    double max_metric = 0.0;
+    int max_records = 0;
+    std::vector<int> event_numbers;
+    std::vector<int> vertices;
+    std::vector<double> residuals;
+};
+
+}  // namespace
+
+// Check sum(p_in) - sum(p_out) at every vertex that has both incoming and
+// outgoing particles. A vertex fails when the largest absolute residual
+// component exceeds `tolerance`, or `tolerance` times the incoming energy if
+// `relative` is set. `vertices` (one int per vertex) receives the 1-based
+// positions of the failing vertices and `residuals` (four doubles per vertex)
+// their residuals as px, py, pz, e. Returns the number of failing vertices.
+int check_vertex_momentum_conservation(void* event, double tolerance, bool relative, int* vertices, double* residuals) {
+    MomentumResiduals r;
+    const int n_failed = compute_residuals(static_cast<const GenEvent*>(event), tolerance, relative, r);
+    int k = 0;
+    for (int v = 0; k < n_failed; ++v) {
+        if (!vertex_failed(r, v, tolerance)) continue;
+        vertices[k] = v + 1;
+        residuals[4 * k] = r.px[v];
+        residuals[4 * k + 1] = r.py[v];
+        residuals[4 * k + 2] = r.pz[v];
+        residuals[4 * k + 3] = r.e[v];
+        ++k;
+    }
+    return n_failed;
+}
+
+// Stream an ASCII file through one reused GenEvent and check every event.
+// Returns nullptr if the file cannot be opened.
+void* check_momentum_conservation_file(const char* filename, double tolerance, bool relative, int max_events, int max_records) {
+    ReaderAscii reader(filename);
+    if (reader.failed()) return nullptr;
+
+    auto check = new MomentumFileCheck();
+    check->max_records = max_records;
+    GenEvent event;
+    MomentumResiduals r;
+    while (!reader.failed() && (max_events < 0 || check->n_events < max_events)) {
+        reader.read_event(event);
+        if (reader.failed()) break;
+        check->n_events++;
+
+        const int n_failed = compute_residuals(&event, tolerance, relative, r);
+        for (size_t v = 0; v < r.metric.size(); ++v) {
+            if (r.links[v] == 3) check->max_metric = std::max(check->max_metric, r.metric[v]);
+        }
+        if (n_failed == 0) continue;
+        check->n_failed_events++;
+        check->n_failed_vertices += n_failed;
+        for (size_t v = 0; v < r.metric.size() && static_cast<int>(check->vertices.size()) < max_records; ++v) {
+            if (!vertex_failed(r, v, tolerance)) continue;
+            check->event_numbers.push_back(event.event_number());
+            check->vertices.push_back(v + 1);
+            check->residuals.insert(check->residuals.end(), {r.px[v], r.py[v], r.pz[v], r.e[v]});
+        }
+    }
+    reader.close();
+    return check;
+}
+
+// Events read, events with failures, failing vertices.
+void momentum_check_counts(void* check, int64_t* out) {
+    auto c = static_cast<MomentumFileCheck*>(check);
+    out[0] = c->n_events;
+    out[1] = c->n_failed_events;
+    out[2] = c->n_failed_vertices;
+}
+
+// Largest residual seen over all checked vertices, scaled like the tolerance.
+double momentum_check_max_residual(void* check) {
+    return static_cast<MomentumFileCheck*>(check)->max_metric;
+}
+
+int momentum_check_records_size(void* check) {
+    return static_cast<MomentumFileCheck*>(check)->vertices.size();
+}
+
+void copy_momentum_check_records(void* check, int* event_numbers, int* vertices, double* residuals) {
+    auto c = static_cast<MomentumFileCheck*>(check);
+    std::copy(c->event_numbers.begin(), c->event_numbers.end(), event_numbers);
+    std::copy(c->vertices.begin(), c->vertices.end(), vertices);
+    std::copy(c->residuals.begin(), c->residuals.end(), residuals);
+}
+
+void delete_momentum_check(void* check) {
+    delete static_cast<MomentumFileCheck*>(check);
+}
@@ -306,42 +306,6 @@ struct JlHepMC3_GenEvent: public Wrapper {
     t.method("attribute_names", [](HepMC3::GenEvent const* a)->std::vector<std::string> { return a->attribute_names(); }, jlcxx::arg("this"));
     t.method("attribute_names", [](HepMC3::GenEvent const* a, const int & arg0)->std::vector<std::string> { return a->attribute_names(arg0); }, jlcxx::arg("this"), jlcxx::arg("id"));
 
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::add_particle(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::add_particle(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:280:10
-    t.method("add_particle", [](HepMC3::GenEvent& a, HepMC3::GenParticlePtr arg0)->void { a.add_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("add_particle", [](HepMC3::GenEvent* a, HepMC3::GenParticlePtr arg0)->void { a->add_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::add_vertex(HepMC3::GenVertexPtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::add_vertex(HepMC3::GenVertexPtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:283:10
-    t.method("add_vertex", [](HepMC3::GenEvent& a, HepMC3::GenVertexPtr arg0)->void { a.add_vertex(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-    t.method("add_vertex", [](HepMC3::GenEvent* a, HepMC3::GenVertexPtr arg0)->void { a->add_vertex(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::remove_particle(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::remove_particle(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:291:10
-    t.method("remove_particle", [](HepMC3::GenEvent& a, HepMC3::GenParticlePtr arg0)->void { a.remove_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("remove_particle", [](HepMC3::GenEvent* a, HepMC3::GenParticlePtr arg0)->void { a->remove_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::remove_particles(std::vector<HepMC3::GenParticlePtr>) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::remove_particles(std::vector<HepMC3::GenParticlePtr>)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:297:10
-    t.method("remove_particles", [](HepMC3::GenEvent& a, std::vector<HepMC3::GenParticlePtr> arg0)->void { a.remove_particles(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-    t.method("remove_particles", [](HepMC3::GenEvent* a, std::vector<HepMC3::GenParticlePtr> arg0)->void { a->remove_particles(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::remove_vertex(HepMC3::GenVertexPtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::remove_vertex(HepMC3::GenVertexPtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:302:10
-    t.method("remove_vertex", [](HepMC3::GenEvent& a, HepMC3::GenVertexPtr arg0)->void { a.remove_vertex(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-    t.method("remove_vertex", [](HepMC3::GenEvent* a, HepMC3::GenVertexPtr arg0)->void { a->remove_vertex(arg0); }, jlcxx::arg("this"), jlcxx::arg("v"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::add_tree(const std::vector<HepMC3::GenParticlePtr> &) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::add_tree(const std::vector<HepMC3::GenParticlePtr> &)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:313:10
-    t.method("add_tree", [](HepMC3::GenEvent& a, const std::vector<HepMC3::GenParticlePtr> & arg0)->void { a.add_tree(arg0); }, jlcxx::arg("this"), jlcxx::arg("parts"));
-    t.method("add_tree", [](HepMC3::GenEvent* a, const std::vector<HepMC3::GenParticlePtr> & arg0)->void { a->add_tree(arg0); }, jlcxx::arg("this"), jlcxx::arg("parts"));
-
     DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::reserve(const size_t &, const size_t &) (" __HERE__ ")");
     // signature to use in the veto list: void HepMC3::GenEvent::reserve(const size_t &, const size_t &)
     // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:318:10
@@ -350,35 +314,12 @@ struct JlHepMC3_GenEvent: public Wrapper {
     t.method("reserve", [](HepMC3::GenEvent* a, const size_t & arg0)->void { a->reserve(arg0); }, jlcxx::arg("this"), jlcxx::arg("parts"));
     t.method("reserve", [](HepMC3::GenEvent* a, const size_t & arg0, const size_t & arg1)->void { a->reserve(arg0, arg1); }, jlcxx::arg("this"), jlcxx::arg("parts"), jlcxx::arg("verts"));
 
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::clear() (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::clear()
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:321:10
-    t.method("clear", [](HepMC3::GenEvent& a)->void { a.clear(); }, jlcxx::arg("this"));
-    t.method("clear", [](HepMC3::GenEvent* a)->void { a->clear(); }, jlcxx::arg("this"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::set_beam_particles(HepMC3::GenParticlePtr, HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::set_beam_particles(HepMC3::GenParticlePtr, HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:330:10
-    t.method("set_beam_particles", [](HepMC3::GenEvent& a, HepMC3::GenParticlePtr arg0, HepMC3::GenParticlePtr arg1)->void { a.set_beam_particles(arg0, arg1); }, jlcxx::arg("this"), jlcxx::arg("p1"), jlcxx::arg("p2"));
-    t.method("set_beam_particles", [](HepMC3::GenEvent* a, HepMC3::GenParticlePtr arg0, HepMC3::GenParticlePtr arg1)->void { a->set_beam_particles(arg0, arg1); }, jlcxx::arg("this"), jlcxx::arg("p1"), jlcxx::arg("p2"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::add_beam_particle(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::add_beam_particle(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:335:10
-    t.method("add_beam_particle", [](HepMC3::GenEvent& a, HepMC3::GenParticlePtr arg0)->void { a.add_beam_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p1"));
-    t.method("add_beam_particle", [](HepMC3::GenEvent* a, HepMC3::GenParticlePtr arg0)->void { a->add_beam_particle(arg0); }, jlcxx::arg("this"), jlcxx::arg("p1"));
-
     DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::write_data(HepMC3::GenEventData &) (" __HERE__ ")");
     // signature to use in the veto list: void HepMC3::GenEvent::write_data(HepMC3::GenEventData &)
     // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:347:10
     t.method("write_data", [](HepMC3::GenEvent const& a, HepMC3::GenEventData & arg0)->void { a.write_data(arg0); }, jlcxx::arg("this"), jlcxx::arg("data"));
     t.method("write_data", [](HepMC3::GenEvent const* a, HepMC3::GenEventData & arg0)->void { a->write_data(arg0); }, jlcxx::arg("this"), jlcxx::arg("data"));
 
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenEvent::read_data(const HepMC3::GenEventData &) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenEvent::read_data(const HepMC3::GenEventData &)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenEvent.h:350:10
-    t.method("read_data", [](HepMC3::GenEvent& a, const HepMC3::GenEventData & arg0)->void { a.read_data(arg0); }, jlcxx::arg("this"), jlcxx::arg("data"));
-    t.method("read_data", [](HepMC3::GenEvent* a, const HepMC3::GenEventData & arg0)->void { a->read_data(arg0); }, jlcxx::arg("this"), jlcxx::arg("data"));
   }
 
 private:
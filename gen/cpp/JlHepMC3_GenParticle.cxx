@@ -140,12 +140,6 @@ struct JlHepMC3_GenParticle: public Wrapper {
     t.method("generated_mass", [](HepMC3::GenParticle const& a)->double { return a.generated_mass(); }, jlcxx::arg("this"));
     t.method("generated_mass", [](HepMC3::GenParticle const* a)->double { return a->generated_mass(); }, jlcxx::arg("this"));
 
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenParticle::set_pid(int) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenParticle::set_pid(int)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenParticle.h:107:10
-    t.method("set_pid", [](HepMC3::GenParticle& a, int arg0)->void { a.set_pid(arg0); }, jlcxx::arg("this"), jlcxx::arg("pid"));
-    t.method("set_pid", [](HepMC3::GenParticle* a, int arg0)->void { a->set_pid(arg0); }, jlcxx::arg("this"), jlcxx::arg("pid"));
-
     DEBUG_MSG("Adding wrapper for void HepMC3::GenParticle::set_status(int) (" __HERE__ ")");
     // signature to use in the veto list: void HepMC3::GenParticle::set_status(int)
     // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenParticle.h:108:10
@@ -199,12 +193,6 @@ struct JlHepMC3_GenParticle: public Wrapper {
     // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenParticle.h:139:9
     t.method("pdg_id", [](HepMC3::GenParticle const& a)->int { return a.pdg_id(); }, jlcxx::arg("this"));
     t.method("pdg_id", [](HepMC3::GenParticle const* a)->int { return a->pdg_id(); }, jlcxx::arg("this"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenParticle::set_pdg_id(const int &) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenParticle::set_pdg_id(const int &)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenParticle.h:143:10
-    t.method("set_pdg_id", [](HepMC3::GenParticle& a, const int & arg0)->void { a.set_pdg_id(arg0); }, jlcxx::arg("this"), jlcxx::arg("pidin"));
-    t.method("set_pdg_id", [](HepMC3::GenParticle* a, const int & arg0)->void { a->set_pdg_id(arg0); }, jlcxx::arg("this"), jlcxx::arg("pidin"));
   }
 
 private:
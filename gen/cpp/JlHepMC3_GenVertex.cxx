@@ -78,30 +78,6 @@ struct JlHepMC3_GenVertex: public Wrapper {
     t.method("data", [](HepMC3::GenVertex const& a)->const HepMC3::GenVertexData & { return a.data(); }, jlcxx::arg("this"));
     t.method("data", [](HepMC3::GenVertex const* a)->const HepMC3::GenVertexData & { return a->data(); }, jlcxx::arg("this"));
 
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenVertex::add_particle_in(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenVertex::add_particle_in(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenVertex.h:78:10
-    t.method("add_particle_in", [](HepMC3::GenVertex& a, HepMC3::GenParticlePtr arg0)->void { a.add_particle_in(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("add_particle_in", [](HepMC3::GenVertex* a, HepMC3::GenParticlePtr arg0)->void { a->add_particle_in(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenVertex::add_particle_out(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenVertex::add_particle_out(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenVertex.h:80:10
-    t.method("add_particle_out", [](HepMC3::GenVertex& a, HepMC3::GenParticlePtr arg0)->void { a.add_particle_out(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("add_particle_out", [](HepMC3::GenVertex* a, HepMC3::GenParticlePtr arg0)->void { a->add_particle_out(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenVertex::remove_particle_in(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenVertex::remove_particle_in(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenVertex.h:82:10
-    t.method("remove_particle_in", [](HepMC3::GenVertex& a, HepMC3::GenParticlePtr arg0)->void { a.remove_particle_in(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("remove_particle_in", [](HepMC3::GenVertex* a, HepMC3::GenParticlePtr arg0)->void { a->remove_particle_in(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
-    DEBUG_MSG("Adding wrapper for void HepMC3::GenVertex::remove_particle_out(HepMC3::GenParticlePtr) (" __HERE__ ")");
-    // signature to use in the veto list: void HepMC3::GenVertex::remove_particle_out(HepMC3::GenParticlePtr)
-    // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenVertex.h:84:10
-    t.method("remove_particle_out", [](HepMC3::GenVertex& a, HepMC3::GenParticlePtr arg0)->void { a.remove_particle_out(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-    t.method("remove_particle_out", [](HepMC3::GenVertex* a, HepMC3::GenParticlePtr arg0)->void { a->remove_particle_out(arg0); }, jlcxx::arg("this"), jlcxx::arg("p"));
-
     DEBUG_MSG("Adding wrapper for int HepMC3::GenVertex::particles_in_size() (" __HERE__ ")");
     // signature to use in the veto list: int HepMC3::GenVertex::particles_in_size()
     // defined in /home/dorachan/.julia/artifacts/7594d64d7c28f9689b484bf4d09af6dbb8b5123c/include/HepMC3/GenVertex.h:87:16
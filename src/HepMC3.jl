@@ -44,5 +44,16 @@ end
 
 include("HepMC3Utils.jl")
 include("HepMC3Interface.jl")
+include("HepMC3Graph.jl")
+include("HepMC3Validation.jl")
+include("HepMC3IO.jl")
+include("HepMC3Columns.jl")
+include("HepMC3Engine.jl")
+include("HepMC3Pipeline.jl")
+include("HepMC3Memory.jl")
+include("HepMC3Attributes.jl")
+include("HepMC3Store.jl")
+include("HepMC3FourVector.jl")
+include("HepMC3Kinematics.jl")
 
 end # module
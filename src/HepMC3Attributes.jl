@@ -0,0 +1,156 @@
+# Attribute policies and attribute tables implemented in the C++ layer (HepMC3WrapAttributes.cpp).
+
+export AttributePolicy, attribute_policy_stats, apply_attribute_policy!
+export AttributeInterner, event_attributes
+
+const _ATTRIBUTE_ACTIONS = (keep = 0, drop = 1, parse = 2)
+
+"""
+    AttributePolicy(rules::Pair...)
+
+What to do with attributes as events are read, by attribute name. Each rule
+maps a glob pattern (`*` and `?`) to an action; the first matching rule
+applies and unmatched attributes are kept:
+
+- `:keep`: leave the attribute as read; it is stored as text and parsed on
+  first typed access
+- `:drop`: remove it from the event
+- `:parse`: convert it to a typed attribute right away: `GenCrossSection`,
+  `GenPdfInfo` and `GenHeavyIon` get their own types, integer and other
+  numeric values become `IntAttribute` (`LongAttribute` beyond 32 bits) and
+  `DoubleAttribute`, and other values stay strings
+
+Pass the policy to `read_hepmc_file(filename; attributes=policy)` or
+[`read_pooled_event`](@ref), or apply it with
+[`apply_attribute_policy!`](@ref).
+
+# Examples
+```julia
+# Keep the cross section parsed, drop per-particle shower tags
+policy = AttributePolicy("GenCrossSection" => :parse, "flow*" => :drop, "theta" => :drop, "phi" => :drop)
+events = read_hepmc_file("sherpa.hepmc3"; attributes=policy)
+```
+"""
+mutable struct AttributePolicy
+    ptr::Ptr{Cvoid}
+    rules::Vector{Pair{String,Symbol}}
+
+    function AttributePolicy(rules::Pair...)
+        checked = Pair{String,Symbol}[]
+        for (pattern, action) in rules
+            haskey(_ATTRIBUTE_ACTIONS, action) ||
+                throw(ArgumentError("unknown attribute action $(repr(action)); use :keep, :drop or :parse"))
+            push!(checked, String(pattern) => action)
+        end
+        policy = new(create_attribute_policy(), checked)
+        finalizer(_delete_attribute_policy, policy)
+        for (pattern, action) in checked
+            attribute_policy_add_rule(policy.ptr, pattern, Cint(_ATTRIBUTE_ACTIONS[action]))
+        end
+        return policy
+    end
+end
+
+function _delete_attribute_policy(policy::AttributePolicy)
+    if policy.ptr != C_NULL
+        delete_attribute_policy(policy.ptr)
+        policy.ptr = C_NULL
+    end
+    return nothing
+end
+
+function _attribute_policy_pointer(policy::AttributePolicy)
+    policy.ptr == C_NULL && error("AttributePolicy has been freed")
+    return policy.ptr
+end
+
+_attribute_policy_pointer(::Nothing) = C_NULL
+
+"""
+    attribute_policy_stats(policy::AttributePolicy)
+
+`(kept, dropped, parsed)`: attribute entries the policy has handled so far,
+over all events.
+"""
+function attribute_policy_stats(policy::AttributePolicy)
+    counts = zeros(Int64, 3)
+    GC.@preserve counts attribute_policy_counts(_attribute_policy_pointer(policy), pointer(counts))
+    return (kept = counts[1], dropped = counts[2], parsed = counts[3])
+end
+
+"""
+    apply_attribute_policy!(event, policy::AttributePolicy)
+
+Apply `policy` to the attributes of `event` (a `GenEvent` or an event
+pointer). Returns `event`.
+"""
+function apply_attribute_policy!(event, policy::AttributePolicy)
+    GC.@preserve event apply_attribute_policy(_attribute_policy_pointer(policy), _event_pointer(event))
+    return event
+end
+
+"""
+    AttributeInterner()
+
+Table of attribute names and values shared across calls to
+[`event_attributes`](@ref): every distinct string is stored once, and tables
+of later events refer to the same `String` objects. Use one interner for a
+whole sample whose attributes repeat the same tags. `length(interner)` is the
+number of distinct strings.
+"""
+mutable struct AttributeInterner
+    strings::Dict{String,Nothing}
+    lookups::Int
+end
+
+AttributeInterner() = AttributeInterner(Dict{String,Nothing}(), 0)
+
+Base.length(interner::AttributeInterner) = length(interner.strings)
+
+function _intern!(interner::AttributeInterner, s::AbstractString)
+    interner.lookups += 1
+    interned = getkey(interner.strings, s, nothing)
+    if interned === nothing
+        interned = String(s)
+        interner.strings[interned] = nothing
+    end
+    return interned
+end
+
+_intern!(::Nothing, s::AbstractString) = String(s)
+
+"""
+    event_attributes(event; interner=nothing)
+
+All attributes of `event` as columns `(id, name, value)`, ordered by name and
+then id: `id` is the particle (> 0), vertex (< 0) or event (`0`) id and
+`value` the attribute's text form. The strings are copied from C++ in one
+call; with an [`AttributeInterner`](@ref), repeated names and values share
+one `String` across rows and events.
+
+# Examples
+```julia
+interner = AttributeInterner()
+for event in events
+    table = event_attributes(event; interner)
+    tagged = table.id[table.name .== "flow1"]
+end
+```
+"""
+function event_attributes(event; interner::Union{AttributeInterner,Nothing}=nothing)
+    ptr = _event_pointer(event)
+    sizes = zeros(Int64, 2)
+    GC.@preserve event sizes event_attribute_table_size(ptr, pointer(sizes))
+    n, n_bytes = Int(sizes[1]), Int(sizes[2])
+    n == 0 && return (id = Int[], name = String[], value = String[])
+
+    ids = Vector{Cint}(undef, n)
+    buffer = Vector{UInt8}(undef, max(n_bytes, 1))
+    offsets = Vector{Cint}(undef, 2n + 1)
+    GC.@preserve event ids buffer offsets copy_event_attribute_table(ptr, pointer(ids), pointer(buffer), pointer(offsets))
+    text = String(buffer)
+    piece(k) = SubString(text, offsets[k] + 1, prevind(text, offsets[k+1] + 1))
+    names = [_intern!(interner, piece(2i - 1)) for i in 1:n]
+    values = [_intern!(interner, piece(2i)) for i in 1:n]
+    return (id = Vector{Int}(ids), name = names, value = values)
+end
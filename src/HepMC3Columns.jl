@@ -0,0 +1,97 @@
+# Columnar event construction implemented in the C++ layer (HepMC3WrapColumns.cpp).
+
+export build_event, build_event!
+
+_float_column(x::Vector{Float64}) = x
+_float_column(x) = Vector{Float64}(x)
+_int_column(x::Vector{Cint}) = x
+_int_column(x) = Vector{Cint}(x)
+
+function _check_column_length(name, column, n)
+    length(column) == n || throw(DimensionMismatch("column $name has length $(length(column)), expected $n"))
+    return column
+end
+
+"""
+    build_event!(event, particles, vertices; production, end_vertex, arena=false)
+
+Replace the content of `event` with particles and vertices given as columns,
+in one C++ call. The event keeps its number, units and weights.
+
+- `particles`: named tuple of equal-length columns `px`, `py`, `pz`, `e`,
+  `pdg`, `status` and optionally `mass` (`NaN` entries leave the generated
+  mass unset)
+- `vertices`: the number of vertices, or a named tuple with columns `x`, `y`,
+  `z`, `t` and/or `status`
+- `production`, `end_vertex`: per particle, the 1-based index of its
+  production and end vertex, or `0` for none
+
+Particle `i` gets id `i` and vertex `j` gets id `-j`, as with
+`get_particle_at` and `get_vertex_at`. With `arena=true`, all particles and
+vertices are allocated from one per-event block, as with
+[`compact_event!`](@ref). Returns `event`.
+"""
+function build_event!(event, particles::NamedTuple, vertices; production, end_vertex, arena::Bool=false)
+    n = length(particles.px)
+    px = _check_column_length(:px, _float_column(particles.px), n)
+    py = _check_column_length(:py, _float_column(particles.py), n)
+    pz = _check_column_length(:pz, _float_column(particles.pz), n)
+    e = _check_column_length(:e, _float_column(particles.e), n)
+    pdg = _check_column_length(:pdg, _int_column(particles.pdg), n)
+    status = _check_column_length(:status, _int_column(particles.status), n)
+    mass = haskey(particles, :mass) ? _check_column_length(:mass, _float_column(particles.mass), n) : Float64[]
+    prod = _check_column_length(:production, _int_column(production), n)
+    stop = _check_column_length(:end_vertex, _int_column(end_vertex), n)
+
+    if vertices isa Integer
+        n_vertices = Int(vertices)
+        x = y = z = t = Float64[]
+        vertex_status = Cint[]
+    else
+        n_vertices = length(first(values(vertices)))
+        zero_column = zeros(n_vertices)
+        x = haskey(vertices, :x) ? _check_column_length(:x, _float_column(vertices.x), n_vertices) : zero_column
+        y = haskey(vertices, :y) ? _check_column_length(:y, _float_column(vertices.y), n_vertices) : zero_column
+        z = haskey(vertices, :z) ? _check_column_length(:z, _float_column(vertices.z), n_vertices) : zero_column
+        t = haskey(vertices, :t) ? _check_column_length(:t, _float_column(vertices.t), n_vertices) : zero_column
+        vertex_status = haskey(vertices, :status) ?
+            _check_column_length(:status, _int_column(vertices.status), n_vertices) : zeros(Cint, n_vertices)
+    end
+
+    # Empty optional columns are passed as null pointers
+    column_pointer(c::Vector{T}) where {T} = isempty(c) ? Ptr{T}(C_NULL) : pointer(c)
+    GC.@preserve event px py pz e pdg status mass x y z t vertex_status prod stop begin
+        build_event_from_columns(_event_pointer(event), Cint(n), pointer(px), pointer(py), pointer(pz), pointer(e),
+                                 pointer(pdg), pointer(status), column_pointer(mass),
+                                 Cint(n_vertices), column_pointer(x), column_pointer(y), column_pointer(z),
+                                 column_pointer(t), column_pointer(vertex_status), column_pointer(prod),
+                                 column_pointer(stop), arena)
+    end
+    _collect_native_garbage()
+    return event
+end
+
+"""
+    build_event(particles, vertices; production, end_vertex, event_number=1,
+                momentum_unit=:GeV, length_unit=:mm, weights=nothing, arena=false)
+
+Create a new event from columns; see [`build_event!`](@ref).
+
+# Examples
+```julia
+# e+ e- -> Z -> mu+ mu-
+event = build_event(
+    (px = [0.0, 0.0, 0.0, 10.0, -10.0], py = zeros(5), pz = [45.6, -45.6, 0.0, 44.5, -44.5],
+     e = [45.6, 45.6, 91.2, 45.6, 45.6], pdg = [11, -11, 23, 13, -13], status = [4, 4, 2, 1, 1]),
+    2;
+    production = [0, 0, 1, 2, 2],
+    end_vertex = [1, 1, 2, 0, 0])
+```
+"""
+function build_event(particles::NamedTuple, vertices; production, end_vertex, event_number::Integer=1,
+                     momentum_unit=:GeV, length_unit=:mm, weights=nothing, arena::Bool=false)
+    event = create_event(Int(event_number))
+    set_units!(event, momentum_unit, length_unit)
+    weights === nothing || set_event_weights!(event, Vector{Float64}(weights))
+    return build_event!(event, particles, vertices; production, end_vertex, arena)
+end
@@ -0,0 +1,195 @@
+# Parallel event processing implemented in the C++ layer (HepMC3WrapEngine.cpp).
+
+export run_engine, fill_histograms
+
+const _INTEGER_COLUMNS = (:pdg, :status, :n_selected, :event_number)
+
+function _event_batch(events::AbstractVector)
+    batch = create_event_batch()
+    try
+        for event in events
+            if event isa Ptr{Nothing}
+                event_batch_add_shared(batch, event)
+            else
+                event_batch_add(batch, _event_pointer(event))
+            end
+        end
+    catch
+        delete_event_batch(batch)
+        rethrow()
+    end
+    return batch
+end
+
+# Run `kernel` and return the C++ result handle; the caller deletes it.
+function _run_event_engine(source, kernel; status::Integer=0, pdg=Int[], pt_min::Real=0.0,
+                           abs_eta_max::Real=Inf, histograms::Ptr{Cvoid}=C_NULL, threads::Integer=0,
+                           chunk_size::Integer=64, max_events::Integer=-1)
+    source isa AbstractString && !isfile(source) && throw(ArgumentError("File not found: $source"))
+    abs_pdg = Cint[abs(p) for p in pdg]
+    batch = source isa AbstractString ? C_NULL : _event_batch(source)
+    filename = source isa AbstractString ? String(source) : ""
+    result = try
+        GC.@preserve source abs_pdg run_event_engine(filename, batch, String(kernel), Cint(status),
+                                                     isempty(abs_pdg) ? Ptr{Cint}(C_NULL) : pointer(abs_pdg),
+                                                     Cint(length(abs_pdg)), Float64(pt_min), Float64(abs_eta_max),
+                                                     histograms, Cint(threads), Cint(chunk_size), Int64(max_events))
+    finally
+        batch == C_NULL || delete_event_batch(batch)
+    end
+    if engine_result_failed(result)
+        message = _cstring_to_string(engine_result_error(result))
+        delete_engine_result(result)
+        error("Event engine failed: $message")
+    end
+    return result
+end
+
+function _engine_columns(result)
+    n_rows = engine_result_rows(result)
+    events = Vector{Int64}(undef, n_rows)
+    GC.@preserve events copy_engine_result_events(result, pointer(events))
+    names = Symbol[:event]
+    columns = Any[events .+ 1]
+    for i in 0:engine_result_columns_size(result)-1
+        name = Symbol(_cstring_to_string(engine_result_column_name(result, Cint(i))))
+        column = Vector{Float64}(undef, n_rows)
+        GC.@preserve column copy_engine_result_column(result, Cint(i), pointer(column))
+        push!(names, name)
+        push!(columns, name in _INTEGER_COLUMNS ? round.(Int, column) : column)
+    end
+    return NamedTuple{Tuple(names)}(Tuple(columns))
+end
+
+"""
+    run_engine(source; kernel=:particles, status=0, pdg=Int[], pt_min=0.0,
+               abs_eta_max=Inf, threads=0, chunk_size=64, max_events=-1)
+
+Run a compiled C++ kernel over all events of `source`, a HepMC3 ASCII file
+name or a vector of events (`GenEvent`s or pointers from `read_hepmc_file`),
+on a work-stealing pool of `threads` C++ threads (all cores when `0`).
+Events are handed out in chunks of `chunk_size`; for files, the text of each
+chunk is also parsed on the pool. Julia threads are not involved.
+
+The particle selection (`status`, `abs.(pdg)`, `pt_min`, `abs_eta_max`; `0`
+and empty accept everything) is applied by the kernels:
+
+- `:particles`: one row per selected particle with `pt`, `eta`, `phi`, `e`,
+  `mass`, `pdg`, `status`
+- `:events`: one row per event with `event_number`, `weight` (the first
+  weight), `n_selected`, `ht` (scalar sum of selected pt) and `leading_pt`
+
+Kernels written in C++ can be added with `register_event_kernel` (see
+`HepMC3WrapEngine.h`) and selected by name.
+
+Returns a named tuple of columns in event order. Its first column, `event`,
+gives the 1-based position in `source` of the event behind each row.
+
+# Examples
+```julia
+muons = run_engine("events.hepmc3"; status=1, pdg=[13], pt_min=20.0, abs_eta_max=2.5)
+muons.pt, muons.event
+
+summary = run_engine(read_hepmc_file("events.hepmc3"); kernel=:events, status=1, threads=8)
+```
+"""
+function run_engine(source; kernel=:particles, kwargs...)
+    result = _run_event_engine(source, kernel; kwargs...)
+    try
+        return _engine_columns(result)
+    finally
+        delete_engine_result(result)
+    end
+end
+
+const _HISTOGRAM_QUANTITIES = Dict(:pt => 1, :eta => 2, :phi => 3, :e => 4, :mass => 5, :rapidity => 6,
+                                   :n_selected => 11, :ht => 12, :leading_pt => 13)
+
+function _histogram_axis(quantity::Symbol, edges)
+    haskey(_HISTOGRAM_QUANTITIES, quantity) ||
+        throw(ArgumentError("unknown histogram quantity :$quantity; use one of $(sort(collect(keys(_HISTOGRAM_QUANTITIES))))"))
+    return Cint(_HISTOGRAM_QUANTITIES[quantity]), Vector{Float64}(edges)
+end
+
+function _add_histogram(set, spec)
+    if spec isa Tuple{Tuple,Tuple}
+        (qx, ex), (qy, ey) = _histogram_axis(spec[1]...), _histogram_axis(spec[2]...)
+    else
+        (qx, ex), (qy, ey) = _histogram_axis(spec...), (Cint(0), Float64[])
+    end
+    GC.@preserve ex ey histogram_set_add(set, qx, pointer(ex), Cint(length(ex) - 1), qy,
+                                         isempty(ey) ? Ptr{Float64}(C_NULL) : pointer(ey), Cint(length(ey) - 1))
+    return nothing
+end
+
+function _histogram_result(set, i, spec)
+    n = histogram_bins_size(set, Cint(i))
+    sumw, sumw2 = Vector{Float64}(undef, n), Vector{Float64}(undef, n)
+    GC.@preserve sumw sumw2 copy_histogram_bins(set, Cint(i), pointer(sumw), pointer(sumw2))
+    entries = Int(histogram_entries(set, Cint(i)))
+    if spec isa Tuple{Tuple,Tuple}
+        xedges, yedges = Vector{Float64}(spec[1][2]), Vector{Float64}(spec[2][2])
+        shape = (length(xedges) + 1, length(yedges) + 1)
+        w, w2 = reshape(sumw, shape), reshape(sumw2, shape)
+        inner = (2:shape[1]-1, 2:shape[2]-1)
+        return (xedges = xedges, yedges = yedges, sumw = w[inner...], sumw2 = w2[inner...],
+                outside = sum(w) - sum(w[inner...]), entries = entries)
+    end
+    return (edges = Vector{Float64}(spec[2]), sumw = sumw[2:end-1], sumw2 = sumw2[2:end-1],
+            underflow = sumw[1], overflow = sumw[end], entries = entries)
+end
+
+"""
+    fill_histograms(source; histograms, weight=nothing, status=0, pdg=Int[],
+                    pt_min=0.0, abs_eta_max=Inf, threads=0, chunk_size=64, max_events=-1)
+
+Fill histograms from the events of `source` in C++, on the same thread pool
+and with the same particle selection as [`run_engine`](@ref). Each worker
+fills its own copy of the histograms; the copies are merged at the end, so no
+value crosses into Julia until the bins are returned.
+
+`histograms` is a named tuple of specifications:
+
+- `(quantity, edges)` for a 1D histogram
+- `((quantity_x, edges_x), (quantity_y, edges_y))` for a 2D histogram
+
+Particle quantities `:pt`, `:eta`, `:phi`, `:e`, `:mass`, `:rapidity` are
+filled once per selected particle; event quantities `:n_selected`, `:ht`,
+`:leading_pt` once per event. Both axes of a 2D histogram must be of the same
+kind. `edges` may be any increasing vector or range; equally spaced edges use
+a direct bin lookup. Bins include their lower edge.
+
+`weight=i` weights each fill with the event's `i`-th weight; by default every
+fill has weight 1.
+
+Returns a named tuple with the same names. 1D results hold `edges`, `sumw`,
+`sumw2`, `underflow`, `overflow` and `entries`; 2D results hold `xedges`,
+`yedges`, matrices `sumw` and `sumw2` indexed `[ix, iy]`, `outside` (the
+weight that fell outside the bins) and `entries`.
+
+# Examples
+```julia
+h = fill_histograms("events.hepmc3"; status=1, pdg=[13], weight=1,
+                    histograms=(pt = (:pt, 0:5:200),
+                                eta_phi = ((:eta, range(-2.5, 2.5; length=51)), (:phi, range(-π, π; length=65))),
+                                ht = (:ht, [0, 50, 100, 200, 500, 1000])))
+h.pt.sumw, sqrt.(h.pt.sumw2)
+```
+"""
+function fill_histograms(source; histograms::NamedTuple, weight::Union{Nothing,Integer}=nothing, kwargs...)
+    weight === nothing || weight >= 1 || throw(ArgumentError("weight must be a 1-based weight index"))
+    set = create_histogram_set(Cint(weight === nothing ? -1 : weight - 1))
+    result = try
+        foreach(spec -> _add_histogram(set, spec), values(histograms))
+        _run_event_engine(source, :histograms; histograms = set, kwargs...)
+    finally
+        delete_histogram_set(set)
+    end
+    try
+        merged = engine_result_histograms(result)
+        return NamedTuple{keys(histograms)}(Tuple(_histogram_result(merged, i - 1, spec)
+                                                  for (i, spec) in enumerate(values(histograms))))
+    finally
+        delete_engine_result(result)
+    end
+end
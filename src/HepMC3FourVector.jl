@@ -0,0 +1,157 @@
+# Isbits mirror of HepMC3::FourVector with the kinematics of JlHepMC3_FourVector.cxx in Julia.
+
+export LorentzVector, event_momenta, event_positions
+export m, m2, perp, perp2, pt, pt2, eta, abs_eta, pseudoRapidity, rap, abs_rap, phi, theta
+export p3mod, p3mod2, rho, length2, interval, is_zero
+export delta_phi, delta_eta, delta_rap, delta_r_eta, delta_r2_eta, delta_r_rap, delta_r2_rap
+
+"""
+    LorentzVector(x, y, z, t)
+    LorentzVector(v::FourVector)
+
+Plain-data copy of a HepMC3 `FourVector`: four `Float64`s, stored inline in
+arrays and passed by value, with the `FourVector` accessors and kinematics
+(`px`, `e`, `m`, `perp`, `eta`, `rap`, `phi`, `delta_r_eta`, ...) implemented
+in Julia with HepMC3's conventions. Unlike calls on a `FourVector`, none of
+them crosses into C++, so loops over momenta are inlined and vectorised.
+
+Get the momenta of a whole event with [`event_momenta`](@ref) (one C++ call),
+convert single vectors with `LorentzVector(momentum(particle))` and go back
+with `FourVector(v)`. `+`, `-`, scaling and `==` work as for `FourVector`,
+and `≈` compares all four components.
+
+# Examples
+```julia
+p = event_momenta(event)
+leptons = filter(v -> pt(v) > 20.0 && abs_eta(v) < 2.5, p)
+mll = m(leptons[1] + leptons[2])
+```
+"""
+struct LorentzVector
+    x::Float64
+    y::Float64
+    z::Float64
+    t::Float64
+end
+
+LorentzVector(x::Real, y::Real, z::Real, t::Real) = LorentzVector(Float64(x), Float64(y), Float64(z), Float64(t))
+LorentzVector() = LorentzVector(0.0, 0.0, 0.0, 0.0)
+# Also accepts the references returned by momentum(particle) and position(vertex)
+LorentzVector(v) = LorentzVector(x(v), y(v), z(v), t(v))
+FourVector(v::LorentzVector) = FourVector(v.x, v.y, v.z, v.t)
+
+Base.convert(::Type{LorentzVector}, v::FourVector) = LorentzVector(v)
+Base.broadcastable(v::LorentzVector) = Ref(v)
+Base.zero(::Type{LorentzVector}) = LorentzVector()
+Base.zero(::LorentzVector) = LorentzVector()
+
+# Component-wise, as FourVector::operator== and the approximate form of it
+Base.:(==)(a::LorentzVector, b::LorentzVector) = a.x == b.x && a.y == b.y && a.z == b.z && a.t == b.t
+
+# As isapprox on the vectors of the four components, without allocating them:
+# the Euclidean norm of the difference against the larger of the norms
+@inline _norm4(v::LorentzVector) = sqrt(v.x^2 + v.y^2 + v.z^2 + v.t^2)
+
+function Base.isapprox(a::LorentzVector, b::LorentzVector; atol::Real=0,
+                       rtol::Real=atol > 0 ? 0 : sqrt(eps(Float64)), nans::Bool=false)
+    a == b && return true
+    d = _norm4(a - b)
+    isfinite(d) && return d <= max(atol, rtol * max(_norm4(a), _norm4(b)))
+    # Inf, NaN or overflow: component by component, as for arrays
+    return isapprox(a.x, b.x; atol, rtol, nans) && isapprox(a.y, b.y; atol, rtol, nans) &&
+           isapprox(a.z, b.z; atol, rtol, nans) && isapprox(a.t, b.t; atol, rtol, nans)
+end
+
+Base.:+(a::LorentzVector, b::LorentzVector) = LorentzVector(a.x + b.x, a.y + b.y, a.z + b.z, a.t + b.t)
+Base.:-(a::LorentzVector, b::LorentzVector) = LorentzVector(a.x - b.x, a.y - b.y, a.z - b.z, a.t - b.t)
+Base.:-(a::LorentzVector) = LorentzVector(-a.x, -a.y, -a.z, -a.t)
+Base.:*(a::LorentzVector, s::Real) = LorentzVector(a.x * s, a.y * s, a.z * s, a.t * s)
+Base.:*(s::Real, a::LorentzVector) = a * s
+Base.:/(a::LorentzVector, s::Real) = LorentzVector(a.x / s, a.y / s, a.z / s, a.t / s)
+
+# Components
+@inline x(v::LorentzVector) = v.x
+@inline y(v::LorentzVector) = v.y
+@inline z(v::LorentzVector) = v.z
+@inline t(v::LorentzVector) = v.t
+@inline px(v::LorentzVector) = v.x
+@inline py(v::LorentzVector) = v.y
+@inline pz(v::LorentzVector) = v.z
+@inline e(v::LorentzVector) = v.t
+
+# Derived quantities, as in HepMC3/FourVector.h
+@inline length2(v::LorentzVector) = v.x^2 + v.y^2 + v.z^2
+@inline Base.length(v::LorentzVector) = sqrt(length2(v))
+@inline p3mod2(v::LorentzVector) = length2(v)
+@inline p3mod(v::LorentzVector) = length(v)
+@inline rho(v::LorentzVector) = length(v)
+@inline perp2(v::LorentzVector) = v.x^2 + v.y^2
+@inline perp(v::LorentzVector) = sqrt(perp2(v))
+@inline pt2(v::LorentzVector) = perp2(v)
+@inline pt(v::LorentzVector) = perp(v)
+@inline interval(v::LorentzVector) = v.t^2 - length2(v)
+@inline m2(v::LorentzVector) = interval(v)
+# Negative for space-like vectors
+@inline m(v::LorentzVector) = (mm = m2(v); mm > 0.0 ? sqrt(mm) : -sqrt(-mm))
+@inline phi(v::LorentzVector) = atan(v.y, v.x)
+@inline theta(v::LorentzVector) = atan(perp(v), v.z)
+@inline is_zero(v::LorentzVector) = v.x == 0.0 && v.y == 0.0 && v.z == 0.0 && v.t == 0.0
+
+# Zero for a null vector and ±Inf along the beam axis
+@inline function eta(v::LorentzVector)
+    p = p3mod(v)
+    p == 0.0 && return 0.0
+    p == abs(v.z) && return copysign(Inf, v.z)
+    return 0.5 * log((p + v.z) / (p - v.z))
+end
+
+@inline function rap(v::LorentzVector)
+    v.t == 0.0 && return 0.0
+    v.t == abs(v.z) && return copysign(Inf, v.z)
+    return 0.5 * log((v.t + v.z) / (v.t - v.z))
+end
+
+@inline pseudoRapidity(v::LorentzVector) = eta(v)
+@inline abs_eta(v::LorentzVector) = abs(eta(v))
+@inline abs_rap(v::LorentzVector) = abs(rap(v))
+
+# In [-π, π); NaN stays NaN
+@inline function delta_phi(a::LorentzVector, b::LorentzVector)
+    dphi = phi(a) - phi(b)
+    dphi = ifelse(dphi >= π, dphi - 2π, dphi)
+    return ifelse(dphi < -π, dphi + 2π, dphi)
+end
+
+@inline delta_eta(a::LorentzVector, b::LorentzVector) = eta(a) - eta(b)
+@inline delta_rap(a::LorentzVector, b::LorentzVector) = rap(a) - rap(b)
+@inline delta_r2_eta(a::LorentzVector, b::LorentzVector) = delta_eta(a, b)^2 + delta_phi(a, b)^2
+@inline delta_r_eta(a::LorentzVector, b::LorentzVector) = sqrt(delta_r2_eta(a, b))
+@inline delta_r2_rap(a::LorentzVector, b::LorentzVector) = delta_rap(a, b)^2 + delta_phi(a, b)^2
+@inline delta_r_rap(a::LorentzVector, b::LorentzVector) = sqrt(delta_r2_rap(a, b))
+
+"""
+    event_momenta(event)
+
+Momenta of all particles of `event` (a `GenEvent` or an event pointer), in
+particle order, as a `Vector{LorentzVector}` filled by one C++ call.
+"""
+function event_momenta(event)
+    ptr = _event_pointer(event)
+    momenta = Vector{LorentzVector}(undef, GC.@preserve(event, particles_size_raw(ptr)))
+    GC.@preserve event momenta copy_event_momenta(ptr, Ptr{Float64}(pointer(momenta)))
+    return momenta
+end
+
+"""
+    event_positions(event)
+
+Positions of all vertices of `event`, in vertex order, as a
+`Vector{LorentzVector}` filled by one C++ call. Vertices without a position
+of their own report the position HepMC3 assigns them.
+"""
+function event_positions(event)
+    ptr = _event_pointer(event)
+    positions = Vector{LorentzVector}(undef, GC.@preserve(event, vertices_size_raw(ptr)))
+    GC.@preserve event positions copy_event_positions(ptr, Ptr{Float64}(pointer(positions)))
+    return positions
+end
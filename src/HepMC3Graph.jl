@@ -0,0 +1,358 @@
+# Graph algorithms implemented in the C++ layer (HepMC3WrapGraph.cpp).
+
+export traverse_decay_chain_flat, find_particle_ancestry_flat
+
+"""
+    _flat_traversal(particle_ptr, direction, max_depth; with_particles=false)
+
+Run the native breadth-first walk and copy its flat result arrays into Julia.
+"""
+function _flat_traversal(particle_ptr, direction::Integer, max_depth::Integer; with_particles::Bool=false)
+    traversal = traverse_particles(particle_ptr, Cint(direction), Cint(max_depth))
+    try
+        n = particle_traversal_size(traversal)
+        ids = Vector{Int32}(undef, n)
+        depths = Vector{Int32}(undef, n)
+        parents = Vector{Int32}(undef, n)
+        GC.@preserve ids depths parents copy_particle_traversal(traversal, pointer(ids), pointer(depths), pointer(parents))
+        # C++ reports 0-based parent positions and -1 for the start particle
+        parents .+= 1
+        particles = with_particles ? [particle_traversal_at(traversal, i) for i in 0:(n - 1)] : Ptr{Cvoid}[]
+        return (ids = ids, depths = depths, parents = parents, particles = particles)
+    finally
+        delete_particle_traversal(traversal)
+    end
+end
+
+"""
+    traverse_decay_chain_flat(particle_ptr; max_depth=-1, with_particles=false)
+
+Walk all descendants of a particle in C++ and return them as flat arrays in
+breadth-first order:
+
+- `ids`: HepMC3 particle ids (1-based position in the event, `0` for particles
+  that are not attached to an event), usable with `get_particle_at(event, id)`
+- `depths`: number of decay steps from `particle_ptr` (children have depth 1)
+- `parents`: position in the result through which each particle was reached,
+  or `0` when it is a direct child of `particle_ptr`
+- `particles`: particle pointers, filled only when `with_particles=true`
+
+Every particle and vertex is visited once, so shared vertices and cycles in the
+record are safe. A negative `max_depth` walks the full chain.
+"""
+function traverse_decay_chain_flat(particle_ptr; max_depth::Integer=-1, with_particles::Bool=false)
+    return _flat_traversal(particle_ptr, 1, max_depth; with_particles)
+end
+
+"""
+    find_particle_ancestry_flat(particle_ptr; max_depth=-1, with_particles=false)
+
+Walk all ancestors of a particle in C++. Returns the same flat arrays as
+[`traverse_decay_chain_flat`](@ref), with depth 1 for the direct parents.
+"""
+function find_particle_ancestry_flat(particle_ptr; max_depth::Integer=-1, with_particles::Bool=false)
+    return _flat_traversal(particle_ptr, -1, max_depth; with_particles)
+end
+
+export EventGraphQuery, event_graph_query, is_ancestor, descendants, ancestors, ancestors_matching
+export invalidate!, topological_vertex_order, topological_particle_order, event_topology
+
+"""
+    EventGraphQuery
+
+Reachability index over the particles of one event. The graph index and the
+ancestor/descendant closures are built in C++ on first use and reused by every
+later query, so repeated questions about the same event do not walk the graph
+again. Create one with [`event_graph_query`](@ref).
+"""
+mutable struct EventGraphQuery
+    ptr::Ptr{Cvoid}
+    event::Any
+    buffer::Vector{Int32}
+end
+
+"""
+    event_graph_query(event)
+
+Create an [`EventGraphQuery`](@ref) for an event object or an event pointer
+returned by `read_hepmc_file`. The query keeps the event alive.
+
+Cached data is rebuilt on the next query after any change to the event's
+particles, vertex links or PDG ids made through this package: the
+`GenEvent`, `GenVertex` and `GenParticle` methods that change them
+(`set_pid`, `add_particle_in`, `remove_particle`, `read_data`, ...), the
+builders and readers that refill an event, and `slim_event!`. Changes made
+by other native code need [`invalidate!`](@ref).
+"""
+function event_graph_query(event)
+    query = EventGraphQuery(_create_event_query(event), event, Int32[])
+    finalizer(close, query)
+    return query
+end
+
+# Event handles are shared with the query; GenEvents owned by Julia are kept
+# alive by the query's `event` field
+_create_event_query(event::GenEvent) = GC.@preserve event create_event_query(_event_pointer(event))
+_create_event_query(event_ptr::Ptr{Nothing}) = create_event_query_shared(event_ptr)
+
+function Base.close(query::EventGraphQuery)
+    if query.ptr != C_NULL
+        delete_event_query(query.ptr)
+        query.ptr = C_NULL
+    end
+    return nothing
+end
+
+_particle_id(id::Integer) = Cint(id)
+_particle_id(particle_ptr) = Cint(get_particle_id(particle_ptr))
+
+function _query_pointer(query::EventGraphQuery)
+    query.ptr == C_NULL && error("EventGraphQuery has been closed")
+    return query.ptr
+end
+
+function _collect_query_ids(f, query::EventGraphQuery)
+    # Results never exceed the number of particles in the indexed event
+    n_particles = event_query_particles_size(_query_pointer(query))
+    length(query.buffer) < n_particles && resize!(query.buffer, n_particles)
+    buffer = query.buffer
+    n = GC.@preserve buffer f(pointer(buffer))
+    return buffer[1:n]
+end
+
+"""
+    is_ancestor(query, ancestor, descendant)
+
+Return whether `ancestor` lies upstream of `descendant` in the event graph.
+Particles are given as HepMC3 ids or particle pointers. Answered in constant
+time from the precomputed closure.
+"""
+function is_ancestor(query::EventGraphQuery, ancestor, descendant)
+    return event_query_is_ancestor(_query_pointer(query), _particle_id(ancestor), _particle_id(descendant))
+end
+
+"""
+    descendants(query, particle)
+
+Return the ids of all descendants of `particle`, grouped by production vertex.
+"""
+function descendants(query::EventGraphQuery, particle)
+    ptr = _query_pointer(query)
+    return _collect_query_ids(query) do out
+        event_query_descendants(ptr, _particle_id(particle), out)
+    end
+end
+
+"""
+    ancestors(query, particle)
+
+Return the ids of all ancestors of `particle`, grouped by end vertex.
+"""
+function ancestors(query::EventGraphQuery, particle)
+    ptr = _query_pointer(query)
+    return _collect_query_ids(query) do out
+        event_query_ancestors(ptr, _particle_id(particle), out)
+    end
+end
+
+"""
+    ancestors_matching(query, particle, pdg_ids; abs_pdg=true)
+
+Return the sorted ids of the ancestors of `particle` whose PDG id is in
+`pdg_ids`, compared by absolute value unless `abs_pdg=false`. For example,
+`!isempty(ancestors_matching(query, p, b_hadron_ids))` tells whether a
+final-state particle comes from a b-hadron.
+"""
+function ancestors_matching(query::EventGraphQuery, particle, pdg_ids; abs_pdg::Bool=true)
+    ptr = _query_pointer(query)
+    pdgs = Int32[pdg for pdg in pdg_ids]
+    return _collect_query_ids(query) do out
+        GC.@preserve pdgs event_query_ancestors_matching(ptr, _particle_id(particle), pointer(pdgs),
+                                                         Cint(length(pdgs)), abs_pdg, out)
+    end
+end
+
+"""
+    invalidate!(query)
+
+Drop all cached data of an [`EventGraphQuery`](@ref) so that the next query
+re-indexes the event.
+"""
+function invalidate!(query::EventGraphQuery)
+    event_query_invalidate(_query_pointer(query))
+    return query
+end
+
+"""
+    topological_vertex_order(query)
+
+Return vertex positions (1-based, as used by `get_vertex_at`) ordered so that
+every vertex follows the vertices producing its incoming particles.
+"""
+function topological_vertex_order(query::EventGraphQuery)
+    ptr = _query_pointer(query)
+    order = Vector{Int32}(undef, event_query_vertices_size(ptr))
+    GC.@preserve order event_query_topological_order(ptr, pointer(order))
+    return order
+end
+
+"""
+    topological_particle_order(query)
+
+Return particle ids ordered by production vertex, with particles that have no
+production vertex (the beams) first.
+"""
+function topological_particle_order(query::EventGraphQuery)
+    ptr = _query_pointer(query)
+    order = Vector{Int32}(undef, event_query_particles_size(ptr))
+    GC.@preserve order event_query_particle_order(ptr, pointer(order))
+    return order
+end
+
+const _TOPOLOGY_ROOT = Int32(1)
+const _TOPOLOGY_LEAF = Int32(2)
+const _TOPOLOGY_CYCLIC = Int32(4)
+
+"""
+    event_topology(query)
+
+Return graph-level metadata of the event as a named tuple:
+
+- `vertex_order`: vertex positions in topological order
+- `vertex_depths`: per vertex position, the generation depth from the beams
+  (root vertices have depth 0; a vertex is one level below its deepest parent)
+- `is_root`, `is_leaf`: per vertex position, whether no incoming particle has a
+  production vertex, and whether no outgoing particle has an end vertex
+- `is_cyclic`: per vertex position, whether the vertex lies on a cycle
+- `particle_order`: particle ids ordered by production vertex
+
+The metadata is computed once and cached in the query until the event changes.
+"""
+function event_topology(query::EventGraphQuery)
+    ptr = _query_pointer(query)
+    n_vertices = event_query_vertices_size(ptr)
+    depths = Vector{Int32}(undef, n_vertices)
+    flags = Vector{Int32}(undef, n_vertices)
+    GC.@preserve depths flags event_query_vertex_metadata(ptr, pointer(depths), pointer(flags))
+    return (
+        vertex_order = topological_vertex_order(query),
+        vertex_depths = depths,
+        is_root = (flags .& _TOPOLOGY_ROOT) .!= 0,
+        is_leaf = (flags .& _TOPOLOGY_LEAF) .!= 0,
+        is_cyclic = (flags .& _TOPOLOGY_CYCLIC) .!= 0,
+        particle_order = topological_particle_order(query),
+    )
+end
+
+event_topology(event) = event_topology(event_graph_query(event))
+
+export slim_event!
+
+const _SLIM_KEEP_FINAL_STATE = Cint(1)
+const _SLIM_KEEP_STATUS_RANGE = Cint(2)
+const _SLIM_KEEP_ANCESTORS = Cint(4)
+const _SLIM_KEEP_BEAMS = Cint(8)
+const _SLIM_COLLAPSE_VERTICES = Cint(16)
+
+_slim_keep_mask(::Nothing, n_particles) = UInt8[]
+_slim_keep_mask(mask::AbstractVector{Bool}, n_particles) = UInt8.(mask)
+function _slim_keep_mask(ids, n_particles)
+    mask = zeros(UInt8, n_particles)
+    for id in ids
+        1 <= id <= n_particles || throw(BoundsError(mask, id))
+        mask[id] = 0x01
+    end
+    return mask
+end
+
+"""
+    slim_event!(event; keep=nothing, final_state=false, status_range=nothing,
+                beams=false, ancestors=false, collapse=false)
+
+Remove all particles that are not selected and rebuild the event in a single
+linear pass in C++. This replaces repeated `remove_particle!` calls, each of
+which is linear in the event size.
+
+A particle is kept when any of these selects it:
+
+- `keep`: a `Bool` mask over particle ids, or a collection of particle ids
+- `final_state=true`: status 1
+- `status_range=lo:hi`: status within the range
+- `beams=true`: no production vertex
+
+With `ancestors=true` every ancestor of a kept particle is kept as well. With
+`collapse=true` removed intermediate particles are contracted. This merges the
+vertices they connect, so kept particles remain linked to their nearest kept
+ancestors. Kept particles retain their momenta, attributes and relative order.
+
+Returns a vector mapping each original particle id to its new id (`0` for
+removed particles).
+
+# Examples
+```julia
+# Hard process (status 21-29) plus final state, connected through merged vertices
+slim_event!(event; final_state=true, status_range=21:29, beams=true, collapse=true)
+```
+"""
+function slim_event!(event; keep=nothing, final_state::Bool=false, status_range=nothing,
+                     beams::Bool=false, ancestors::Bool=false, collapse::Bool=false)
+    n_particles = particles_size(event)
+    mask = _slim_keep_mask(keep, n_particles)
+    rules = Cint(0)
+    final_state && (rules |= _SLIM_KEEP_FINAL_STATE)
+    status_range === nothing || (rules |= _SLIM_KEEP_STATUS_RANGE)
+    beams && (rules |= _SLIM_KEEP_BEAMS)
+    ancestors && (rules |= _SLIM_KEEP_ANCESTORS)
+    collapse && (rules |= _SLIM_COLLAPSE_VERTICES)
+    status_min, status_max = status_range === nothing ? (0, -1) : (first(status_range), last(status_range))
+
+    new_ids = Vector{Int32}(undef, n_particles)
+    GC.@preserve event mask new_ids slim_event(_event_pointer(event), pointer(mask), Cint(length(mask)), rules,
+                                               Cint(status_min), Cint(status_max), pointer(new_ids))
+    return new_ids
+end
+
+export event_fingerprint, events_equal
+
+"""
+    event_fingerprint(event; precision=1e-6)
+
+Return a 128-bit hash of the event's graph, PDG ids, particle and vertex
+statuses, and momenta rounded to multiples of `precision` (in the event's
+momentum unit). The hash does not depend on the order in which particles and
+vertices were added, so the same event read back from a file or built in a
+different order has the same fingerprint. Pass `precision=0` to hash only the
+structure. Event number, weights, positions and attributes are ignored.
+
+Momenta that lie close to a rounding boundary can round differently after a
+lossy round trip; use [`events_equal`](@ref) to compare with a tolerance.
+
+# Examples
+```julia
+seen = Set{UInt128}()
+for event in events
+    fingerprint = event_fingerprint(event)
+    fingerprint in seen && continue    # duplicate
+    push!(seen, fingerprint)
+    process(event)
+end
+```
+"""
+function event_fingerprint(event; precision::Real=1e-6)
+    words = zeros(UInt64, 2)
+    GC.@preserve event words event_fingerprint_words(_event_pointer(event), Float64(precision), pointer(words))
+    return UInt128(words[2]) << 64 | UInt128(words[1])
+end
+
+"""
+    events_equal(a, b; tolerance=1e-9)
+
+Compare two events structurally: same graph, PDG ids and statuses (checked
+through their structural fingerprints), and particle momenta that agree
+component-wise within `tolerance`, relative to the larger magnitude (absolute
+for components below 1). Particles are matched by their position in the graph,
+not by their ids, so insertion order does not matter.
+"""
+function events_equal(a, b; tolerance::Real=1e-9)
+    return GC.@preserve a b events_structurally_equal(_event_pointer(a), _event_pointer(b), Float64(tolerance))
+end
@@ -0,0 +1,505 @@
+# Writers implemented in the C++ layer (HepMC3WrapIO.cpp).
+
+export AsyncWriter, async_writer, ParallelWriter, parallel_writer
+export write_event, writer_stats
+
+"""
+    AsyncWriter
+
+HepMC3 ASCII writer that formats and writes events on a dedicated C++ thread.
+Create one with [`async_writer`](@ref), queue events with
+[`write_event`](@ref), and finish with `flush` or `close`.
+"""
+mutable struct AsyncWriter
+    ptr::Ptr{Cvoid}
+    filename::String
+end
+
+"""
+    ParallelWriter
+
+HepMC3 ASCII writer that formats events on a pool of C++ threads and writes
+them in submission order. The output is byte-identical to `WriterAscii`.
+Create one with [`parallel_writer`](@ref); it supports the same
+[`write_event`](@ref), `flush` and `close` calls as [`AsyncWriter`](@ref).
+"""
+mutable struct ParallelWriter
+    ptr::Ptr{Cvoid}
+    filename::String
+end
+
+const _BackgroundWriter = Union{AsyncWriter, ParallelWriter}
+
+# C++ entry points of each writer type
+_writer_write(::AsyncWriter, ptr, event) = async_writer_write_event(ptr, event)
+_writer_write_shared(::AsyncWriter, ptr, event) = async_writer_write_event_shared(ptr, event)
+_writer_flush(::AsyncWriter, ptr) = async_writer_flush(ptr)
+_writer_close(::AsyncWriter, ptr) = async_writer_close(ptr)
+_writer_failed(::AsyncWriter, ptr) = async_writer_failed(ptr)
+_writer_error(::AsyncWriter, ptr) = _cstring_to_string(async_writer_error(ptr))
+_writer_counts(::AsyncWriter, ptr, out) = async_writer_counts(ptr, out)
+_writer_delete(::AsyncWriter, ptr) = delete_async_writer(ptr)
+
+_writer_write(::ParallelWriter, ptr, event) = parallel_writer_write_event(ptr, event)
+_writer_write_shared(::ParallelWriter, ptr, event) = parallel_writer_write_event_shared(ptr, event)
+_writer_flush(::ParallelWriter, ptr) = parallel_writer_flush(ptr)
+_writer_close(::ParallelWriter, ptr) = parallel_writer_close(ptr)
+_writer_failed(::ParallelWriter, ptr) = parallel_writer_failed(ptr)
+_writer_error(::ParallelWriter, ptr) = _cstring_to_string(parallel_writer_error(ptr))
+_writer_counts(::ParallelWriter, ptr, out) = parallel_writer_counts(ptr, out)
+_writer_delete(::ParallelWriter, ptr) = delete_parallel_writer(ptr)
+
+"""
+    async_writer(filename; capacity=64)
+
+Open `filename` for writing and start a background thread that owns the
+underlying `WriterAscii`. At most `capacity` events wait in the queue;
+`write_event` blocks while the queue is full. Throws if the file cannot be
+opened.
+
+# Examples
+```julia
+writer = async_writer("output.hepmc3")
+for event in events
+    write_event(writer, event)
+end
+close(writer)    # waits for all queued events and reports write errors
+```
+"""
+function async_writer(filename::AbstractString; capacity::Integer=64)
+    writer = AsyncWriter(create_async_writer(String(filename), Cint(capacity)), String(filename))
+    return _open_background_writer(writer)
+end
+
+"""
+    parallel_writer(filename; threads=0, capacity=256)
+
+Open `filename` for writing with `threads` formatting threads (all cores when
+`threads=0`). At most `capacity` events are queued or being formatted;
+`write_event` blocks beyond that. Events are written in the order they were
+submitted, and the file is byte-identical to what `create_writer_ascii` and
+`writer_write_event` would produce. Throws if the file cannot be opened.
+"""
+function parallel_writer(filename::AbstractString; threads::Integer=0, capacity::Integer=256)
+    writer = ParallelWriter(create_parallel_writer(String(filename), Cint(threads), Cint(capacity)), String(filename))
+    return _open_background_writer(writer)
+end
+
+function _open_background_writer(writer::_BackgroundWriter)
+    finalizer(_delete_background_writer, writer)
+    if _writer_failed(writer, writer.ptr)
+        message = _writer_error(writer, writer.ptr)
+        _delete_background_writer(writer)
+        error("Cannot create $(nameof(typeof(writer))): $message")
+    end
+    return writer
+end
+
+function _delete_background_writer(writer::_BackgroundWriter)
+    if writer.ptr != C_NULL
+        _writer_delete(writer, writer.ptr)
+        writer.ptr = C_NULL
+    end
+    return nothing
+end
+
+function _background_writer_pointer(writer::_BackgroundWriter)
+    writer.ptr == C_NULL && error("$(nameof(typeof(writer))) for $(writer.filename) has been closed")
+    return writer.ptr
+end
+
+function _check_background_writer(writer::_BackgroundWriter, ok::Bool)
+    ok && return nothing
+    message = _writer_error(writer, writer.ptr)
+    error(isempty(message) ? "$(nameof(typeof(writer))) for $(writer.filename) has been closed" :
+          "Writing $(writer.filename) failed: $message")
+end
+
+"""
+    write_event(writer, event; copy=true)
+
+Queue an event on an [`AsyncWriter`](@ref) or [`ParallelWriter`](@ref). By
+default a `GenEventData` snapshot is taken before returning, so the caller may
+modify or reuse the event right away.
+
+For events returned by `read_hepmc_file`, `copy=false` queues the event itself
+without a snapshot; it must then not be modified until it has been written
+(after the next `flush`). Throws if an earlier write failed.
+"""
+function write_event(writer::_BackgroundWriter, event; copy::Bool=true)
+    ptr = _background_writer_pointer(writer)
+    if copy
+        ok = GC.@preserve event _writer_write(writer, ptr, _event_pointer(event))
+    else
+        event isa Ptr{Nothing} || throw(ArgumentError("copy=false requires an event pointer from read_hepmc_file"))
+        ok = _writer_write_shared(writer, ptr, event)
+    end
+    _check_background_writer(writer, ok)
+    return writer
+end
+
+"""
+    flush(writer::Union{AsyncWriter,ParallelWriter})
+
+Block until every queued event has been written and flushed to the file.
+Throws if a write failed.
+"""
+function Base.flush(writer::_BackgroundWriter)
+    _check_background_writer(writer, _writer_flush(writer, _background_writer_pointer(writer)))
+    return writer
+end
+
+"""
+    close(writer::Union{AsyncWriter,ParallelWriter})
+
+Write all queued events, stop the writer threads and close the file. Throws
+if a write failed. Closing twice is a no-op.
+"""
+function Base.close(writer::_BackgroundWriter)
+    writer.ptr == C_NULL && return nothing
+    ok = _writer_close(writer, writer.ptr)
+    message = ok ? "" : _writer_error(writer, writer.ptr)
+    _delete_background_writer(writer)
+    ok || error("Writing $(writer.filename) failed: $message")
+    return nothing
+end
+
+"""
+    writer_stats(writer)
+
+Return `(written, queued)` for an [`AsyncWriter`](@ref): events written so far
+and events waiting. For a [`ParallelWriter`](@ref) the tuple also contains
+`bytes`, the number of bytes committed to the file.
+"""
+function writer_stats(writer::AsyncWriter)
+    counts = zeros(Int64, 2)
+    GC.@preserve counts _writer_counts(writer, _background_writer_pointer(writer), pointer(counts))
+    return (written = counts[1], queued = counts[2])
+end
+
+function writer_stats(writer::ParallelWriter)
+    counts = zeros(Int64, 3)
+    GC.@preserve counts _writer_counts(writer, _background_writer_pointer(writer), pointer(counts))
+    return (written = counts[1], queued = counts[2], bytes = counts[3])
+end
+
+
+export create_writer_gzip, create_writer_zstd, create_writer_compressed, zstd_compression_available
+
+const _CODEC_GZIP = Cint(1)
+const _CODEC_ZSTD = Cint(2)
+
+function _open_compressed_writer(filename::AbstractString, codec::Cint, level::Integer, threads::Integer)
+    writer = create_writer_ascii_compressed(String(filename), codec, Cint(level), Cint(threads))
+    if writer_failed(writer)
+        message = _cstring_to_string(compressed_writer_error(writer))
+        delete_writer_ascii(writer)
+        error("Cannot create compressed writer for $filename: $message")
+    end
+    return writer
+end
+
+"""
+    create_writer_gzip(filename; level=6)
+
+Open a HepMC3 ASCII writer whose output is gzip-compressed while it is written.
+`level` ranges from 0 (store) to 9 (smallest). The handle works with the
+same calls as `create_writer_ascii`: `writer_write_event`, `writer_failed`,
+`writer_close` and `delete_writer_ascii`. Throws if the file cannot be opened.
+
+# Examples
+```julia
+writer = create_writer_gzip("events.hepmc3.gz"; level=6)
+for event in events
+    writer_write_event(writer, event.cpp_object)
+end
+writer_close(writer)        # writes the gzip trailer
+delete_writer_ascii(writer)
+```
+"""
+function create_writer_gzip(filename::AbstractString; level::Integer=6)
+    return _open_compressed_writer(filename, _CODEC_GZIP, level, 1)
+end
+
+"""
+    create_writer_zstd(filename; level=3, threads=1)
+
+Open a HepMC3 ASCII writer whose output is zstd-compressed while it is written.
+`level` ranges from 1 to 22; `threads > 1` compresses on that many zstd worker
+threads. Used like [`create_writer_gzip`](@ref). Throws if the file cannot be
+opened or the library was built without zstd (see `zstd_compression_available`).
+"""
+function create_writer_zstd(filename::AbstractString; level::Integer=3, threads::Integer=1)
+    return _open_compressed_writer(filename, _CODEC_ZSTD, level, threads)
+end
+
+"""
+    create_writer_compressed(filename; level=nothing, threads=1)
+
+Open a writer chosen by file extension: zstd for `.zst`, gzip for `.gz`, and a
+plain `create_writer_ascii` otherwise. `level=nothing` uses the codec default.
+"""
+function create_writer_compressed(filename::AbstractString; level=nothing, threads::Integer=1)
+    if endswith(filename, ".zst")
+        return create_writer_zstd(filename; level=something(level, 3), threads)
+    elseif endswith(filename, ".gz")
+        return create_writer_gzip(filename; level=something(level, 6))
+    else
+        return create_writer_ascii(String(filename))
+    end
+end
+
+export ShardedWriter, sharded_writer, read_shard_manifest
+
+const _SHARD_MODES = Dict(:count => Cint(1), :bytes => Cint(2), :key => Cint(3))
+
+"""
+    ShardedWriter
+
+Writer that distributes events over several HepMC3 ASCII files, each written
+by its own background thread. Create one with [`sharded_writer`](@ref).
+"""
+mutable struct ShardedWriter
+    ptr::Ptr{Cvoid}
+    pattern::String
+    manifest::String
+end
+
+"""
+    sharded_writer(pattern; events_per_shard=nothing, bytes_per_shard=nothing,
+                   by_key=false, key_attribute="", manifest=<default>, capacity=64)
+
+Open a writer that splits its output into shard files named by `pattern`,
+which must contain `{}`. Exactly one splitting rule applies:
+
+- `events_per_shard=n`: a new shard every `n` events
+- `bytes_per_shard=n`: a new shard once the current one has written `n`
+  bytes; events already queued still go to the old shard, so shards can be
+  slightly larger
+- `by_key=true`: one shard per key, given to [`write_event`](@ref) as
+  `key=...` or read from the event attribute `key_attribute`
+
+With rotation, `{}` becomes a four-digit shard index (`0000`, `0001`, ...);
+with keys, it becomes the key with characters other than letters, digits,
+`-`, `_` and `.` replaced by `_` (`none` for an empty key), and `-2`, `-3`,
+... appended when another key already took that name. On `close`, a tab-separated manifest listing
+every shard's file, key, first event index, event count, first and last event
+number and size in bytes is written to `manifest` (by default `pattern` with
+`{}` replaced by `manifest` and the extension `.tsv`; pass `""` to skip it).
+`close` returns the manifest entries.
+
+# Examples
+```julia
+writer = sharded_writer("run42_{}.hepmc3"; events_per_shard=10_000)
+foreach(event -> write_event(writer, event), events)
+shards = close(writer)     # shards[1].file == "run42_0000.hepmc3"
+
+writer = sharded_writer("process_{}.hepmc3"; by_key=true, key_attribute="signal_process_id")
+```
+"""
+function sharded_writer(pattern::AbstractString; events_per_shard=nothing, bytes_per_shard=nothing,
+                        by_key::Bool=false, key_attribute::AbstractString="",
+                        manifest::AbstractString=splitext(replace(pattern, "{}" => "manifest"))[1] * ".tsv",
+                        capacity::Integer=64)
+    rules = count(!isnothing, (events_per_shard, bytes_per_shard)) + by_key
+    rules == 1 || throw(ArgumentError("give exactly one of events_per_shard, bytes_per_shard or by_key=true"))
+    occursin("{}", pattern) || throw(ArgumentError("pattern must contain {}"))
+    mode, limit = events_per_shard !== nothing ? (:count, events_per_shard) :
+                  bytes_per_shard !== nothing ? (:bytes, bytes_per_shard) : (:key, 0)
+    ptr = create_sharded_writer(String(pattern), _SHARD_MODES[mode], Int64(limit), String(key_attribute),
+                                String(manifest), Cint(capacity))
+    writer = ShardedWriter(ptr, String(pattern), String(manifest))
+    finalizer(_delete_sharded_writer, writer)
+    if sharded_writer_failed(ptr)
+        message = _cstring_to_string(sharded_writer_error(ptr))
+        _delete_sharded_writer(writer)
+        throw(ArgumentError("Cannot create sharded writer: $message"))
+    end
+    return writer
+end
+
+function _delete_sharded_writer(writer::ShardedWriter)
+    if writer.ptr != C_NULL
+        delete_sharded_writer(writer.ptr)
+        writer.ptr = C_NULL
+    end
+    return nothing
+end
+
+function _sharded_writer_pointer(writer::ShardedWriter)
+    writer.ptr == C_NULL && error("ShardedWriter for $(writer.pattern) has been closed")
+    return writer.ptr
+end
+
+function _check_sharded_writer(writer::ShardedWriter, ok::Bool)
+    ok || error("Writing $(writer.pattern) failed: $(_cstring_to_string(sharded_writer_error(writer.ptr)))")
+    return nothing
+end
+
+"""
+    write_event(writer::ShardedWriter, event; key="", copy=true)
+
+Queue an event on the shard it belongs to. `key` selects the shard of a
+`by_key` writer; when it is empty the writer's `key_attribute` is used.
+`copy` behaves as for [`AsyncWriter`](@ref).
+"""
+function write_event(writer::ShardedWriter, event; key="", copy::Bool=true)
+    ptr = _sharded_writer_pointer(writer)
+    if copy
+        ok = GC.@preserve event sharded_writer_write_event(ptr, _event_pointer(event), string(key))
+    else
+        event isa Ptr{Nothing} || throw(ArgumentError("copy=false requires an event pointer from read_hepmc_file"))
+        ok = sharded_writer_write_event_shared(ptr, event, string(key))
+    end
+    _check_sharded_writer(writer, ok)
+    return writer
+end
+
+function Base.flush(writer::ShardedWriter)
+    _check_sharded_writer(writer, sharded_writer_flush(_sharded_writer_pointer(writer)))
+    return writer
+end
+
+"""
+    close(writer::ShardedWriter)
+
+Finish all shards and write the manifest. Returns the manifest entries (see
+[`read_shard_manifest`](@ref)), or an empty vector if no manifest was
+requested. Throws if a shard failed.
+"""
+function Base.close(writer::ShardedWriter)
+    writer.ptr == C_NULL && return NamedTuple[]
+    ok = sharded_writer_close(writer.ptr)
+    message = ok ? "" : _cstring_to_string(sharded_writer_error(writer.ptr))
+    _delete_sharded_writer(writer)
+    ok || error("Writing $(writer.pattern) failed: $message")
+    return isempty(writer.manifest) ? NamedTuple[] : read_shard_manifest(writer.manifest)
+end
+
+"""
+    read_shard_manifest(filename)
+
+Read a manifest written by a [`ShardedWriter`](@ref). Returns one named tuple
+per shard with fields `file`, `key`, `first` (0-based index of the shard's
+first event in submission order), `events`, `first_event_number`,
+`last_event_number` and `bytes`.
+"""
+function read_shard_manifest(filename::AbstractString)
+    lines = readlines(filename)
+    return [begin
+                fields = split(line, '\t')
+                (file = String(fields[1]), key = String(fields[2]), first = parse(Int, fields[3]),
+                 events = parse(Int, fields[4]), first_event_number = parse(Int, fields[5]),
+                 last_event_number = parse(Int, fields[6]), bytes = parse(Int, fields[7]))
+            end for line in lines[2:end] if !isempty(line)]
+end
+
+# Raw pass-through
+
+export RawEvent, filter_events_raw, raw_text, parse_event!
+
+"""
+    RawEvent
+
+Light view of one event in an ASCII file, as seen by the predicate of
+[`filter_events_raw`](@ref). Parsed from the event's `E` and `P` lines only:
+
+- `event_number`, `n_vertices`
+- per particle: `pdg`, `status`, `px`, `py`, `pz`, `e`, `mass` and `parent`,
+  the raw parent field of the `P` line (negative: production vertex id,
+  positive: id of the particle whose end vertex produced it, `0`: none)
+
+Use [`raw_text`](@ref) for the event's text and [`parse_event!`](@ref) for a
+full `GenEvent`. Both are only valid while the predicate runs.
+"""
+struct RawEvent
+    reader::Ptr{Cvoid}
+    event_number::Int
+    n_vertices::Int
+    pdg::Vector{Int32}
+    status::Vector{Int32}
+    parent::Vector{Int32}
+    px::Vector{Float64}
+    py::Vector{Float64}
+    pz::Vector{Float64}
+    e::Vector{Float64}
+    mass::Vector{Float64}
+end
+
+function _raw_event(reader::Ptr{Cvoid})
+    info = Vector{Cint}(undef, 3)
+    GC.@preserve info raw_reader_event_info(reader, pointer(info))
+    n = Int(info[3])
+    pdg, status, parent = Vector{Int32}(undef, n), Vector{Int32}(undef, n), Vector{Int32}(undef, n)
+    momenta, mass = Matrix{Float64}(undef, 4, n), Vector{Float64}(undef, n)
+    if n > 0
+        GC.@preserve pdg status parent momenta mass begin
+            copy_raw_reader_particles(reader, pointer(pdg), pointer(status), pointer(parent),
+                                      pointer(momenta), pointer(mass))
+        end
+    end
+    return RawEvent(reader, info[1], info[2], pdg, status, parent,
+                    momenta[1, :], momenta[2, :], momenta[3, :], momenta[4, :], mass)
+end
+
+"""
+    raw_text(raw::RawEvent)
+
+The event's text exactly as it appears in the input file. A run info block
+written between two events belongs to neither, so it is not included.
+"""
+raw_text(raw::RawEvent) = _cstring_to_string(raw_reader_text(raw.reader))
+
+"""
+    parse_event!(event, raw::RawEvent)
+
+Fully parse `raw` into `event` (a `GenEvent`), for decisions that need more
+than the light view. Returns `true` on success.
+"""
+function parse_event!(event, raw::RawEvent)
+    ok = GC.@preserve event raw_reader_parse_event(raw.reader, _event_pointer(event))
+    _collect_native_garbage()
+    return ok
+end
+
+"""
+    filter_events_raw(predicate, input, output; max_events=-1)
+
+Copy the events of the ASCII file `input` for which `predicate(raw::RawEvent)`
+returns `true` into `output`. Accepted events are copied as raw bytes rather
+than parsed and written again, so the output is bit-exact: header, event
+text and footer are identical to the input, and accepting every event
+reproduces the input file. Run info blocks found between events are always
+copied in place, even when the events around them are rejected, so later
+events keep the weight names and tools they refer to. Returns
+`(read = n, written = m)`.
+
+# Examples
+```julia
+filter_events_raw("all.hepmc3", "muons.hepmc3") do raw
+    any(i -> abs(raw.pdg[i]) == 13 && raw.status[i] == 1 && hypot(raw.px[i], raw.py[i]) > 20,
+        eachindex(raw.pdg))
+end
+```
+"""
+function filter_events_raw(predicate, input::AbstractString, output::AbstractString; max_events::Integer=-1)
+    reader = create_raw_event_reader(String(input))
+    reader == C_NULL && throw(ArgumentError("Cannot open $input"))
+    writer = C_NULL
+    n_read = n_written = 0
+    try
+        writer = create_raw_event_writer(String(output), reader)
+        while (max_events < 0 || n_read < max_events) && raw_reader_next(reader)
+            n_read += 1
+            if predicate(_raw_event(reader))
+                raw_writer_write_current(writer) || error("Writing $output failed")
+                n_written += 1
+            end
+        end
+        raw_writer_close(writer) || error("Writing $output failed")
+    finally
+        writer != C_NULL && delete_raw_event_writer(writer)
+        delete_raw_event_reader(reader)
+    end
+    return (read = n_read, written = n_written)
+end
@@ -719,6 +719,15 @@ function event_number(event_ptr::Ptr{Nothing})
     return get_event_number_shared(event_ptr)
 end
 
+"""
+    _event_pointer(event)
+
+Return the raw `GenEvent*` for an event object or for an event pointer returned
+by `read_hepmc_file`, as expected by the native functions that take events.
+"""
+_event_pointer(event::GenEvent) = event.cpp_object
+_event_pointer(event_ptr::Ptr{Nothing}) = get_event_pointer_shared(event_ptr)
+
 
 # Override Base.in for particle pointer arrays
 function Base.in(particle::Ptr{Nothing}, particles::Vector)
@@ -785,14 +794,36 @@ function _cstring_to_string(value)
     return unsafe_string(Ptr{UInt8}(value.cpp_object))
 end
 
+"""
+    _decode_string_table(table, n_strings)
+
+Split a packed run info table into `n_strings` Julia strings. The table holds
+`n_strings + 1` `Int32` offsets followed by the string bytes and is owned by
+the per-`GenRunInfo` cache on the C++ side.
+"""
+function _decode_string_table(table::Ptr{Cvoid}, n_strings::Integer)
+    n_strings == 0 && return String[]
+    offsets = Ptr{Int32}(table)
+    bytes = Ptr{UInt8}(table) + sizeof(Int32) * (n_strings + 1)
+    return [
+        unsafe_string(bytes + unsafe_load(offsets, i), unsafe_load(offsets, i + 1) - unsafe_load(offsets, i))
+        for i in 1:n_strings
+    ]
+end
+
 """
     get_weight_names(run_info_or_event)
 
 Return the weight names attached to a `GenRunInfo` object or event.
+
+The names are packed once per `GenRunInfo` and cached on the C++ side, so
+events sharing a run info reuse the packed table and each lookup is one call
+into C++ plus the string decoding. The cache is refreshed when the names change.
 """
 function get_weight_names(run_info)
-    n_names = get_run_info_weight_names_size(run_info)
-    return [_cstring_to_string(get_run_info_weight_name(run_info, i)) for i in 0:(n_names - 1)]
+    count = zeros(Int64, 1)
+    table = GC.@preserve count run_info_weight_names_table(run_info, pointer(count))
+    return _decode_string_table(table, count[1])
 end
 
 function get_weight_names(event::GenEvent)
@@ -878,14 +909,13 @@ end
 Return tool metadata as named tuples with `name`, `version`, and `description`.
 """
 function get_tool_infos(run_info)
-    n_tools = get_run_info_tools_size(run_info)
+    count = zeros(Int64, 1)
+    table = GC.@preserve count run_info_tools_table(run_info, pointer(count))
+    n_tools = count[1]
+    fields = _decode_string_table(table, 3 * n_tools)
     return [
-        (
-            name = _cstring_to_string(get_run_info_tool_name(run_info, i)),
-            version = _cstring_to_string(get_run_info_tool_version(run_info, i)),
-            description = _cstring_to_string(get_run_info_tool_description(run_info, i)),
-        )
-        for i in 0:(n_tools - 1)
+        (name = fields[3i - 2], version = fields[3i - 1], description = fields[3i])
+        for i in 1:n_tools
     ]
 end
 
@@ -937,10 +967,13 @@ export read_all_events_from_file, get_events_vector_size, get_event_from_vector,
 
 
 """
-    read_hepmc_file(filename; max_events=-1)
+    read_hepmc_file(filename; max_events=-1, pool=nothing, attributes=nothing)
 Read an uncompressed HepMC3 ASCII file using native HepMC3 reader.
+With an `EventPool`, events are recycled from the pool; hand them back with
+`release_events!` when done. An `AttributePolicy` passed as `attributes`
+drops or parses attributes of each event as it is read.
 """
-function read_hepmc_file(filename::String; max_events::Int=-1)
+function read_hepmc_file(filename::String; max_events::Int=-1, pool=nothing, attributes=nothing)
     if !isfile(filename)
         error("File not found: $filename")
     end
@@ -948,7 +981,10 @@ function read_hepmc_file(filename::String; max_events::Int=-1)
     # println("Reading HepMC3 file: $filename")
     
     # Use your existing C++ function
-    events_vector = read_all_events_from_file(filename, max_events)
+    events_vector = pool === nothing && attributes === nothing ? read_all_events_from_file(filename, max_events) :
+                    read_all_events_from_file_pooled(filename, max_events,
+                                                     pool === nothing ? C_NULL : _event_pool_pointer(pool),
+                                                     _attribute_policy_pointer(attributes))
     
     if events_vector == C_NULL
         error("HepMC3 reader failed to read file: $filename")
@@ -968,6 +1004,7 @@ function read_hepmc_file(filename::String; max_events::Int=-1)
     
     # Clean up C++ vector
     delete_events_vector(events_vector)
+    _collect_native_garbage()
     
     return events
 end
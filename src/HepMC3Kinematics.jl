@@ -0,0 +1,261 @@
+# Batched kinematic transforms implemented in the C++ layer (HepMC3WrapKinematics.cpp).
+
+export boost_columns!, boost_events!, beam_boosts, boost_to_beam_frame!
+export select_momenta, pair_matrix, pair_index, find_pairs
+
+const _PAIR_QUANTITIES = (delta_r = 0, delta_r_rap = 1, mass = 2)
+
+# Boost vectors as a 3×n matrix of velocities, one column per event
+function _boost_matrix(beta::AbstractMatrix{<:Real}, n)
+    size(beta) == (3, n) || throw(DimensionMismatch("boost matrix has size $(size(beta)), expected (3, $n)"))
+    return Matrix{Float64}(beta)
+end
+
+function _boost_matrix(beta::AbstractVector, n)
+    if eltype(beta) <: Real
+        length(beta) == 3 || throw(DimensionMismatch("a single boost vector needs 3 components"))
+        return repeat(Vector{Float64}(beta), 1, n)
+    end
+    length(beta) == n || throw(DimensionMismatch("$(length(beta)) boost vectors for $n events"))
+    matrix = Matrix{Float64}(undef, 3, n)
+    for (k, b) in enumerate(beta)
+        length(b) == 3 || throw(DimensionMismatch("boost vector $k needs 3 components"))
+        matrix[:, k] .= b
+    end
+    return matrix
+end
+
+_boost_matrix(beta::Tuple{Real,Real,Real}, n) = _boost_matrix(collect(Float64, beta), n)
+
+function _event_pointers(events)
+    return Ptr{Cvoid}[_event_pointer(event) for event in events]
+end
+
+"""
+    boost_columns!(px, py, pz, e, event, beta; threads=0)
+    boost_columns!(columns, beta; threads=0)
+
+Boost momentum columns in place, event by event. `event` gives for each row
+the 1-based event it belongs to, with the rows of one event next to each
+other (as in the `event` column of [`run_engine`](@ref)); row `i` is boosted
+by the velocity `beta[:, event[i]]`. `beta` is a 3×n matrix, a vector of
+n three-component vectors or tuples, or one velocity for every event, as
+for `GenEvent`'s `boost`. The second form takes a named tuple with columns
+`px`, `py`, `pz`, `e` and `event`.
+
+The momentum columns must be `Vector{Float64}`. The transform runs in C++
+with SIMD loops over each event's rows, with events shared out over
+`threads` threads (all cores when 0). Returns `(px, py, pz, e)`.
+
+# Examples
+```julia
+columns = (px = px, py = py, pz = pz, e = e, event = event)
+boost_columns!(columns, beam_boosts(events))
+```
+"""
+function boost_columns!(px::Vector{Float64}, py::Vector{Float64}, pz::Vector{Float64}, e::Vector{Float64},
+                        event::AbstractVector{<:Integer}, beta; threads::Integer=0)
+    n = length(px)
+    for (name, column) in ((:py, py), (:pz, pz), (:e, e), (:event, event))
+        _check_column_length(name, column, n)
+    end
+    single = beta isa Tuple || (beta isa AbstractVector && eltype(beta) <: Real)
+    n_events = beta isa AbstractMatrix ? size(beta, 2) : single ? (isempty(event) ? 0 : Int(maximum(event))) : length(beta)
+    betas = _boost_matrix(beta, n_events)
+
+    # Row ranges per event; offsets[k + 1] is one past the last row of event k
+    offsets = zeros(Int64, n_events + 1)
+    previous = 1
+    for i in 1:n
+        k = event[i]
+        1 <= k <= n_events || throw(ArgumentError("row $i belongs to event $k, which has no boost vector"))
+        k >= previous || throw(ArgumentError("rows must be grouped by event in increasing order"))
+        offsets[k+1] = i
+        previous = k
+    end
+    for k in 2:n_events+1
+        offsets[k] = max(offsets[k], offsets[k-1])
+    end
+
+    GC.@preserve px py pz e offsets betas begin
+        boost_momentum_columns(pointer(px), pointer(py), pointer(pz), pointer(e), pointer(offsets),
+                               Int64(n_events), pointer(betas), Cint(threads))
+    end
+    return (px, py, pz, e)
+end
+
+function boost_columns!(columns::NamedTuple, beta; threads::Integer=0)
+    return boost_columns!(columns.px, columns.py, columns.pz, columns.e, columns.event, beta; threads)
+end
+
+"""
+    boost_events!(events, beta; threads=0)
+
+Boost the particle momenta of every event in `events` (`GenEvent`s or event
+pointers) in one C++ call, each by its own velocity: `beta` is a 3×n matrix,
+a vector of three-component vectors or tuples, or one velocity for all
+events. Equivalent to calling `boost` on each event with
+`FourVector(beta..., 0)`, but the momenta of each event are transformed with
+SIMD loops and events are shared out over `threads` threads (all cores when
+0). Every velocity must be below 1. Returns `events`.
+"""
+function boost_events!(events::AbstractVector, beta; threads::Integer=0)
+    n = length(events)
+    betas = _boost_matrix(beta, n)
+    pointers = _event_pointers(events)
+    GC.@preserve events pointers betas boost_events(pointer(pointers), Int64(n), pointer(betas), Cint(threads))
+    return events
+end
+
+"""
+    beam_boosts(events; partonic=false)
+
+3×n matrix whose column `k` is the velocity that boosts event `k` to the
+rest frame of its beam particles (status 4). With `partonic=true`, the two
+beams are scaled by the momentum fractions `x` of the event's `GenPdfInfo`,
+giving the rest frame of the incoming partons. Throws for events without
+beams, or without `GenPdfInfo` and two beams when `partonic` is set.
+
+# Examples
+```julia
+events = read_hepmc_file("events.hepmc3")
+boost_events!(events, beam_boosts(events; partonic=true))
+```
+"""
+function beam_boosts(events::AbstractVector; partonic::Bool=false)
+    n = length(events)
+    betas = Matrix{Float64}(undef, 3, n)
+    pointers = _event_pointers(events)
+    GC.@preserve events pointers betas beam_boost_vectors(pointer(pointers), Int64(n), partonic, pointer(betas))
+    return betas
+end
+
+"""
+    boost_to_beam_frame!(events; partonic=false, threads=0)
+
+Boost every event to the rest frame of its beams, or of its incoming
+partons with `partonic=true`; see [`beam_boosts`](@ref) and
+[`boost_events!`](@ref).
+"""
+function boost_to_beam_frame!(events::AbstractVector; partonic::Bool=false, threads::Integer=0)
+    return boost_events!(events, beam_boosts(events; partonic); threads)
+end
+
+"""
+    select_momenta(event; status=0, pdg=Int[], pt_min=0.0, abs_eta_max=Inf)
+
+Ids and momenta (a `Vector{LorentzVector}`) of the particles of `event`
+passing a selection, as for [`run_engine`](@ref): `status` 0 and an empty
+`pdg` accept every particle. One C++ call.
+"""
+function select_momenta(event; status::Integer=0, pdg=Int[], pt_min::Real=0.0, abs_eta_max::Real=Inf)
+    ptr = _event_pointer(event)
+    n = GC.@preserve event particles_size_raw(ptr)
+    abs_pdg = Cint[abs(p) for p in pdg]
+    ids = Vector{Cint}(undef, n)
+    momenta = Vector{LorentzVector}(undef, n)
+    selected = GC.@preserve event abs_pdg ids momenta begin
+        select_particle_momenta(ptr, Cint(status), isempty(abs_pdg) ? Ptr{Cint}(C_NULL) : pointer(abs_pdg),
+                                Cint(length(abs_pdg)), Float64(pt_min), Float64(abs_eta_max), pointer(ids),
+                                Ptr{Float64}(pointer(momenta)))
+    end
+    return (ids = Vector{Int}(resize!(ids, selected)), momenta = resize!(momenta, selected))
+end
+
+function _pair_quantity(quantity::Symbol)
+    haskey(_PAIR_QUANTITIES, quantity) ||
+        throw(ArgumentError("unknown pair quantity $(repr(quantity)); use :delta_r, :delta_r_rap or :mass"))
+    return Cint(_PAIR_QUANTITIES[quantity])
+end
+
+# Call f(n, px, py, pz, e, stride) with pointers to the momentum components;
+# a Vector{LorentzVector} is read in place with a stride of 4
+function _with_momentum_pointers(f, momenta::Vector{LorentzVector})
+    base = Ptr{Float64}(pointer(momenta))
+    return GC.@preserve momenta f(Int64(length(momenta)), base, base + 8, base + 16, base + 24, Int64(4))
+end
+
+function _with_momentum_pointers(f, columns::NamedTuple)
+    n = length(columns.px)
+    px = _check_column_length(:px, _float_column(columns.px), n)
+    py = _check_column_length(:py, _float_column(columns.py), n)
+    pz = _check_column_length(:pz, _float_column(columns.pz), n)
+    e = _check_column_length(:e, _float_column(columns.e), n)
+    return GC.@preserve px py pz e f(Int64(n), pointer(px), pointer(py), pointer(pz), pointer(e), Int64(1))
+end
+
+"""
+    pair_matrix(momenta; quantity=:delta_r, threads=0)
+
+A pair quantity for all pairs of `momenta`, a `Vector{LorentzVector}` (e.g.
+from [`select_momenta`](@ref)) or a named tuple of columns `px`, `py`, `pz`
+and `e`, as the packed upper triangle of the symmetric matrix: a vector of
+`n (n - 1) / 2` values with pair `(i, j)` at [`pair_index`](@ref)`(n, i, j)`.
+
+`quantity` is `:delta_r` (ΔR in pseudorapidity and φ), `:delta_r_rap` (ΔR in
+rapidity and φ) or `:mass` (invariant mass of the pair, negative when
+space-like), with the conventions of `FourVector`. Computed in C++ with SIMD
+loops, split over `threads` threads (all cores when 0) for large `n`.
+
+# Examples
+```julia
+jets = select_momenta(event; status=1, pt_min=20.0).momenta
+dr = pair_matrix(jets)
+dr[pair_index(length(jets), 1, 2)] ≈ delta_r_eta(jets[1], jets[2])
+```
+"""
+function pair_matrix(momenta; quantity::Symbol=:delta_r, threads::Integer=0)
+    q = _pair_quantity(quantity)
+    return _with_momentum_pointers(momenta) do n, px, py, pz, e, stride
+        values = Vector{Float64}(undef, n * (n - 1) ÷ 2)
+        GC.@preserve values fill_pair_matrix(q, n, px, py, pz, e, stride, pointer(values), Cint(threads))
+        values
+    end
+end
+
+"""
+    pair_index(n, i, j)
+
+Position of pair `(i, j)`, `i != j`, in the packed output of
+[`pair_matrix`](@ref) for `n` momenta. Pairs are ordered `(1, 2), (1, 3), …,
+(1, n), (2, 3), …`.
+"""
+function pair_index(n::Integer, i::Integer, j::Integer)
+    i, j = minmax(i, j)
+    1 <= i < j <= n || throw(ArgumentError("no pair ($i, $j) among $n momenta"))
+    return (i - 1) * (2n - i) ÷ 2 + (j - i)
+end
+
+"""
+    find_pairs(momenta; quantity=:delta_r, below=Inf, above=-Inf, threads=0)
+
+The pairs of `momenta` whose `quantity` lies strictly between `above` and
+`below`, as columns `(first, second, value)` with `first < second` indexing
+`momenta`, in the order of [`pair_matrix`](@ref). Arguments as for
+`pair_matrix`; only the matching pairs are copied back, so this suits large
+`n` with few matches, e.g. close pairs for overlap removal or masses in a
+resonance window.
+
+# Examples
+```julia
+p = select_momenta(event; status=1).momenta
+overlaps = find_pairs(p; below=0.4)
+z_candidates = find_pairs(p; quantity=:mass, above=81.0, below=101.0)
+```
+"""
+function find_pairs(momenta; quantity::Symbol=:delta_r, below::Real=Inf, above::Real=-Inf, threads::Integer=0)
+    q = _pair_quantity(quantity)
+    list = _with_momentum_pointers(momenta) do n, px, py, pz, e, stride
+        find_particle_pairs(q, n, px, py, pz, e, stride, Float64(above), Float64(below), Cint(threads))
+    end
+    try
+        n = pair_list_size(list)
+        first = Vector{Int64}(undef, n)
+        second = Vector{Int64}(undef, n)
+        values = Vector{Float64}(undef, n)
+        GC.@preserve first second values copy_pair_list(list, pointer(first), pointer(second), pointer(values))
+        return (first = first .+ 1, second = second .+ 1, value = values)
+    finally
+        delete_pair_list(list)
+    end
+end
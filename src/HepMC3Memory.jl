@@ -0,0 +1,224 @@
+# Event recycling and arena allocation implemented in the C++ layer (HepMC3WrapMemory.cpp).
+
+export EventPool, pool_stats, acquire_event, release_event!, release_events!, read_pooled_event
+export compact_event!, event_memory_bytes, native_memory, native_gc_pressure!
+
+"""
+    EventPool(; max_idle=1024)
+
+Pool of cleared C++ `GenEvent`s for reading without allocating a new event
+per read. Pass it to `read_hepmc_file(filename; pool)` or
+[`read_pooled_event`](@ref). Events go back to the pool when released with
+[`release_event!`](@ref) or [`release_events!`](@ref); up to `max_idle` are
+kept. Recycled events keep the capacity of their particle and vertex vectors.
+Events may outlive the pool.
+"""
+mutable struct EventPool
+    ptr::Ptr{Cvoid}
+
+    function EventPool(; max_idle::Integer=1024)
+        pool = new(create_event_pool(Cint(max_idle)))
+        finalizer(_delete_event_pool, pool)
+        return pool
+    end
+end
+
+function _delete_event_pool(pool::EventPool)
+    if pool.ptr != C_NULL
+        delete_event_pool(pool.ptr)
+        pool.ptr = C_NULL
+    end
+    return nothing
+end
+
+function _event_pool_pointer(pool::EventPool)
+    pool.ptr == C_NULL && error("EventPool has been freed")
+    return pool.ptr
+end
+
+"""
+    pool_stats(pool::EventPool)
+
+`(hits, misses, released, discarded, idle)`: events handed out from the pool
+and newly allocated, events returned for reuse and freed because the pool was
+full, and events currently waiting for reuse.
+"""
+function pool_stats(pool::EventPool)
+    counts = zeros(Int64, 5)
+    GC.@preserve counts event_pool_counts(_event_pool_pointer(pool), pointer(counts))
+    return (hits = counts[1], misses = counts[2], released = counts[3], discarded = counts[4], idle = counts[5])
+end
+
+"""
+    acquire_event(pool::EventPool)
+
+An empty event from the pool, as an event pointer like those returned by
+`read_hepmc_file`. Release it with [`release_event!`](@ref).
+"""
+acquire_event(pool::EventPool) = event_pool_acquire(_event_pool_pointer(pool))
+
+"""
+    release_event!(event_ptr)
+
+Free an event pointer from `read_hepmc_file`, [`read_pooled_event`](@ref) or
+[`acquire_event`](@ref). Pooled events return to their pool once nothing else
+refers to them. The pointer must not be used afterwards.
+"""
+function release_event!(event_ptr::Ptr{Nothing})
+    release_event_shared(event_ptr)
+    return nothing
+end
+
+"""
+    release_events!(events)
+
+Release every event pointer in `events` and empty the vector.
+"""
+function release_events!(events::AbstractVector)
+    foreach(release_event!, events)
+    empty!(events)
+    return events
+end
+
+"""
+    read_pooled_event(reader, pool::EventPool; attributes=nothing)
+
+Read the next event of a reader handle from `create_reader_ascii` into an
+event from `pool`, applying the `AttributePolicy` `attributes` if given.
+Returns an event pointer, or `nothing` at the end of the file.
+
+# Examples
+```julia
+pool = EventPool()
+reader = create_reader_ascii("events.hepmc3")
+while (event = read_pooled_event(reader, pool)) !== nothing
+    analyse(event)
+    release_event!(event)       # the next read reuses it
+end
+pool_stats(pool)                # (hits = n - 1, misses = 1, ...)
+```
+"""
+function read_pooled_event(reader, pool::EventPool; attributes=nothing)
+    event = reader_read_event_pooled(reader, _event_pool_pointer(pool), _attribute_policy_pointer(attributes))
+    _collect_native_garbage()
+    return event == C_NULL ? nothing : event
+end
+
+"""
+    compact_event!(event)
+
+Rebuild the particles and vertices of `event` (a `GenEvent` or an event
+pointer) in a per-event arena: one contiguous block holds every particle and
+vertex together with its reference count, and the whole record is freed in
+one step when the event is cleared or released. Content, ids and attributes
+are unchanged; particle and vertex pointers taken before the call refer to
+the old objects. Returns `event`. See also `build_event(...; arena=true)`.
+
+No speed-up of navigation has been measured yet;
+`examples/benchmark_arena_navigation.jl` compares the two layouts.
+
+# Examples
+```julia
+events = read_hepmc_file("events.hepmc3")
+foreach(compact_event!, events)
+```
+"""
+function compact_event!(event)
+    GC.@preserve event move_event_to_arena(_event_pointer(event))
+    _collect_native_garbage()
+    return event
+end
+
+"""
+    event_memory_bytes(event)
+
+Approximate native heap bytes held by `event` (a `GenEvent` or an event
+pointer): particles, vertices and their links, weights and attributes with
+their names and values. The run info, which events share, is not included.
+"""
+event_memory_bytes(event) = Int(GC.@preserve event estimate_event_memory(_event_pointer(event)))
+
+# Julia's GC only sees the small Julia objects wrapping C++ events, and Julia
+# has no API to report foreign memory to its collection heuristics. Instead,
+# the C++ readers and builders add up the native bytes of the events they fill
+# and file a collection request whenever the limit set with native_gc_pressure!
+# is passed. With `collect=true`, the wrapper functions force one incremental
+# collection for the requests filed since the last one, so that finalizers of
+# unreachable events run. Atomics, as events are read on several threads.
+struct _NativeGCPressure
+    collect::Threads.Atomic{Bool}
+    handled::Threads.Atomic{Int}        # requests answered or skipped
+    collections::Threads.Atomic{Int}
+end
+
+const _NATIVE_GC_PRESSURE = _NativeGCPressure(Threads.Atomic{Bool}(false), Threads.Atomic{Int}(0),
+                                              Threads.Atomic{Int}(0))
+
+"""
+    native_gc_pressure!(limit_bytes; collect=false)
+
+Count the native memory of events as they are filled, by `read_hepmc_file`,
+`reader_read_event`, [`read_pooled_event`](@ref), `build_event!`,
+`parse_event!` or [`compact_event!`](@ref), and file a collection request
+each time `limit_bytes` have added up; `native_memory()` reports the
+requests. Events are counted as by [`event_memory_bytes`](@ref) without their
+attributes, whose map HepMC3 only hands out as a copy. With `collect=true`,
+the next of these calls made from Julia (not `reader_read_event`, which is
+counted only) forces an incremental collection with `GC.gc(false)` on the
+calling thread, so that finalizer-owned events which are no longer
+referenced are freed on memory-heavy event streams. The native bytes are not
+reported to Julia's own collection heuristics. Without `collect`, no
+collection is forced and the application can collect when `gc_requests`
+grows. `nothing` or `0` turns counting off (the default). Counting is
+thread-safe. Returns the previous limit.
+
+# Examples
+```julia
+native_gc_pressure!(256 * 2^20; collect=true)   # collect after every 256 MiB of event data
+```
+"""
+function native_gc_pressure!(limit_bytes::Union{Integer,Nothing}; collect::Bool=false)
+    limit_bytes === nothing || limit_bytes >= 0 || throw(ArgumentError("limit_bytes must not be negative"))
+    pressure = _NATIVE_GC_PRESSURE
+    pressure.collect[] = collect
+    pressure.handled[] = native_gc_requests()
+    previous = set_native_gc_limit(limit_bytes === nothing ? Int64(0) : Int64(limit_bytes))
+    return previous == 0 ? nothing : Int(previous)
+end
+
+# Run one collection for the requests filed since the last one, if enabled;
+# of several threads getting here at once, the one claiming them collects
+function _collect_native_garbage()
+    pressure = _NATIVE_GC_PRESSURE
+    pressure.collect[] || return nothing
+    requests = Int(native_gc_requests())
+    handled = pressure.handled[]
+    if requests > handled && Threads.atomic_cas!(pressure.handled, handled, requests) == handled
+        Threads.atomic_add!(pressure.collections, 1)
+        GC.gc(false)
+    end
+    return nothing
+end
+
+"""
+    native_memory()
+
+Gauges of the wrapper's native memory:
+
+- `heap_bytes`, `mapped_bytes`: bytes in use on the C heap of the whole
+  process, and in large separately mapped blocks (`-1` where the C library
+  does not report them)
+- `arena_bytes`, `arenas`: blocks held by event arenas (see
+  [`compact_event!`](@ref)) and the number of live arenas
+- `pooled_events`: events idle in all [`EventPool`](@ref)s
+- `gc_pending_bytes`, `gc_requests`, `gc_collections`: native bytes counted
+  towards the next collection request, requests filed and collections run
+  so far (see [`native_gc_pressure!`](@ref))
+"""
+function native_memory()
+    counts = zeros(Int64, 7)
+    GC.@preserve counts native_memory_counts(pointer(counts))
+    return (heap_bytes = counts[1], mapped_bytes = counts[2], arena_bytes = counts[3], arenas = counts[4],
+            pooled_events = counts[5], gc_pending_bytes = counts[6], gc_requests = counts[7],
+            gc_collections = _NATIVE_GC_PRESSURE.collections[])
+end
@@ -0,0 +1,125 @@
+# Multi-stage event pipeline implemented in the C++ layer (HepMC3WrapPipeline.cpp).
+
+export EventPipeline, event_pipeline, pipeline_stats
+
+const _PIPELINE_STAGES = (:source, :filter, :extract, :sink)
+
+"""
+    EventPipeline
+
+A running read → filter → extract → sink pipeline; see
+[`event_pipeline`](@ref). Use [`pipeline_stats`](@ref) to watch it and
+`wait` to collect its result.
+"""
+mutable struct EventPipeline
+    ptr::Ptr{Cvoid}
+    kernel::Bool
+end
+
+"""
+    event_pipeline(source; writer=nothing, kernel=nothing, status=0, pdg=Int[],
+                   pt_min=0.0, abs_eta_max=Inf, min_selected=0, max_selected=-1,
+                   filter_threads=1, extract_threads=1, capacity=256, max_events=-1)
+
+Start a pipeline in which every stage runs on its own C++ thread(s), connected
+by bounded lock-free queues:
+
+1. source: reads events from `source`, a file name or a handle from
+   `create_reader_ascii`
+2. filter (`filter_threads`): keeps events with at least `min_selected` and,
+   unless `max_selected` is negative, at most `max_selected` particles passing
+   the selection (`status`, `abs.(pdg)`, `pt_min`, `abs_eta_max`, as for
+   [`run_engine`](@ref))
+3. extract (`extract_threads`): runs `kernel` (e.g. `:particles`) on accepted
+   events with the same selection; skipped when `kernel` is `nothing`
+4. sink: writes accepted events in read order to `writer`, a handle from
+   `create_writer_ascii` or the compressed writers, and collects the kernel's
+   rows
+
+Each queue holds at most `capacity` events; a full queue blocks the stage
+feeding it, so a slow sink throttles the reader instead of buffering the
+file. The reader also waits while it is more than the queues can hold ahead
+of the sink, so events waiting behind a slow one to be put back in order
+stay bounded too. Returns immediately. Reader and writer handles belong to the pipeline
+until `wait` returns; the writer is not closed.
+
+# Examples
+```julia
+writer = create_writer_ascii("dimuon.hepmc3")
+pipeline = event_pipeline("events.hepmc3"; writer, status=1, pdg=[13], pt_min=20.0,
+                          min_selected=2, filter_threads=4, kernel=:particles)
+pipeline_stats(pipeline).filter      # watch progress
+result = wait(pipeline)              # (read, accepted, columns)
+writer_close(writer)
+```
+"""
+function event_pipeline(source; writer=nothing, kernel=nothing, status::Integer=0, pdg=Int[], pt_min::Real=0.0,
+                        abs_eta_max::Real=Inf, min_selected::Integer=0, max_selected::Integer=-1,
+                        filter_threads::Integer=1, extract_threads::Integer=1, capacity::Integer=256,
+                        max_events::Integer=-1)
+    source isa AbstractString && !isfile(source) && throw(ArgumentError("File not found: $source"))
+    abs_pdg = Cint[abs(p) for p in pdg]
+    reader = source isa AbstractString ? C_NULL : source
+    filename = source isa AbstractString ? String(source) : ""
+    ptr = GC.@preserve abs_pdg create_event_pipeline(reader, filename, writer === nothing ? C_NULL : writer,
+                                                     kernel === nothing ? "" : String(kernel), Cint(status),
+                                                     isempty(abs_pdg) ? Ptr{Cint}(C_NULL) : pointer(abs_pdg),
+                                                     Cint(length(abs_pdg)), Float64(pt_min), Float64(abs_eta_max),
+                                                     Cint(min_selected), Cint(max_selected), Cint(filter_threads),
+                                                     Cint(extract_threads), Cint(capacity), Int64(max_events))
+    pipeline = EventPipeline(ptr, kernel !== nothing)
+    finalizer(_delete_event_pipeline, pipeline)
+    return pipeline
+end
+
+function _delete_event_pipeline(pipeline::EventPipeline)
+    if pipeline.ptr != C_NULL
+        delete_event_pipeline(pipeline.ptr)
+        pipeline.ptr = C_NULL
+    end
+    return nothing
+end
+
+"""
+    pipeline_stats(pipeline::EventPipeline)
+
+Live counters of a pipeline. For each stage (`source`, `filter`, `extract`,
+`sink`): events taken in and passed on (`in`, `out`; for the filter, `out`
+counts accepted events), `busy_seconds` spent working, `full_waits` (times the
+next queue was full: backpressure) and `empty_waits` (times the stage waited
+for input). `queued` gives the current fill of the `filter`, `extract` and
+`sink` input queues, and `running` whether any stage is still active.
+"""
+function pipeline_stats(pipeline::EventPipeline)
+    pipeline.ptr == C_NULL && error("EventPipeline has finished")
+    counts = zeros(Int64, 5 * length(_PIPELINE_STAGES) + 3)
+    GC.@preserve counts pipeline_counts(pipeline.ptr, pointer(counts))
+    stage(i) = (in = counts[5i-4], out = counts[5i-3], busy_seconds = counts[5i-2] / 1e9,
+                full_waits = counts[5i-1], empty_waits = counts[5i])
+    n = 5 * length(_PIPELINE_STAGES)
+    return (source = stage(1), filter = stage(2), extract = stage(3), sink = stage(4),
+            queued = (filter = counts[n+1], extract = counts[n+2], sink = counts[n+3]),
+            running = pipeline_running(pipeline.ptr))
+end
+
+"""
+    wait(pipeline::EventPipeline)
+
+Block until every event has passed through the pipeline and return
+`(read = n, accepted = m, columns = c)`, where `c` holds the kernel's rows as
+for [`run_engine`](@ref) (with `event` the 1-based read position), or is
+`nothing` without a kernel. Throws if a stage failed.
+"""
+function Base.wait(pipeline::EventPipeline)
+    pipeline.ptr == C_NULL && error("EventPipeline has finished")
+    result = pipeline_finish(pipeline.ptr)
+    accepted = pipeline_stats(pipeline).sink.out
+    _delete_event_pipeline(pipeline)
+    try
+        engine_result_failed(result) && error("Event pipeline failed: $(_cstring_to_string(engine_result_error(result)))")
+        columns = pipeline.kernel ? _engine_columns(result) : nothing
+        return (read = Int(engine_result_events(result)), accepted = Int(accepted), columns = columns)
+    finally
+        delete_engine_result(result)
+    end
+end
@@ -0,0 +1,210 @@
+# Packed in-memory event store and event cache implemented in the C++ layer (HepMC3WrapStore.cpp).
+
+export EventStore, materialize_event, find_event, store_stats
+export EventCache, cached_event, cache_stats
+
+"""
+    EventStore(; float32=false)
+    EventStore(filename; float32=false, max_events=-1, attributes=nothing)
+
+Random-access event storage that keeps events packed in flat columns
+instead of one `GenEvent` object graph per event: about 60 bytes per
+particle including its links, or 45 with `float32=true`, which stores
+momenta, masses and vertex positions in single precision. Events are
+rebuilt as `GenEvent`s only when accessed.
+
+The second form reads an ASCII file, applying the `AttributePolicy`
+`attributes` if given. Add further events with `push!`.
+
+`store[i]` returns event `i` as a new event pointer, like those of
+`read_hepmc_file`; release it with [`release_event!`](@ref) when done. See
+also [`materialize_event`](@ref) and [`find_event`](@ref).
+
+# Examples
+```julia
+store = EventStore("events.hepmc3"; float32=true)
+store_stats(store).bytes
+event = store[find_event(store, 4711)]
+analyse(event)
+release_event!(event)
+```
+"""
+mutable struct EventStore
+    ptr::Ptr{Cvoid}
+
+    function EventStore(; float32::Bool=false)
+        store = new(create_event_store(float32))
+        finalizer(_delete_event_store, store)
+        return store
+    end
+end
+
+function EventStore(filename::AbstractString; float32::Bool=false, max_events::Integer=-1, attributes=nothing)
+    isfile(filename) || throw(ArgumentError("File not found: $filename"))
+    store = EventStore(; float32)
+    n = event_store_read_file(store.ptr, String(filename), Int64(max_events), _attribute_policy_pointer(attributes))
+    n < 0 && error("HepMC3 reader failed to read file: $filename")
+    return store
+end
+
+function _delete_event_store(store::EventStore)
+    if store.ptr != C_NULL
+        delete_event_store(store.ptr)
+        store.ptr = C_NULL
+    end
+    return nothing
+end
+
+function _event_store_pointer(store::EventStore)
+    store.ptr == C_NULL && error("EventStore has been freed")
+    return store.ptr
+end
+
+"""
+    store_stats(store::EventStore)
+
+`(events, particles, vertices, bytes)`, where `bytes` is the memory held by
+the store's columns.
+"""
+function store_stats(store::EventStore)
+    counts = zeros(Int64, 4)
+    GC.@preserve counts event_store_counts(_event_store_pointer(store), pointer(counts))
+    return (events = counts[1], particles = counts[2], vertices = counts[3], bytes = counts[4])
+end
+
+Base.length(store::EventStore) = Int(store_stats(store).events)
+Base.firstindex(::EventStore) = 1
+Base.lastindex(store::EventStore) = length(store)
+Base.eachindex(store::EventStore) = Base.OneTo(length(store))
+
+"""
+    push!(store::EventStore, event)
+
+Pack a copy of `event` (a `GenEvent` or an event pointer) into the store.
+The store refers to the event's run info, which materialised events share.
+"""
+function Base.push!(store::EventStore, event)
+    GC.@preserve event event_store_add(_event_store_pointer(store), _event_pointer(event))
+    return store
+end
+
+"""
+    materialize_event(store::EventStore, i; arena=false)
+
+Rebuild event `i` (1-based) as a new event pointer; with `arena=true` its
+particles and vertices are allocated as by [`compact_event!`](@ref). Release
+it with [`release_event!`](@ref).
+"""
+function materialize_event(store::EventStore, i::Integer; arena::Bool=false)
+    checkbounds(Bool, 1:length(store), i) || throw(BoundsError(store, i))
+    return event_store_materialize(_event_store_pointer(store), Int64(i - 1), arena)
+end
+
+Base.getindex(store::EventStore, i::Integer) = materialize_event(store, i)
+
+"""
+    find_event(store::EventStore, event_number)
+
+Position of the first event with `event_number`, or `nothing`. Increasing
+event numbers are searched in place; otherwise an index is built on first
+use.
+"""
+function find_event(store::EventStore, event_number::Integer)
+    i = event_store_find(_event_store_pointer(store), Cint(event_number))
+    return i < 0 ? nothing : Int(i) + 1
+end
+
+"""
+    EventCache(source; budget_bytes=2^30, scratch=tempname())
+
+Random access by position to the events of `source`, an ASCII file name or
+an [`EventStore`](@ref), keeping the most recently used events in memory up
+to `budget_bytes` (as measured by [`event_memory_bytes`](@ref)). File events
+are read as far as needed; when they are pushed out of memory they are
+written to the binary scratch file `scratch` and read back from there on the
+next access. Store events are simply materialised again. The scratch file is
+removed with the cache.
+
+`cache[i]` returns event `i` as a new event pointer that shares the cached
+event, so a hit costs no copy; it must not be modified. Ask for a private
+copy to modify with [`cached_event`](@ref)`(cache, i; copy=true)`. Release
+either with [`release_event!`](@ref). Events still held are not counted
+against `budget_bytes`. Reading past the last event throws a `BoundsError`.
+[`cache_stats`](@ref) reports hit rates.
+
+# Examples
+```julia
+cache = EventCache("events.hepmc3"; budget_bytes=512 * 2^20)
+for pass in 1:3, i in 1:1000
+    event = cache[i]
+    analyse(event, pass)
+    release_event!(event)
+end
+cache_stats(cache).hit_rate
+```
+"""
+mutable struct EventCache
+    ptr::Ptr{Cvoid}
+    source::Union{Nothing,EventStore}
+end
+
+function EventCache(source; budget_bytes::Integer=2^30, scratch::AbstractString=tempname())
+    budget_bytes >= 0 || throw(ArgumentError("budget_bytes must not be negative"))
+    if source isa EventStore
+        ptr = create_event_cache("", _event_store_pointer(source), Int64(budget_bytes), String(scratch))
+        cache = EventCache(ptr, source)
+    else
+        isfile(source) || throw(ArgumentError("File not found: $source"))
+        cache = EventCache(create_event_cache(String(source), C_NULL, Int64(budget_bytes), String(scratch)), nothing)
+    end
+    finalizer(_delete_event_cache, cache)
+    return cache
+end
+
+function _delete_event_cache(cache::EventCache)
+    if cache.ptr != C_NULL
+        delete_event_cache(cache.ptr)
+        cache.ptr = C_NULL
+    end
+    return nothing
+end
+
+"""
+    cached_event(cache::EventCache, i; copy=false)
+
+Event `i` of an [`EventCache`](@ref) as a new event pointer. Without `copy`
+the pointer shares the cached event and must not be modified, as for
+`cache[i]`; with `copy=true` it owns a copy that the caller may change
+without affecting the cache.
+"""
+function cached_event(cache::EventCache, i::Integer; copy::Bool=false)
+    cache.ptr == C_NULL && error("EventCache has been freed")
+    event = event_cache_get(cache.ptr, Int64(i - 1), copy)
+    event == C_NULL && throw(BoundsError(cache, i))
+    return event
+end
+
+Base.getindex(cache::EventCache, i::Integer) = cached_event(cache, i)
+
+Base.close(cache::EventCache) = _delete_event_cache(cache)
+
+"""
+    cache_stats(cache::EventCache)
+
+Counters of an [`EventCache`](@ref): accesses served from memory (`hits`),
+from the scratch file (`disk_hits`) and from the source (`misses`), with
+`hit_rate` and `disk_hit_rate` as fractions of all accesses; events read
+from the source (`reads`), written to the scratch file (`spills`) and pushed
+out of memory (`evictions`); and the current `events` and `bytes` in memory
+and `scratch_bytes` on disk.
+"""
+function cache_stats(cache::EventCache)
+    cache.ptr == C_NULL && error("EventCache has been freed")
+    counts = zeros(Int64, 9)
+    GC.@preserve counts event_cache_counts(cache.ptr, pointer(counts))
+    accesses = max(counts[1] + counts[2] + counts[3], 1)
+    return (hits = counts[1], disk_hits = counts[2], misses = counts[3],
+            hit_rate = counts[1] / accesses, disk_hit_rate = counts[2] / accesses,
+            reads = counts[4], spills = counts[5], evictions = counts[6],
+            events = counts[7], bytes = counts[8], scratch_bytes = counts[9])
+end
@@ -0,0 +1,70 @@
+# Data-quality checks implemented in the C++ layer (HepMC3WrapValidation.cpp).
+
+export check_momentum_conservation
+
+"""
+    check_momentum_conservation(event; tolerance=1e-6, relative=true)
+
+Compute Σp_in − Σp_out at every vertex of an event in a single pass in C++.
+Only vertices with both incoming and outgoing particles are checked. A vertex
+fails when the largest residual component exceeds `tolerance`, taken relative
+to the vertex's incoming energy unless `relative=false`. Vertices with NaN or
+infinite momenta always fail.
+
+Returns a named tuple:
+
+- `vertices`: 1-based positions (as used by `get_vertex_at`) of failing vertices
+- `residuals`: a `4 × n` matrix with the residual (px, py, pz, e) of each
+  failing vertex in its columns
+
+# Examples
+```julia
+bad = check_momentum_conservation(event; tolerance=1e-9)
+isempty(bad.vertices) || @warn "Momentum not conserved" bad.vertices
+```
+"""
+function check_momentum_conservation(event; tolerance::Real=1e-6, relative::Bool=true)
+    n_vertices = vertices_size(event)
+    vertices = Vector{Int32}(undef, n_vertices)
+    residuals = Matrix{Float64}(undef, 4, n_vertices)
+    n = GC.@preserve event vertices residuals check_vertex_momentum_conservation(_event_pointer(event), Float64(tolerance),
+                                                                                  relative, pointer(vertices), pointer(residuals))
+    return (vertices = vertices[1:n], residuals = residuals[:, 1:n])
+end
+
+"""
+    check_momentum_conservation(filename::AbstractString; tolerance=1e-6, relative=true,
+                                max_events=-1, max_records=1000)
+
+Stream a HepMC3 ASCII file through one reused event in C++ and check momentum
+conservation at every vertex, as [`check_momentum_conservation(event)`](@ref)
+does. No events are kept in memory, so this can gate files of any size.
+
+Returns a named tuple with `n_events`, `n_failed_events`, `n_failed_vertices`,
+`max_residual` (the largest residual seen, relative if `relative=true`, and
+`Inf` if a residual was NaN or infinite), and
+the first `max_records` failures as `event_numbers`, `vertices` and a `4 × n`
+`residuals` matrix.
+"""
+function check_momentum_conservation(filename::AbstractString; tolerance::Real=1e-6, relative::Bool=true,
+                                     max_events::Integer=-1, max_records::Integer=1000)
+    isfile(filename) || error("File not found: $filename")
+    check = check_momentum_conservation_file(String(filename), Float64(tolerance), relative,
+                                             Cint(max_events), Cint(max_records))
+    check == C_NULL && error("HepMC3 reader failed to read file: $filename")
+    try
+        counts = zeros(Int64, 3)
+        GC.@preserve counts momentum_check_counts(check, pointer(counts))
+        n = momentum_check_records_size(check)
+        event_numbers = Vector{Int32}(undef, n)
+        vertices = Vector{Int32}(undef, n)
+        residuals = Matrix{Float64}(undef, 4, n)
+        GC.@preserve event_numbers vertices residuals copy_momentum_check_records(check, pointer(event_numbers),
+                                                                                  pointer(vertices), pointer(residuals))
+        return (n_events = counts[1], n_failed_events = counts[2], n_failed_vertices = counts[3],
+                max_residual = momentum_check_max_residual(check),
+                event_numbers = event_numbers, vertices = vertices, residuals = residuals)
+    finally
+        delete_momentum_check(check)
+    end
+end
@@ -43,4 +43,74 @@
         string_attr = add_particle_attribute!(p1, "label", "test_particle")
         @test string_attr != C_NULL
     end
-end
\ No newline at end of file
+
+    @testset "Attribute Policies and Interning" begin
+        filename = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(filename)
+        for i in 1:5
+            event = create_event(i)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            add_particle_attribute!(outgoing, "flow1", 501)
+            add_particle_attribute!(outgoing, "flow2", 502)
+            add_particle_attribute!(outgoing, "label", "shower")
+            add_particle_attribute!(outgoing, "theta", 0.5 * i)
+            add_cross_section!(event, 1.23, 0.45)
+            HepMC3.writer_write_event(writer, event.cpp_object)
+        end
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        events = read_hepmc_file(filename)
+        table = event_attributes(events[1])
+        @test table.name == ["GenCrossSection", "flow1", "flow2", "label", "theta"]
+        @test table.id == [0, 2, 2, 2, 2]
+        @test table.value[2:4] == ["501", "502", "shower"]
+        release_events!(events)
+
+        policy = AttributePolicy("flow*" => :drop, "theta" => :parse, "GenCrossSection" => :parse)
+        events = read_hepmc_file(filename; attributes = policy)
+        table = event_attributes(events[3])
+        @test table.name == ["GenCrossSection", "label", "theta"]
+        @test parse(Float64, table.value[3]) ≈ 1.5
+        @test attribute_policy_stats(policy) == (kept = 5, dropped = 10, parsed = 10)
+        release_events!(events)
+
+        # Integers too large for IntAttribute keep their value
+        event = create_event(1)
+        particle = make_shared_particle(1.0, 2.0, 3.0, 10.0, 211, 1)
+        vertex = make_shared_vertex()
+        connect_particle_out(vertex, particle)
+        attach_vertex_to_event(event, vertex)
+        add_particle_attribute!(particle, "big", "3000000000")
+        add_particle_attribute!(particle, "huge", "1" * "0"^30)
+        apply_attribute_policy!(event, AttributePolicy("*" => :parse))
+        table = event_attributes(event)
+        @test table.name == ["big", "huge"]
+        @test table.value[1] == "3000000000"
+        @test parse(Float64, table.value[2]) == 1e30
+
+        # Names and values repeated across events are stored once
+        interner = AttributeInterner()
+        pool = EventPool()
+        drop_theta = AttributePolicy("the?a" => :drop)
+        reader = HepMC3.create_reader_ascii(filename)
+        tables = []
+        while (event = read_pooled_event(reader, pool; attributes = drop_theta)) !== nothing
+            push!(tables, event_attributes(event; interner))
+            release_event!(event)
+        end
+        HepMC3.delete_reader_ascii(reader)
+        @test length(tables) == 5
+        @test all(t.name == ["GenCrossSection", "flow1", "flow2", "label"] for t in tables)
+        @test pointer(tables[1].value[4]) == pointer(tables[5].value[4])
+        @test pointer(tables[1].name[2]) == pointer(tables[5].name[2])
+        @test length(interner) == 8
+
+        @test_throws ArgumentError AttributePolicy("x" => :ignore)
+    end
+end
@@ -89,4 +89,262 @@
         @test vertices_size(event) == 4
         @test event_number(event) == 999
     end
-end
\ No newline at end of file
+
+    @testset "Bulk Slimming" begin
+        # p -> v1 -> (h, g); h -> v2 -> x; x -> v3 -> (f1, f2); g -> v4 -> f3
+        function build_shower_event()
+            event = create_event(77)
+            set_units!(event, :GeV, :mm)
+            p = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+            h = make_shared_particle(1.0, 0.0, 60.0, 61.0, 25, 22)
+            g = make_shared_particle(-1.0, 0.0, 39.0, 39.0, 21, 2)
+            x = make_shared_particle(1.0, 0.0, 59.0, 60.0, 5, 2)
+            f1 = make_shared_particle(0.5, 0.0, 30.0, 30.5, 211, 1)
+            f2 = make_shared_particle(0.5, 0.0, 29.0, 29.5, -211, 1)
+            f3 = make_shared_particle(-1.0, 0.0, 39.0, 39.0, 22, 1)
+            layout = [([p], [h, g]), ([h], [x]), ([x], [f1, f2]), ([g], [f3])]
+            for (incoming, outgoing) in layout
+                v = make_shared_vertex()
+                foreach(q -> connect_particle_in(v, q), incoming)
+                foreach(q -> connect_particle_out(v, q), outgoing)
+                attach_vertex_to_event(event, v)
+            end
+            add_particle_attribute!(f1, "tag", "seven")
+            return event
+        end
+
+        event = build_shower_event()
+        new_ids = slim_event!(event; final_state=true, beams=true, collapse=true)
+        @test new_ids == Int32[1, 0, 0, 0, 2, 3, 4]
+        @test particles_size(event) == 4
+        @test vertices_size(event) == 1
+        @test length(get_decay_products(get_particle_at(event, 1))) == 3
+        @test event_number(event) == 77
+
+        filename = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(filename)
+        @test HepMC3.writer_write_event(writer, event.cpp_object)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+        @test occursin("A 2 tag seven", read(filename, String))
+        rm(filename)
+
+        event = build_shower_event()
+        slim_event!(event; final_state=true)
+        @test particles_size(event) == 3
+        @test vertices_size(event) == 2
+        @test isempty(get_parent_particles(get_particle_at(event, 1)))
+
+        event = build_shower_event()
+        new_ids = slim_event!(event; keep=[5], ancestors=true)
+        @test new_ids == Int32[1, 2, 0, 3, 4, 0, 0]
+        @test particles_size(event) == 4
+        @test vertices_size(event) == 3
+        @test length(find_particle_ancestry_flat(get_particle_at(event, 4)).ids) == 3
+
+        event = build_shower_event()
+        slim_event!(event; status_range=21:29)
+        @test particles_size(event) == 1
+    end
+
+    @testset "Columnar Construction" begin
+        particles = (px = [0.0, 0.0, 0.0, 10.0, -10.0], py = zeros(5), pz = [45.6, -45.6, 0.0, 44.5, -44.5],
+                     e = [45.6, 45.6, 91.2, 45.6, 45.6], pdg = [11, -11, 23, 13, -13], status = [4, 4, 2, 1, 1],
+                     mass = [NaN, NaN, 91.19, NaN, NaN])
+        event = build_event(particles, (x = [0.0, 0.1], y = [0.0, 0.2], z = [0.0, 0.3], t = [0.0, 0.4], status = [0, 2]);
+                            production = [0, 0, 1, 2, 2], end_vertex = [1, 1, 2, 0, 0], event_number = 42,
+                            weights = [1.0, 0.25])
+
+        @test event_number(event) == 42
+        @test particles_size(event) == 5
+        @test vertices_size(event) == 2
+        @test get_event_weights(event) == [1.0, 0.25]
+        @test length(get_incoming_particles(get_vertex_at(event, 1))) == 2
+        @test length(get_outgoing_particles(get_vertex_at(event, 2))) == 2
+        decay_vertex = get_vertex_at(event, 2)
+        @test (get_vertex_x(decay_vertex), get_vertex_y(decay_vertex), get_vertex_z(decay_vertex),
+               get_vertex_t(decay_vertex)) == (0.1, 0.2, 0.3, 0.4)
+        @test is_generated_mass_set(get_particle_at(event, 3))
+        @test !is_generated_mass_set(get_particle_at(event, 4))
+
+        # Same record built object by object
+        manual = create_event(7)
+        built = [make_shared_particle(particles.px[i], particles.py[i], particles.pz[i], particles.e[i],
+                                      particles.pdg[i], particles.status[i]) for i in 1:5]
+        v1 = make_shared_vertex()
+        connect_particle_in(v1, built[1])
+        connect_particle_in(v1, built[2])
+        connect_particle_out(v1, built[3])
+        attach_vertex_to_event(manual, v1)
+        v2 = make_shared_vertex()
+        connect_particle_in(v2, built[3])
+        connect_particle_out(v2, built[4])
+        connect_particle_out(v2, built[5])
+        attach_vertex_to_event(manual, v2)
+        @test events_equal(build_event(particles, 2; production = [0, 0, 1, 2, 2], end_vertex = [1, 1, 2, 0, 0]),
+                           manual)
+
+        # Refilling an existing event replaces its content
+        build_event!(event, (px = [1.0], py = [0.0], pz = [0.0], e = [1.0], pdg = [22], status = [1]), 0;
+                     production = [0], end_vertex = [0])
+        @test particles_size(event) == 1
+        @test vertices_size(event) == 0
+        @test event_number(event) == 42
+
+        @test_throws DimensionMismatch build_event((px = [1.0, 2.0], py = [0.0], pz = [0.0], e = [1.0],
+                                                    pdg = [22], status = [1]), 0;
+                                                   production = [0], end_vertex = [0])
+        @test_throws Exception build_event((px = [1.0], py = [0.0], pz = [0.0], e = [1.0], pdg = [22], status = [1]), 1;
+                                           production = [2], end_vertex = [0])
+    end
+
+    @testset "Memory Accounting" begin
+        columns(n) = (px = collect(1.0:n), py = zeros(n), pz = ones(n), e = fill(100.0, n),
+                      pdg = fill(211, n), status = fill(1, n))
+        small = build_event(columns(2), 0; production = [0, 0], end_vertex = [0, 0])
+        large = build_event(columns(200), 0; production = zeros(Int, 200), end_vertex = zeros(Int, 200))
+        @test event_memory_bytes(small) > 0
+        @test event_memory_bytes(large) > event_memory_bytes(small) + 100 * 64
+
+        # Attributes are counted with their names and values
+        before = event_memory_bytes(small)
+        add_particle_attribute!(get_particle_at(small, 1), "a_rather_long_attribute_name", repeat("x", 200))
+        @test event_memory_bytes(small) >= before + 200
+        @test event_memory_bytes(small) < before + 400   # the text is counted once
+
+        # Accounting leaves the attributes out
+        native_gc_pressure!(2^40)
+        compact_event!(small)
+        @test 0 < native_memory().gc_pending_bytes <= event_memory_bytes(small) - 200
+        @test native_gc_pressure!(nothing) == 2^40
+
+        gauges = native_memory()
+        arenas = gauges.arenas
+        arena = build_event(columns(50), 0; production = zeros(Int, 50), end_vertex = zeros(Int, 50), arena = true)
+        @test native_memory().arenas == arenas + 1
+        @test native_memory().arena_bytes >= gauges.arena_bytes + 50 * 64
+        @test gauges.heap_bytes == -1 || gauges.heap_bytes > 0
+        build_event!(arena, columns(1), 0; production = [0], end_vertex = [0])
+        @test native_memory().arenas == arenas
+
+        # Events filled through the wrapper count towards a collection
+        # request; the collection itself runs only with collect=true
+        @test native_gc_pressure!(event_memory_bytes(large)) === nothing
+        gauges = native_memory()
+        build_event(columns(200), 0; production = zeros(Int, 200), end_vertex = zeros(Int, 200))
+        @test native_memory().gc_requests == gauges.gc_requests + 1
+        @test native_memory().gc_collections == gauges.gc_collections
+        @test native_memory().gc_pending_bytes == 0
+        @test native_gc_pressure!(event_memory_bytes(large); collect = true) == event_memory_bytes(large)
+        build_event(columns(200), 0; production = zeros(Int, 200), end_vertex = zeros(Int, 200))
+        @test native_memory().gc_collections == gauges.gc_collections + 1
+
+        # So do events read from a file
+        filename = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(filename)
+        HepMC3.writer_write_event(writer, large.cpp_object)
+        HepMC3.writer_write_event(writer, large.cpp_object)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+        events = read_hepmc_file(filename)
+        @test native_memory().gc_collections == gauges.gc_collections + 2
+        release_events!(events)
+        @test native_gc_pressure!(nothing) == event_memory_bytes(large)
+        build_event(columns(200), 0; production = zeros(Int, 200), end_vertex = zeros(Int, 200))
+        @test native_memory().gc_collections == gauges.gc_collections + 2
+        @test_throws ArgumentError native_gc_pressure!(-1)
+    end
+
+    @testset "Batched Lorentz Boosts" begin
+        # Two asymmetric beams and two outgoing particles per event
+        make(k) = build_event((px = [0.0, 0.0, 3.0, -3.0], py = [0.0, 0.0, 1.0, -1.0],
+                               pz = [100.0 + k, -50.0, 20.0 + k, 30.0], e = [100.0 + k, 50.0, 21.0 + k, 31.0],
+                               pdg = [2212, 2212, 211, -211], status = [4, 4, 1, 1]), 1;
+                              production = [0, 0, 1, 1], end_vertex = [1, 1, 0, 0])
+        four(event, i) = (mom = momentum(get_particle_at(event, i)); (px(mom), py(mom), pz(mom), e(mom)))
+        mass2(p) = p[4]^2 - p[1]^2 - p[2]^2 - p[3]^2
+        events = [make(k) for k in 1:5]
+        before = [four(event, i) for event in events, i in 1:4]
+
+        betas = beam_boosts(events)
+        @test size(betas) == (3, 5)
+        @test betas[:, 2] ≈ [0.0, 0.0, -52.0 / 152.0]
+        boost_to_beam_frame!(events; threads = 2)
+        for (k, event) in enumerate(events)
+            @test four(event, 1)[3] + four(event, 2)[3] ≈ 0.0 atol = 1e-9
+            @test mass2(four(event, 3)) ≈ mass2(before[k, 3])
+        end
+
+        # The same transform on columns, rows grouped by event
+        rows = [(k, i) for k in 1:5 for i in 1:4]
+        columns = (px = [before[k, i][1] for (k, i) in rows], py = [before[k, i][2] for (k, i) in rows],
+                   pz = [before[k, i][3] for (k, i) in rows], e = [before[k, i][4] for (k, i) in rows],
+                   event = [k for (k, _) in rows])
+        boost_columns!(columns, [Tuple(betas[:, k]) for k in 1:5])
+        for (row, (k, i)) in enumerate(rows)
+            @test collect(four(events[k], i)) ≈ [columns.px[row], columns.py[row], columns.pz[row], columns.e[row]] atol = 1e-9
+        end
+
+        # Boosting back restores the momenta
+        boost_events!(events, -betas)
+        @test all(collect(four(events[k], i)) ≈ collect(before[k, i]) for k in 1:5, i in 1:4)
+
+        # One velocity for every event; events without rows are skipped
+        px_, py_, pz_, e_ = [0.0], [0.0], [0.0], [1.0]
+        boost_columns!(px_, py_, pz_, e_, [3], (0.0, 0.0, 0.6))
+        @test pz_[1] ≈ 0.75 && e_[1] ≈ 1.25
+
+        @test_throws Exception boost_events!(events, (0.0, 0.0, 1.0))
+        @test_throws ArgumentError boost_columns!([0.0, 0.0], [0.0, 0.0], [0.0, 0.0], [1.0, 1.0], [2, 1], zeros(3, 2))
+        @test_throws DimensionMismatch boost_events!(events, zeros(3, 4))
+        @test_throws Exception beam_boosts(events; partonic = true)    # no GenPdfInfo
+
+        # Partonic rest frame from the GenPdfInfo momentum fractions
+        add_pdf_info!(events[1], 2, 1, 0.1, 0.2, 100.0, 0.5, 0.5, 0, 0)
+        @test beam_boosts(events[1:1]; partonic = true)[:, 1] ≈ [0.0, 0.0, -0.1 / 20.1] atol = 1e-12
+    end
+    @testset "Pair Kernels" begin
+        event = build_event((px = [0.0, 0.0, 10.0, -12.0, 3.0, 40.0], py = [0.0, 0.0, 5.0, 1.0, -30.0, 0.5],
+                             pz = [100.0, -100.0, 20.0, -5.0, 8.0, 60.0], e = [100.0, 100.0, 23.0, 13.5, 32.0, 73.0],
+                             pdg = [2212, 2212, 11, -11, 22, 211], status = [4, 4, 1, 1, 1, 1]), 1;
+                            production = [0, 0, 1, 1, 1, 1], end_vertex = [1, 1, 0, 0, 0, 0])
+        selected = select_momenta(event; status = 1)
+        @test selected.ids == [3, 4, 5, 6]
+        @test select_momenta(event; status = 1, pdg = [11]).ids == [3, 4]
+        @test select_momenta(event; status = 1, pt_min = 20.0).ids == [5, 6]
+        p = selected.momenta
+        n = length(p)
+
+        dr = pair_matrix(p)
+        mass = pair_matrix(p; quantity = :mass)
+        @test length(dr) == n * (n - 1) ÷ 2
+        for i in 1:n, j in i+1:n
+            @test dr[pair_index(n, i, j)] ≈ delta_r_eta(p[i], p[j])
+            @test pair_matrix(p; quantity = :delta_r_rap)[pair_index(n, j, i)] ≈ delta_r_rap(p[i], p[j])
+            @test mass[pair_index(n, i, j)] ≈ m(p[i] + p[j])
+        end
+        columns = (px = px.(p), py = py.(p), pz = pz.(p), e = e.(p))
+        @test pair_matrix(columns) == dr
+
+        close = find_pairs(p; below = 2.0)
+        @test [(i, j) for (i, j) in zip(close.first, close.second)] ==
+              [(i, j) for i in 1:n for j in i+1:n if dr[pair_index(n, i, j)] < 2.0]
+        @test close.value ≈ [delta_r_eta(p[i], p[j]) for (i, j) in zip(close.first, close.second)]
+        window = find_pairs(columns; quantity = :mass, above = 20.0, below = 60.0)
+        @test all(20.0 .< window.value .< 60.0)
+        @test length(window.value) == count(x -> 20.0 < x < 60.0, mass)
+
+        # Large inputs are split over threads with the same result
+        many = [LorentzVector(20 * sin(k), 20 * cos(3k), 50 * sin(7k), 80.0 + k % 13) for k in 1:700]
+        @test pair_matrix(many; threads = 4) == pair_matrix(many; threads = 1)
+        @test pair_matrix(many; threads = 4)[pair_index(700, 123, 456)] ≈ delta_r_eta(many[123], many[456])
+        far = find_pairs(many; quantity = :mass, above = 150.0, threads = 4)
+        @test far == find_pairs(many; quantity = :mass, above = 150.0, threads = 1)
+        @test issorted(collect(zip(far.first, far.second)))
+
+        @test isempty(pair_matrix(LorentzVector[]))
+        @test isempty(find_pairs(p[1:1]).value)
+        @test_throws ArgumentError pair_matrix(p; quantity = :angle)
+        @test_throws ArgumentError pair_index(n, 2, 2)
+    end
+end
@@ -115,4 +115,627 @@
         rm(filename)
     end
     
+
+    @testset "Asynchronous Writer" begin
+        function build_async_event(i)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        serial_file = tempname() * ".hepmc3"
+        async_file = tempname() * ".hepmc3"
+        events = [build_async_event(i) for i in 1:20]
+
+        writer = HepMC3.create_writer_ascii(serial_file)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), events)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        writer = async_writer(async_file; capacity = 4)
+        for event in events
+            write_event(writer, event)
+        end
+        flush(writer)
+        @test writer_stats(writer) == (written = 20, queued = 0)
+        # The events are in the file, not only in the stream buffer
+        flushed = read(async_file, String)
+        @test count(line -> startswith(line, "E "), split(flushed, '\n')) == 20
+        @test startswith(read(serial_file, String), flushed)
+        close(writer)
+        close(writer)
+        @test read(async_file) == read(serial_file)
+        @test_throws ErrorException write_event(writer, events[1])
+
+        # Events from read_hepmc_file can be queued without a snapshot
+        copy_file = tempname() * ".hepmc3"
+        writer = async_writer(copy_file)
+        for event_ptr in read_hepmc_file(serial_file)
+            write_event(writer, event_ptr; copy = false)
+        end
+        @test_throws ArgumentError write_event(writer, events[1]; copy = false)
+        close(writer)
+        copied = read_hepmc_file(copy_file)
+        @test length(copied) == 20
+        @test all(events_equal(a, b) for (a, b) in zip(events, copied))
+
+        @test_throws ErrorException async_writer(joinpath(tempname(), "missing", "event.hepmc3"))
+
+        rm(serial_file)
+        rm(async_file)
+        rm(copy_file)
+    end
+
+    @testset "Parallel Writer" begin
+        run_info = create_run_info()
+        set_weight_names!(run_info, ["nominal", "alt"])
+        add_tool_info!(run_info, "UnitTestGenerator", "1.0", "parallel writer test")
+
+        function build_parallel_event(i; with_run_info = true)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            with_run_info && set_run_info!(event, run_info)
+            set_event_weights!(event, [1.0, 0.5 * i])
+            beam = make_shared_particle(0.0, 0.0, 6500.0, 6500.0, 2212, 4)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, beam)
+            for k in 1:(1 + i % 7)
+                connect_particle_out(vertex, make_shared_particle(0.1 * k, -0.2 * i, 1.0 / k, 3.0 + k, 211, 1))
+            end
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        # The first event has no run info: like WriterAscii, the parallel writer writes
+        # an empty run info block before it and none for the later events
+        events = [build_parallel_event(i; with_run_info = i > 1) for i in 1:200]
+
+        serial_file = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(serial_file)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), events)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        parallel_file = tempname() * ".hepmc3"
+        writer = parallel_writer(parallel_file; threads = 4, capacity = 8)
+        foreach(event -> write_event(writer, event), events)
+        flush(writer)
+        stats = writer_stats(writer)
+        @test stats.written == 200
+        @test stats.queued == 0
+        @test stats.bytes > 0
+        flushed = read(parallel_file, String)
+        @test count(line -> startswith(line, "E "), split(flushed, '\n')) == 200
+        close(writer)
+        @test read(parallel_file) == read(serial_file)
+        @test_throws ErrorException write_event(writer, events[1])
+
+        @test_throws ErrorException parallel_writer(joinpath(tempname(), "missing", "event.hepmc3"))
+
+        rm(serial_file)
+        rm(parallel_file)
+    end
+
+    @testset "Compressed Writers" begin
+        events = [create_event(i) for i in 1:50]
+        for (i, event) in enumerate(events)
+            set_units!(event, :GeV, :mm)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, make_shared_particle(0.0, 0.0, 50.0 * i, 50.0 * i, 2212, 4))
+            connect_particle_out(vertex, make_shared_particle(1.0, -1.0, 10.0, 12.0 + i, 211, 1))
+            attach_vertex_to_event(event, vertex)
+        end
+
+        function write_all(writer)
+            foreach(event -> @test(HepMC3.writer_write_event(writer, event.cpp_object)), events)
+            HepMC3.writer_close(writer)
+            HepMC3.delete_writer_ascii(writer)
+        end
+
+        plain_file = tempname() * ".hepmc3"
+        write_all(HepMC3.create_writer_ascii(plain_file))
+        plain = read(plain_file)
+
+        gzip_file = tempname() * ".hepmc3.gz"
+        write_all(create_writer_gzip(gzip_file; level = 9))
+        @test filesize(gzip_file) < length(plain)
+        @test transcode(HepMC3.CodecZlib.GzipDecompressor, read(gzip_file)) == plain
+
+        auto_file = tempname() * ".gz"
+        write_all(create_writer_compressed(auto_file))
+        @test transcode(HepMC3.CodecZlib.GzipDecompressor, read(auto_file)) == plain
+
+        if zstd_compression_available()
+            zstd_file = tempname() * ".hepmc3.zst"
+            write_all(create_writer_zstd(zstd_file; level = 5, threads = 2))
+            @test transcode(HepMC3.CodecZstd.ZstdDecompressor, read(zstd_file)) == plain
+            @test length(read_hepmc_file_with_compression(zstd_file)) == 50
+            rm(zstd_file)
+        else
+            @test_throws ErrorException create_writer_zstd(tempname() * ".zst")
+        end
+
+        @test_throws ErrorException create_writer_gzip(gzip_file; level = 42)
+        @test_throws ErrorException create_writer_gzip(joinpath(tempname(), "missing", "events.gz"))
+
+        rm(plain_file)
+        rm(gzip_file)
+        rm(auto_file)
+    end
+
+    @testset "Sharded Writer" begin
+        events = [create_event(i) for i in 1:25]
+        for (i, event) in enumerate(events)
+            set_units!(event, :GeV, :mm)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, make_shared_particle(0.0, 0.0, 10.0 * i, 10.0 * i, 2212, 4))
+            connect_particle_out(vertex, make_shared_particle(0.5, 0.5, 1.0, 2.0 + i, 211, 1))
+            attach_vertex_to_event(event, vertex)
+        end
+        directory = mktempdir()
+
+        writer = sharded_writer(joinpath(directory, "count_{}.hepmc3"); events_per_shard = 10)
+        foreach(event -> write_event(writer, event), events)
+        shards = close(writer)
+        @test [shard.events for shard in shards] == [10, 10, 5]
+        @test [shard.first for shard in shards] == [0, 10, 20]
+        @test shards[1].file == joinpath(directory, "count_0000.hepmc3")
+        @test shards[3].first_event_number == 21
+        @test shards[3].last_event_number == 25
+        @test all(shard.bytes == filesize(shard.file) for shard in shards)
+        @test isfile(joinpath(directory, "count_manifest.tsv"))
+        @test [event_number(e) for e in read_hepmc_file(shards[2].file)] == collect(11:20)
+
+        writer = sharded_writer(joinpath(directory, "bytes_{}.hepmc3"); bytes_per_shard = 1, capacity = 1)
+        foreach(event -> write_event(writer, event), events[1:4])
+        shards = close(writer)
+        @test sum(shard.events for shard in shards) == 4
+        @test length(shards) >= 2
+
+        writer = sharded_writer(joinpath(directory, "key_{}.hepmc3"); by_key = true, manifest = "")
+        foreach(event -> write_event(writer, event; key = isodd(event_number(event)) ? "odd" : "even"), events)
+        @test isempty(close(writer))
+        @test length(read_hepmc_file(joinpath(directory, "key_odd.hepmc3"))) == 13
+        @test length(read_hepmc_file(joinpath(directory, "key_even.hepmc3"))) == 12
+
+        # Keys that sanitise to the same file name get separate shards
+        writer = sharded_writer(joinpath(directory, "clash_{}.hepmc3"); by_key = true)
+        for (event, key) in zip(events[1:4], ("a/b", "a_b", "", "none"))
+            write_event(writer, event; key)
+        end
+        shards = close(writer)
+        @test [basename(shard.file) for shard in shards] ==
+              ["clash_a_b.hepmc3", "clash_a_b-2.hepmc3", "clash_none.hepmc3", "clash_none-2.hepmc3"]
+        @test [shard.key for shard in shards] == ["a/b", "a_b", "", "none"]
+        @test [event_number(only(read_hepmc_file(shard.file))) for shard in shards] == [1, 2, 3, 4]
+
+        @test_throws ArgumentError sharded_writer(joinpath(directory, "x.hepmc3"); events_per_shard = 10)
+        @test_throws ArgumentError sharded_writer(joinpath(directory, "x_{}.hepmc3"))
+        @test_throws ArgumentError sharded_writer(joinpath(directory, "x_{}.hepmc3"); events_per_shard = 0)
+
+        rm(directory; recursive = true)
+    end
+
+    @testset "Raw Pass-through Filtering" begin
+        function build_raw_event(i)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        input = tempname() * ".hepmc3"
+        output = tempname() * ".hepmc3"
+        events = [build_raw_event(i) for i in 1:10]
+        writer = HepMC3.create_writer_ascii(input)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), events)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        # Accepting everything reproduces the input byte for byte
+        @test filter_events_raw(raw -> true, input, output) == (read = 10, written = 10)
+        @test read(output) == read(input)
+
+        # Accepted events are copied verbatim between the original header and footer
+        seen = Int[]
+        result = filter_events_raw(input, output) do raw
+            push!(seen, raw.event_number)
+            @test raw.n_vertices == 1
+            @test raw.pdg == [2212, 211]
+            @test raw.status == [4, 1]
+            # A single-parent vertex at the origin is written as a particle reference
+            @test raw.parent == [0, 1]
+            @test raw.px[2] ≈ raw.event_number
+            @test raw.e[1] ≈ 100.0 + raw.event_number
+            @test startswith(raw_text(raw), "E $(raw.event_number) ")
+            return iseven(raw.event_number)
+        end
+        @test result == (read = 10, written = 5)
+        @test seen == 1:10
+        chunks = split(read(input, String), r"(?m)^(?=E |HepMC::Asciiv3-END_EVENT_LISTING)")
+        @test read(output, String) == chunks[1] * join(chunks[3:2:end-1]) * chunks[end]
+        filtered = read_hepmc_file(output)
+        @test length(filtered) == 5
+        @test all(events_equal(a, b) for (a, b) in zip(events[2:2:end], filtered))
+
+        # Full parsing on demand
+        parsed = filter_events_raw(input, output; max_events = 3) do raw
+            event = GenEvent()
+            parse_event!(event, raw) && events_equal(event, events[raw.event_number])
+        end
+        @test parsed == (read = 3, written = 3)
+
+        # A run info block between events is copied even when the events
+        # around it are rejected
+        block = "T Rivet\\|4.0.1\\|analysis\n"
+        with_block = replace(read(input, String), "\nE 3 " => "\n" * block * "E 3 ")
+        write(input, with_block)
+        @test filter_events_raw(raw -> raw.event_number != 2, input, output) == (read = 10, written = 9)
+        @test read(output, String) == replace(with_block, chunks[3] => "")
+        @test filter_events_raw(raw -> false, input, output) == (read = 10, written = 0)
+        @test read(output, String) == chunks[1] * block * chunks[end]
+        parsed = filter_events_raw(input, output) do raw
+            raw.event_number == 3 || return false
+            @test !occursin("Rivet", raw_text(raw))
+            event = GenEvent()
+            parse_event!(event, raw) && events_equal(event, events[3])
+        end
+        @test parsed == (read = 10, written = 1)
+
+        @test_throws ArgumentError filter_events_raw(raw -> true, tempname(), output)
+
+        rm(input)
+        rm(output)
+    end
+
+    @testset "Parallel Event Engine" begin
+        function build_engine_event(i)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        events = [build_engine_event(i) for i in 1:10]
+        filename = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(filename)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), events)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        # Rows come back in event order whatever the thread and chunk layout
+        pions = run_engine(filename; status = 1, threads = 3, chunk_size = 3)
+        @test pions.event == 1:10
+        @test pions.pt ≈ [hypot(i, 2.0) for i in 1:10]
+        @test all(==(211), pions.pdg)
+        @test all(==(1), pions.status)
+        @test run_engine(events; status = 1, threads = 2, chunk_size = 1) == pions
+        @test run_engine(read_hepmc_file(filename); status = 1, threads = 4) == pions
+
+        all_particles = run_engine(events; threads = 2)
+        @test all_particles.event == repeat(1:10; inner = 2)
+        @test all_particles.pdg == repeat([2212, 211], 10)
+
+        @test run_engine(filename; pdg = [-211], pt_min = 5.0).event == 5:10
+        @test isempty(run_engine(filename; pdg = [11]).pt)
+        @test run_engine(filename; status = 1, max_events = 4).event == 1:4
+
+        summary = run_engine(filename; kernel = :events, pdg = [211], threads = 2, chunk_size = 4)
+        @test summary.event_number == 1:10
+        @test summary.n_selected == ones(Int, 10)
+        @test summary.ht ≈ summary.leading_pt
+        @test summary.ht ≈ [hypot(i, 2.0) for i in 1:10]
+        @test summary.weight == ones(10)
+
+        @test_throws ErrorException run_engine(filename; kernel = :no_such_kernel)
+        @test_throws ArgumentError run_engine(tempname())
+
+        @testset "Histograms" begin
+            # Pion pt is hypot(i, 2) and its energy 10 + i for event i
+            h = fill_histograms(filename; status = 1, threads = 3, chunk_size = 2,
+                                histograms = (pt = (:pt, 0:2:10), ht = (:ht, [0.0, 5.0, 20.0]),
+                                              pt_e = ((:pt, 0:5:10), (:e, 10:5:25))))
+            @test h.pt.edges == collect(0.0:2.0:10.0)
+            @test h.pt.sumw == [0, 3, 2, 2, 2]
+            @test h.pt.sumw2 == h.pt.sumw
+            @test (h.pt.underflow, h.pt.overflow, h.pt.entries) == (0, 1, 10)
+            @test h.ht.sumw == [4, 6]
+            @test h.pt_e.sumw == [4 0 0; 0 5 0]
+            @test h.pt_e.outside == 1
+            @test h.pt_e.entries == 10
+
+            # Event weights, from an in-memory batch
+            for (i, event) in enumerate(events)
+                set_event_weights!(event, [Float64(i), 1.0])
+            end
+            weighted = fill_histograms(events; status = 1, weight = 1, threads = 2, chunk_size = 1,
+                                       histograms = (ht = (:ht, [0.0, 5.0, 20.0]),))
+            @test weighted.ht.sumw ≈ [10, 45]
+            @test weighted.ht.sumw2 ≈ [30, 355]
+            @test fill_histograms(events; status = 1, weight = 2,
+                                  histograms = (ht = (:ht, [0.0, 5.0, 20.0]),)).ht.sumw ≈ [4, 6]
+
+            @test_throws ErrorException fill_histograms(events; weight = 3, histograms = (pt = (:pt, 0:1:5),))
+            @test_throws ArgumentError fill_histograms(events; histograms = (x = (:charge, 0:1:5),))
+        end
+
+        rm(filename)
+    end
+
+    @testset "Event Pipeline" begin
+        function build_pipeline_event(i)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        input = tempname() * ".hepmc3"
+        output = tempname() * ".hepmc3"
+        events = [build_pipeline_event(i) for i in 1:10]
+        writer = HepMC3.create_writer_ascii(input)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), events)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        # Small queues and several filter and extract threads still keep the read order
+        writer = HepMC3.create_writer_ascii(output)
+        pipeline = event_pipeline(input; writer, kernel = :particles, status = 1, pt_min = 5.0, min_selected = 1,
+                                  filter_threads = 3, extract_threads = 2, capacity = 2)
+        result = wait(pipeline)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+        @test (result.read, result.accepted) == (10, 6)
+        @test result.columns.event == 5:10
+        @test result.columns.pt ≈ [hypot(i, 2.0) for i in 5:10]
+        selected = read_hepmc_file(output)
+        @test length(selected) == 6
+        @test all(events_equal(a, b) for (a, b) in zip(events[5:10], selected))
+        @test_throws ErrorException pipeline_stats(pipeline)
+        @test_throws ErrorException wait(pipeline)
+
+        # Reader handles as source; counters after the run
+        reader = HepMC3.create_reader_ascii(input)
+        pipeline = event_pipeline(reader; status = 1, max_selected = 0, pt_min = 9.0, max_events = 8)
+        while pipeline_stats(pipeline).running
+            sleep(0.001)
+        end
+        stats = pipeline_stats(pipeline)
+        @test (stats.source.out, stats.filter.in, stats.filter.out, stats.sink.out) == (8, 8, 8, 8)
+        @test stats.extract.in == 0
+        @test stats.queued == (filter = 0, extract = 0, sink = 0)
+        @test wait(pipeline) == (read = 8, accepted = 8, columns = nothing)
+        HepMC3.delete_reader_ascii(reader)
+
+        @test_throws ArgumentError event_pipeline(tempname())
+
+        rm(input)
+        rm(output)
+    end
+
+    @testset "Event Pool" begin
+        function build_pooled_event(i)
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            return event
+        end
+
+        filename = tempname() * ".hepmc3"
+        originals = [build_pooled_event(i) for i in 1:10]
+        writer = HepMC3.create_writer_ascii(filename)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), originals)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        pool = EventPool(; max_idle = 4)
+        events = read_hepmc_file(filename; pool)
+        @test length(events) == 10
+        @test all(events_equal(a, b) for (a, b) in zip(originals, events))
+        @test pool_stats(pool).hits == 0
+
+        # Only max_idle released events are kept
+        release_events!(events)
+        @test isempty(events)
+        stats = pool_stats(pool)
+        @test stats.idle == 4
+        @test stats.discarded >= 6
+
+        # Recycled events are cleared before they are filled again
+        events = read_hepmc_file(filename; pool, max_events = 3)
+        @test pool_stats(pool).hits == 3
+        @test all(events_equal(a, b) for (a, b) in zip(originals, events))
+        release_events!(events)
+
+        # Steady-state reading allocates no events
+        misses = pool_stats(pool).misses
+        reader = HepMC3.create_reader_ascii(filename)
+        n = 0
+        while (event = read_pooled_event(reader, pool)) !== nothing
+            n += 1
+            @test event_number(event) == n
+            release_event!(event)
+        end
+        HepMC3.delete_reader_ascii(reader)
+        @test n == 10
+        @test pool_stats(pool).misses == misses
+
+        event = acquire_event(pool)
+        @test particles_size(event) == 0
+        release_event!(event)
+
+        # Events may outlive their pool
+        events = read_hepmc_file(filename; pool, max_events = 2)
+        finalize(pool)
+        @test_throws ErrorException pool_stats(pool)
+        @test length(release_events!(events)) == 0
+
+        rm(filename)
+    end
+
+    @testset "Event Store" begin
+        filename = tempname() * ".hepmc3"
+        originals = map(1:10) do i
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            add_particle_attribute!(outgoing, "flow1", 500 + i)
+            event
+        end
+        writer = HepMC3.create_writer_ascii(filename)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), originals)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        store = EventStore(filename)
+        @test length(store) == 10
+        @test store_stats(store).particles == 20
+        for i in (1, 5, 10)
+            event = store[i]
+            @test event_number(event) == i
+            @test events_equal(originals[i], event)
+            @test event_attributes(event).value == [string(500 + i)]
+            release_event!(event)
+        end
+        @test_throws BoundsError store[11]
+
+        # Lookup by event number, also after out-of-order additions
+        @test find_event(store, 7) == 7
+        @test find_event(store, 99) === nothing
+        push!(store, originals[3])
+        @test length(store) == 11
+        @test find_event(store, 3) == 3
+        event = materialize_event(store, 11; arena = true)
+        @test events_equal(originals[3], event)
+        release_event!(event)
+
+        # Every event keeps its own run info
+        run_info = create_run_info()
+        set_weight_names!(run_info, ["nominal", "alt"])
+        set_run_info!(originals[4], run_info)
+        push!(store, originals[4])
+        event = store[12]
+        @test get_weight_names(HepMC3.get_event_run_info(HepMC3._event_pointer(event))) == ["nominal", "alt"]
+        release_event!(event)
+        event = store[1]
+        run_info = HepMC3.get_event_run_info(HepMC3._event_pointer(event))
+        @test run_info == C_NULL || isempty(get_weight_names(run_info))
+        release_event!(event)
+
+        single = EventStore(filename; float32 = true, max_events = 5)
+        @test length(single) == 5
+        @test store_stats(single).bytes < store_stats(EventStore(filename; max_events = 5)).bytes
+        event = single[2]
+        @test events_equal(originals[2], event; tolerance = 1e-6)
+        release_event!(event)
+
+        @test_throws ArgumentError EventStore(tempname() * ".hepmc3")
+    end
+
+    @testset "Event Cache" begin
+        filename = tempname() * ".hepmc3"
+        originals = map(1:10) do i
+            event = create_event(i)
+            set_units!(event, :GeV, :mm)
+            incoming = make_shared_particle(0.0, 0.0, 100.0 + i, 100.0 + i, 2212, 4)
+            outgoing = make_shared_particle(1.0 * i, 2.0, 3.0, 10.0 + i, 211, 1)
+            vertex = make_shared_vertex()
+            connect_particle_in(vertex, incoming)
+            connect_particle_out(vertex, outgoing)
+            attach_vertex_to_event(event, vertex)
+            event
+        end
+        writer = HepMC3.create_writer_ascii(filename)
+        foreach(event -> HepMC3.writer_write_event(writer, event.cpp_object), originals)
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        # Room for three events
+        events = read_hepmc_file(filename; max_events = 1)
+        budget = 3 * event_memory_bytes(events[1]) + 16
+        release_events!(events)
+        scratch = tempname()
+        cache = EventCache(filename; budget_bytes = budget, scratch)
+        event = cache[10]
+        @test events_equal(originals[10], event)
+        release_event!(event)
+        stats = cache_stats(cache)
+        @test stats.misses == 1
+        @test stats.reads == 10
+        @test stats.events == 3 && stats.bytes <= budget
+        @test stats.spills == 7
+        @test isfile(scratch)
+
+        event = cache[10]
+        release_event!(event)
+        @test cache_stats(cache).hits == 1
+        for i in 1:5
+            event = cache[i]
+            @test events_equal(originals[i], event)
+            release_event!(event)
+        end
+        stats = cache_stats(cache)
+        @test stats.disk_hits == 5
+        @test stats.reads == 10
+        @test stats.hit_rate ≈ 1 / 7
+        @test stats.spills == 10   # events read back are not written again
+
+        # Hits share the cached event; copies can be changed without
+        # touching it
+        a, b = cache[1], cache[1]
+        @test HepMC3._event_pointer(a) == HepMC3._event_pointer(b)
+        release_events!([a, b])
+        event = cached_event(cache, 1; copy = true)
+        boost_events!([event], (0.0, 0.0, 0.5))
+        @test !events_equal(originals[1], event)
+        release_event!(event)
+        event = cache[1]
+        @test events_equal(originals[1], event)
+        release_event!(event)
+        @test_throws BoundsError cache[11]
+        close(cache)
+        @test !isfile(scratch)
+
+        # Over an event store, evicted events are materialised again
+        cache = EventCache(EventStore(filename); budget_bytes = budget)
+        for i in (1, 2, 1, 9, 1)
+            event = cache[i]
+            @test event_number(event) == i
+            release_event!(event)
+        end
+        stats = cache_stats(cache)
+        @test (stats.hits, stats.misses, stats.disk_hits, stats.spills) == (2, 3, 0, 0)
+        @test_throws ArgumentError EventCache(tempname())
+    end
 end
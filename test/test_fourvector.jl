@@ -58,4 +58,55 @@
         @test pz(neg_v) ≈ -30.0
         @test e(neg_v) ≈ 40.0
     end
-end
\ No newline at end of file
+
+    @testset "LorentzVector Mirror" begin
+        @test isbitstype(LorentzVector)
+        @test sizeof(LorentzVector) == 4 * sizeof(Float64)
+
+        # Same results as the C++ FourVector methods
+        vectors = [(25.0, 15.0, 50.0, 60.0), (-10.0, 20.0, -30.0, 40.0), (1.0, -2.0, 0.5, 1.0),
+                   (0.0, 0.0, 5.0, 5.0), (0.0, 0.0, -5.0, 7.0), (0.0, 0.0, 0.0, 0.0), (3.0, -4.0, 0.0, 0.0)]
+        for a in vectors, b in vectors
+            va, vb = FourVector(a...), FourVector(b...)
+            la, lb = LorentzVector(a...), LorentzVector(b...)
+            @test LorentzVector(va) == la
+            for f in (px, py, pz, e, HepMC3.x, HepMC3.y, HepMC3.z, HepMC3.t, m, m2, perp, perp2, pt, pt2, eta, abs_eta, rap, abs_rap,
+                      phi, theta, p3mod, p3mod2, rho, length2, interval, is_zero)
+                @test f(la) === f(va) || f(la) ≈ f(va)
+            end
+            for f in (delta_phi, delta_eta, delta_rap, delta_r_eta, delta_r2_eta, delta_r_rap, delta_r2_rap)
+                @test isequal(f(la, lb), f(va, vb)) || f(la, lb) ≈ f(va, vb)
+            end
+        end
+        @test eta(LorentzVector(0.0, 0.0, -5.0, 7.0)) == -Inf
+        @test m(LorentzVector(3.0, 4.0, 0.0, 0.0)) == -5.0
+        @test -π <= delta_phi(LorentzVector(-1.0, 0.01, 0.0, 1.0), LorentzVector(-1.0, -0.01, 0.0, 1.0)) < π
+
+        # Arithmetic and conversion back to FourVector
+        l1, l2 = LorentzVector(1, 2, 3, 10), LorentzVector(-1, 0, 3, 5)
+        @test l1 + l2 == LorentzVector(0.0, 2.0, 6.0, 15.0)
+        @test 2 * l1 - l1 == l1
+        @test l1 / 2 ≈ LorentzVector(0.5, 1.0, 1.5, 5.0)
+        @test !(l1 ≈ l1 + LorentzVector(0.0, 0.0, 0.0, 1e-3))
+        @test isapprox(l1, l1 + LorentzVector(0.0, 0.0, 0.0, 1e-3); atol = 1e-2)
+        @test isapprox(LorentzVector(NaN, 0, 0, 1), LorentzVector(NaN, 0, 0, 1); nans = true)
+        @test !(LorentzVector(Inf, 0, 0, 1) ≈ LorentzVector(Inf, 0, 0, 2))
+        approx_allocations(a, b) = @allocated isapprox(a, b)
+        approx_allocations(l1, l2)
+        @test approx_allocations(l1, l2) == 0
+        @test px(FourVector(l1)) == 1.0 && e(FourVector(l1)) == 10.0
+        @test pt.([l1, l2]) ≈ [sqrt(5.0), 1.0]
+
+        # Whole events in one call
+        event = build_event((px = [0.0, 3.0, -3.0], py = [0.0, 4.0, -4.0], pz = [100.0, 40.0, 60.0],
+                             e = [100.0, 41.0, 61.0], pdg = [2212, 211, -211], status = [4, 1, 1]),
+                            (x = [1.0], y = [2.0], z = [3.0], t = [4.0]);
+                            production = [0, 1, 1], end_vertex = [1, 0, 0])
+        momenta = event_momenta(event)
+        @test momenta isa Vector{LorentzVector}
+        @test momenta == [LorentzVector(momentum(get_particle_at(event, i))) for i in 1:3]
+        @test m(momenta[2] + momenta[3]) ≈ m(FourVector(0.0, 0.0, 100.0, 102.0))
+        @test event_positions(event) == [LorentzVector(1.0, 2.0, 3.0, 4.0)]
+        @test isempty(event_momenta(create_event()))
+    end
+end
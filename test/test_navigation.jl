@@ -90,4 +90,184 @@ using HepMC3
         ancestry = find_particle_ancestry(p1)
         @test isa(ancestry, Vector)
     end
-end
\ No newline at end of file
+
+    @testset "Native Flat Traversal" begin
+        # Two beams annihilate at a shared vertex: b1, b2 -> v1 -> Z -> v2 -> (e-, e+),
+        # and the electron radiates: e- -> v3 -> (e-, γ)
+        event = create_event(1)
+        b1 = make_shared_particle(0.0, 0.0, 45.0, 45.0, 11, 4)
+        b2 = make_shared_particle(0.0, 0.0, -45.0, 45.0, -11, 4)
+        z = make_shared_particle(0.0, 0.0, 0.0, 90.0, 23, 2)
+        em = make_shared_particle(10.0, 0.0, 20.0, 25.0, 11, 2)
+        ep = make_shared_particle(-10.0, 0.0, -20.0, 25.0, -11, 1)
+        em_final = make_shared_particle(8.0, 0.0, 18.0, 21.0, 11, 1)
+        gamma = make_shared_particle(2.0, 0.0, 2.0, 4.0, 22, 1)
+
+        v1 = make_shared_vertex()
+        connect_particle_in(v1, b1)
+        connect_particle_in(v1, b2)
+        connect_particle_out(v1, z)
+        v2 = make_shared_vertex()
+        connect_particle_in(v2, z)
+        connect_particle_out(v2, em)
+        connect_particle_out(v2, ep)
+        v3 = make_shared_vertex()
+        connect_particle_in(v3, em)
+        connect_particle_out(v3, em_final)
+        connect_particle_out(v3, gamma)
+        for v in (v1, v2, v3)
+            attach_vertex_to_event(event, v)
+        end
+
+        chain = traverse_decay_chain_flat(b1; with_particles=true)
+        @test length(chain.ids) == 5
+        @test chain.depths == Int32[1, 2, 2, 3, 3]
+        @test chain.parents == Int32[0, 1, 1, 2, 2]
+        @test all(chain.ids .> 0)
+        @test chain.particles[1] == z
+        @test get_particle_properties(chain.particles[end]).pdg_id == 22
+        @test length(traverse_decay_chain_flat(b2).ids) == 5
+
+        shallow = traverse_decay_chain_flat(b1; max_depth=2)
+        @test shallow.depths == Int32[1, 2, 2]
+        @test isempty(shallow.particles)
+
+        ancestry = find_particle_ancestry_flat(gamma)
+        @test ancestry.depths == Int32[1, 2, 3, 3]
+        @test ancestry.parents == Int32[0, 1, 2, 2]
+        @test sort(ancestry.ids) == sort([get_particle_id(p) for p in (em, z, b1, b2)])
+
+        @test isempty(traverse_decay_chain_flat(gamma).ids)
+        @test isempty(find_particle_ancestry_flat(b1).ids)
+    end
+
+    @testset "Event Graph Queries" begin
+        # p -> v1 -> (b, γ); b -> v2 -> B0; B0 -> v3 -> (D0, μ); D0 -> v4 -> (K, π)
+        event = create_event(2)
+        proton = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+        bquark = make_shared_particle(1.0, 0.0, 50.0, 51.0, 5, 2)
+        photon = make_shared_particle(-1.0, 0.0, 10.0, 11.0, 22, 1)
+        bmeson = make_shared_particle(1.0, 0.0, 45.0, 46.0, 511, 2)
+        dmeson = make_shared_particle(0.5, 0.0, 30.0, 31.0, 421, 2)
+        muon = make_shared_particle(0.5, 0.0, 15.0, 15.5, 13, 1)
+        kaon = make_shared_particle(0.2, 0.0, 20.0, 20.5, -321, 1)
+        pion = make_shared_particle(0.3, 0.0, 10.0, 10.5, 211, 1)
+
+        vertices = [make_shared_vertex() for _ in 1:4]
+        for (v, incoming, outgoing) in zip(vertices,
+                                           [[proton], [bquark], [bmeson], [dmeson]],
+                                           [[bquark, photon], [bmeson], [dmeson, muon], [kaon, pion]])
+            foreach(p -> connect_particle_in(v, p), incoming)
+            foreach(p -> connect_particle_out(v, p), outgoing)
+            attach_vertex_to_event(event, v)
+        end
+        idof(p) = get_particle_id(p)
+
+        query = event_graph_query(event)
+        @test is_ancestor(query, bmeson, kaon)
+        @test is_ancestor(query, idof(proton), idof(pion))
+        @test !is_ancestor(query, kaon, bmeson)
+        @test !is_ancestor(query, photon, muon)
+        @test !is_ancestor(query, muon, kaon)
+
+        @test sort(descendants(query, bquark)) == sort(idof.([bmeson, dmeson, muon, kaon, pion]))
+        @test isempty(descendants(query, pion))
+        @test sort(ancestors(query, kaon)) == sort(idof.([dmeson, bmeson, bquark, proton]))
+        @test isempty(ancestors(query, proton))
+
+        b_hadrons = [511, 521, 531, 5122]
+        @test ancestors_matching(query, kaon, b_hadrons) == [idof(bmeson)]
+        @test ancestors_matching(query, muon, [-511]) == [idof(bmeson)]
+        @test isempty(ancestors_matching(query, muon, [-511]; abs_pdg=false))
+        @test isempty(ancestors_matching(query, photon, b_hadrons))
+        @test ancestors_matching(query, pion, [5, 2212]) == sort(idof.([proton, bquark]))
+
+        close(query)
+        @test_throws ErrorException is_ancestor(query, kaon, pion)
+    end
+
+    @testset "Event Topology" begin
+        # p -> va -> q -> vb -> (r, s); r -> vc -> t, stored in reverse order
+        event = create_event(3)
+        p = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+        q = make_shared_particle(0.0, 0.0, 50.0, 50.0, 21, 2)
+        r = make_shared_particle(1.0, 0.0, 30.0, 30.1, 1, 2)
+        s = make_shared_particle(-1.0, 0.0, 20.0, 20.1, -1, 1)
+        t = make_shared_particle(1.0, 0.0, 29.0, 29.1, 211, 1)
+        va, vb, vc = make_shared_vertex(), make_shared_vertex(), make_shared_vertex()
+        connect_particle_in(va, p); connect_particle_out(va, q)
+        connect_particle_in(vb, q); connect_particle_out(vb, r); connect_particle_out(vb, s)
+        connect_particle_in(vc, r); connect_particle_out(vc, t)
+        for v in (vc, vb, va)
+            attach_vertex_to_event(event, v)
+        end
+
+        query = event_graph_query(event)
+        topology = event_topology(query)
+        @test topology.vertex_order == Int32[3, 2, 1]
+        @test topology.vertex_depths == Int32[2, 1, 0]
+        @test topology.is_root == [false, false, true]
+        @test topology.is_leaf == [true, false, false]
+        @test !any(topology.is_cyclic)
+        @test topological_particle_order(query) ==
+              Int32[get_particle_id(x) for x in (p, q, r, s, t)]
+
+        # Adding a vertex is picked up without rebuilding the query by hand
+        u = make_shared_particle(0.5, 0.0, 10.0, 10.1, 22, 1)
+        vd = make_shared_vertex()
+        connect_particle_in(vd, t)
+        connect_particle_out(vd, u)
+        attach_vertex_to_event(event, vd)
+        @test topological_vertex_order(query) == Int32[3, 2, 1, 4]
+        @test event_topology(query).vertex_depths[4] == 3
+        @test is_ancestor(query, p, u)
+
+        # So is relinking existing particles, which leaves the sizes alone
+        @test !is_ancestor(query, s, u)
+        connect_particle_in(vd, s)
+        @test is_ancestor(query, s, u)
+        @test get_particle_id(s) in ancestors(query, u)
+        @test invalidate!(query) === query
+        @test length(topological_particle_order(query)) == 6
+    end
+
+    @testset "Arena-allocated Events" begin
+        # b1, b2 -> v1 -> Z -> v2 -> (e-, e+); e- -> v3 -> (e-, γ)
+        particles = (px = [0.0, 0.0, 0.0, 10.0, -10.0, 8.0, 2.0], py = zeros(7),
+                     pz = [45.0, -45.0, 0.0, 20.0, -20.0, 18.0, 2.0],
+                     e = [45.0, 45.0, 90.0, 25.0, 25.0, 21.0, 4.0],
+                     pdg = [11, -11, 23, 11, -11, 11, 22], status = [4, 4, 2, 2, 1, 1, 1])
+        links = (production = [0, 0, 1, 2, 2, 3, 3], end_vertex = [1, 1, 2, 3, 0, 0, 0])
+        heap = build_event(particles, 3; links...)
+        arena = build_event(particles, 3; links..., arena=true)
+        @test events_equal(heap, arena)
+
+        for event in (heap, arena)
+            chain = traverse_decay_chain_flat(get_particle_at(event, 1))
+            @test chain.ids == Int32[3, 4, 5, 6, 7]
+            @test chain.depths == Int32[1, 2, 2, 3, 3]
+            @test find_particle_ancestry_flat(get_particle_at(event, 7)).ids[1] == 4
+            @test get_parent_particles(get_particle_at(event, 6)) == [get_particle_at(event, 4)]
+            @test length(get_sibling_particles(get_particle_at(event, 4))) == 1
+            query = event_graph_query(event)
+            @test is_ancestor(query, 1, 7)
+            @test sort(descendants(query, 4)) == Int32[6, 7]
+        end
+
+        # Compacting an event built from shared particles keeps its content and ids
+        event = create_event(4)
+        p = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+        q = make_shared_particle(1.0, 0.0, 50.0, 50.1, 21, 1)
+        v = make_shared_vertex()
+        connect_particle_in(v, p)
+        connect_particle_out(v, q)
+        attach_vertex_to_event(event, v)
+        before = event_fingerprint(event)
+        @test compact_event!(event) === event
+        @test event_fingerprint(event) == before
+        @test particles_size(event) == 2 && vertices_size(event) == 1
+        @test get_decay_products(get_particle_at(event, 1)) == [get_particle_at(event, 2)]
+        @test compact_event!(event) === event    # already compact events can be rebuilt
+        @test event_fingerprint(event) == before
+    end
+end
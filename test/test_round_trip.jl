@@ -46,6 +46,8 @@
         @test get_event_weights(read_event) == [1.0, 0.5, 2.0]
         @test get_weight_names(read_event) == ["nominal", "down", "up"]
         @test weight_index(read_event, "up") == 2
+        @test events_equal(event, read_event)
+        @test event_fingerprint(event) == event_fingerprint(read_event)
 
         rm(filename)
     end
@@ -86,4 +88,75 @@
         @test !HepMC3.writer_write_event(writer, create_event(1).cpp_object)
         HepMC3.delete_writer_ascii(writer)
     end
+
+    @testset "Event Fingerprints" begin
+        # beam -> v1 -> (a, b); a -> v2 -> (c, d), optionally built in reverse order
+        function build_decay_event(; reversed = false, c_energy = 30.0, c_pdg = 211)
+            event = create_event(reversed ? 2 : 1)
+            beam = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+            a = make_shared_particle(5.0, 0.0, 60.0, 61.0, 23, 2)
+            b = make_shared_particle(-5.0, 0.0, 40.0, 39.0, 21, 1)
+            c = make_shared_particle(2.0, 1.0, 29.0, c_energy, c_pdg, 1)
+            d = make_shared_particle(3.0, -1.0, 31.0, 31.0, -211, 1)
+            v1 = make_shared_vertex()
+            v2 = make_shared_vertex()
+            connect_particle_in(v1, beam)
+            connect_particle_in(v2, a)
+            if reversed
+                connect_particle_out(v2, d)
+                connect_particle_out(v2, c)
+                connect_particle_out(v1, b)
+                connect_particle_out(v1, a)
+                attach_vertex_to_event(event, v2)
+                attach_vertex_to_event(event, v1)
+            else
+                connect_particle_out(v1, a)
+                connect_particle_out(v1, b)
+                connect_particle_out(v2, c)
+                connect_particle_out(v2, d)
+                attach_vertex_to_event(event, v1)
+                attach_vertex_to_event(event, v2)
+            end
+            return event
+        end
+
+        event = build_decay_event()
+        reordered = build_decay_event(reversed = true)
+        @test event_fingerprint(event) isa UInt128
+        @test event_fingerprint(event) == event_fingerprint(reordered)
+        @test events_equal(event, reordered)
+
+        shifted = build_decay_event(c_energy = 30.0 + 1e-3)
+        @test event_fingerprint(event) != event_fingerprint(shifted)
+        @test event_fingerprint(event; precision = 0) == event_fingerprint(shifted; precision = 0)
+        @test !events_equal(event, shifted)
+        @test events_equal(event, shifted; tolerance = 1e-4)
+
+        # NaN and out-of-range momenta hash to fixed values of their own
+        nan_event = build_decay_event(c_energy = NaN)
+        @test event_fingerprint(nan_event) == event_fingerprint(build_decay_event(c_energy = NaN))
+        @test event_fingerprint(nan_event) != event_fingerprint(build_decay_event(c_energy = 1e300))
+
+        relabelled = build_decay_event(c_pdg = 321)
+        @test event_fingerprint(event; precision = 0) != event_fingerprint(relabelled; precision = 0)
+        @test !events_equal(event, relabelled; tolerance = 1.0)
+
+        # Same particles, but the decay is attached to b instead of a
+        moved = create_event(3)
+        beam = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+        a = make_shared_particle(5.0, 0.0, 60.0, 61.0, 23, 2)
+        b = make_shared_particle(-5.0, 0.0, 40.0, 39.0, 21, 1)
+        v1 = make_shared_vertex()
+        connect_particle_in(v1, beam)
+        connect_particle_out(v1, a)
+        connect_particle_out(v1, b)
+        attach_vertex_to_event(moved, v1)
+        v2 = make_shared_vertex()
+        connect_particle_in(v2, b)
+        connect_particle_out(v2, make_shared_particle(2.0, 1.0, 29.0, 30.0, 211, 1))
+        connect_particle_out(v2, make_shared_particle(3.0, -1.0, 31.0, 31.0, -211, 1))
+        attach_vertex_to_event(moved, v2)
+        @test event_fingerprint(event) != event_fingerprint(moved)
+        @test !events_equal(event, moved; tolerance = 1.0)
+    end
 end
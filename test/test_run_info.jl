@@ -22,4 +22,39 @@
             description = "hard process generator",
         )
     end
+
+    @testset "Bulk String Export" begin
+        event = create_event(315)
+        run_info = create_run_info()
+        names = ["MUR$(i)_MUF$(i)_PDF$(260000 + i)" for i in 1:1000]
+        push!(names, "")
+        push!(names, "αs=0.118")
+
+        set_weight_names!(run_info, names)
+        add_tool_info!(run_info, "Sherpa", "3.0.0", "")
+        set_run_info!(event, run_info)
+
+        @test get_weight_names(event) == names
+        @test get_weight_names(event) == names
+        @test get_weight_names(run_info) == names
+
+        # Handles to the same run info share one cached packed table
+        count = zeros(Int64, 1)
+        table = GC.@preserve count HepMC3.run_info_weight_names_table(get_run_info(event), pointer(count))
+        @test count[1] == length(names)
+        @test GC.@preserve(count, HepMC3.run_info_weight_names_table(run_info, pointer(count))) == table
+
+        tools = get_tool_infos(event)
+        @test tools == [(name = "Sherpa", version = "3.0.0", description = "")]
+
+        add_tool_info!(run_info, "Rivet", "4.0.1", "analysis")
+        @test length(get_tool_infos(event)) == 2
+        @test get_tool_infos(event)[2].name == "Rivet"
+
+        set_weight_names!(run_info, ["nominal"])
+        @test get_weight_names(event) == ["nominal"]
+
+        set_weight_names!(run_info, String[])
+        @test get_weight_names(event) == String[]
+    end
 end
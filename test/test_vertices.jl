@@ -55,4 +55,72 @@
         @test length(outgoing) == 3
         @test parent in incoming
     end
-end
\ No newline at end of file
+
+    @testset "Momentum Conservation" begin
+        # beam -> v1 -> (a, b) balances; a -> v2 -> (c, d) loses 1 GeV of energy
+        function build_checked_event(event_number_value)
+            event = create_event(event_number_value)
+            beam = make_shared_particle(0.0, 0.0, 100.0, 100.0, 2212, 4)
+            a = make_shared_particle(5.0, 0.0, 60.0, 61.0, 23, 2)
+            b = make_shared_particle(-5.0, 0.0, 40.0, 39.0, 21, 1)
+            c = make_shared_particle(2.0, 1.0, 29.0, 30.0, 211, 1)
+            d = make_shared_particle(3.0, -1.0, 31.0, 30.0, -211, 1)
+            v1 = make_shared_vertex()
+            connect_particle_in(v1, beam)
+            connect_particle_out(v1, a)
+            connect_particle_out(v1, b)
+            attach_vertex_to_event(event, v1)
+            v2 = make_shared_vertex()
+            connect_particle_in(v2, a)
+            connect_particle_out(v2, c)
+            connect_particle_out(v2, d)
+            attach_vertex_to_event(event, v2)
+            return event
+        end
+
+        event = build_checked_event(1)
+        result = check_momentum_conservation(event)
+        @test result.vertices == Int32[2]
+        @test size(result.residuals) == (4, 1)
+        @test result.residuals[:, 1] ≈ [0.0, 0.0, 0.0, 1.0]
+
+        @test isempty(check_momentum_conservation(event; tolerance = 0.05).vertices)
+        @test check_momentum_conservation(event; tolerance = 0.05, relative = false).vertices == Int32[2]
+
+        # Non-finite momenta fail whatever the tolerance
+        event = create_event(1)
+        a = make_shared_particle(5.0, 0.0, 60.0, 61.0, 23, 2)
+        c = make_shared_particle(NaN, 1.0, 29.0, 31.0, 211, 1)
+        d = make_shared_particle(3.0, -1.0, 31.0, 30.0, -211, 1)
+        vertex = make_shared_vertex()
+        connect_particle_in(vertex, a)
+        connect_particle_out(vertex, c)
+        connect_particle_out(vertex, d)
+        attach_vertex_to_event(event, vertex)
+        @test check_momentum_conservation(event).vertices == Int32[1]
+        @test check_momentum_conservation(event; tolerance = 1e300, relative = false).vertices == Int32[1]
+
+        filename = tempname() * ".hepmc3"
+        writer = HepMC3.create_writer_ascii(filename)
+        for i in 1:3
+            @test HepMC3.writer_write_event(writer, build_checked_event(i).cpp_object)
+        end
+        HepMC3.writer_close(writer)
+        HepMC3.delete_writer_ascii(writer)
+
+        summary = check_momentum_conservation(filename; max_records = 2)
+        @test summary.n_events == 3
+        @test summary.n_failed_events == 3
+        @test summary.n_failed_vertices == 3
+        @test summary.max_residual ≈ 1.0 / 61.0
+        @test summary.event_numbers == Int32[1, 2]
+        @test summary.vertices == Int32[2, 2]
+        @test summary.residuals[4, :] ≈ [1.0, 1.0]
+
+        @test check_momentum_conservation(filename; max_events = 1).n_events == 1
+        @test check_momentum_conservation(filename; tolerance = 0.05).n_failed_events == 0
+        rm(filename)
+
+        @test_throws ErrorException check_momentum_conservation("definitely_missing_file.hepmc3")
+    end
+end